@@ -0,0 +1,359 @@
+//////////////////////////////
+// BidirectionalSolver.cpp  //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "BidirectionalSolver.h"
+
+#include "Bitboard.h"
+#include "BitboardPuzzle.h"
+#include "EvaluationWorkspace.h"
+#include "HostSolver.h"
+#include "Path.h"
+#include "Puzzle.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// widest bitboard (in 64-bit words) used before falling back to the
+// one-directional search
+#define MAX_BITBOARD_WORDS 16
+
+namespace gws
+{
+	template <size_t NumWords>
+	struct BidirectionalSolver::HalfPathSet
+	{
+		size_t numMoves;
+		
+		// number of halves of this length that fit in the memory budget
+		size_t maxHalves;
+		
+		// visited points, traversed dot edges and meeting point of each half
+		std::vector<Bitboard<NumWords>> points;
+		std::vector<Bitboard<NumWords*2>> dotEdges;
+		std::vector<size_t> meetingPoints;
+		
+		// numMoves moves per half, from the end point to the meeting point
+		std::vector<char> moves;
+		
+		// (join key, half index) pairs sorted by key
+		std::vector<std::pair<uint64_t, size_t>> index;
+	};
+	
+	BidirectionalSolver::BidirectionalSolver(size_t maxHalfPathBytes, bool enablePruning)
+		: m_maxHalfPathBytes(maxHalfPathBytes),
+		  m_enablePruning(enablePruning),
+		  m_numNodes(0),
+		  m_numJoins(0),
+		  m_usedFallback(false)
+	{}
+	
+	BidirectionalSolver::~BidirectionalSolver() {}
+	
+	bool BidirectionalSolver::solvePuzzle(const Puzzle& puzzle, Path& path)
+	{
+		m_numNodes = 0;
+		m_numJoins = 0;
+		m_usedFallback = false;
+		
+		bool solutionFound;
+		if (BitboardPuzzle<1>::canHold(puzzle)) {
+			solutionFound = solveBitboard<1>(puzzle, path);
+		}
+		else if (BitboardPuzzle<2>::canHold(puzzle)) {
+			solutionFound = solveBitboard<2>(puzzle, path);
+		}
+		else if (BitboardPuzzle<4>::canHold(puzzle)) {
+			solutionFound = solveBitboard<4>(puzzle, path);
+		}
+		else if (BitboardPuzzle<8>::canHold(puzzle)) {
+			solutionFound = solveBitboard<8>(puzzle, path);
+		}
+		else if (BitboardPuzzle<MAX_BITBOARD_WORDS>::canHold(puzzle)) {
+			solutionFound = solveBitboard<MAX_BITBOARD_WORDS>(puzzle, path);
+		}
+		else {
+			solutionFound = solveWithFallback(puzzle, path);
+		}
+		
+		return solutionFound;
+	}
+	
+	size_t BidirectionalSolver::getNumNodes() const
+	{
+		return m_numNodes;
+	}
+	
+	size_t BidirectionalSolver::getNumJoins() const
+	{
+		return m_numJoins;
+	}
+	
+	bool BidirectionalSolver::usedFallback() const
+	{
+		return m_usedFallback;
+	}
+	
+	bool BidirectionalSolver::solveWithFallback(const Puzzle& puzzle, Path& path)
+	{
+		HostSolver solver(m_enablePruning, true);
+		bool solutionFound = solver.solvePuzzle(puzzle, path);
+		
+		m_numNodes += solver.getNumNodes();
+		m_usedFallback = true;
+		
+		return solutionFound;
+	}
+	
+	template <size_t NumWords>
+	bool BidirectionalSolver::solveBitboard(const Puzzle& puzzle, Path& path)
+	{
+		bool solutionFound = false;
+		
+		BitboardPuzzle<NumWords> board(puzzle);
+		EvaluationWorkspace workspace(puzzle);
+		HalfPathSet<NumWords> halves;
+		
+		char* moveData = new char[puzzle.getNumPoints()];
+		Path half(moveData, puzzle.getNumPoints());
+		
+		// a path visits each point at most once, so it has at most
+		// (number of points - 1) moves, and half length h covers paths of
+		// 2h and 2h + 1 moves
+		bool withinLimit = true;
+		bool halvesFound = true;
+		size_t numMoves = 0;
+		while (!solutionFound && withinLimit && halvesFound && numMoves*2 < puzzle.getNumPoints()) {
+			halves.numMoves = numMoves;
+			halves.maxHalves = m_maxHalfPathBytes/(sizeof(Bitboard<NumWords>) + sizeof(Bitboard<NumWords*2>) + sizeof(size_t) +
+			                                       sizeof(std::pair<uint64_t, size_t>) + numMoves);
+			halves.points.clear();
+			halves.dotEdges.clear();
+			halves.meetingPoints.clear();
+			halves.moves.clear();
+			halves.index.clear();
+			
+			// store every backward half of the current length
+			typename BitboardPuzzle<NumWords>::PointSet endPoints = board.getEndPoints();
+			typename BitboardPuzzle<NumWords>::PointSet visitedPoints;
+			typename BitboardPuzzle<NumWords>::EdgeSet visitedEdges;
+			size_t endIndex;
+			while (withinLimit && endPoints.popFirst(endIndex)) {
+				half.clear();
+				half.setStartPointIndex(endIndex);
+				withinLimit = collectHalves(board, halves, half, endIndex, visitedPoints, visitedEdges);
+			}
+			
+			if (withinLimit) {
+				std::sort(halves.index.begin(), halves.index.end());
+				
+				// longer halves can't exist if there are none of this length
+				halvesFound = !halves.points.empty();
+				
+				// join them with forward halves from every start point
+				typename BitboardPuzzle<NumWords>::PointSet startPoints = board.getStartPoints();
+				size_t startIndex;
+				while (!solutionFound && halvesFound && startPoints.popFirst(startIndex)) {
+					path.clear();
+					path.setStartPointIndex(startIndex);
+					
+					solutionFound = searchForward(puzzle, board, halves, workspace, path, startIndex, visitedPoints, visitedEdges);
+				}
+			}
+			
+			++numMoves;
+		}
+		
+		delete [] moveData;
+		
+		// the halves of a long path don't fit in memory, so search
+		// the long paths in one direction instead
+		if (!withinLimit) {
+			solutionFound = solveWithFallback(puzzle, path);
+		}
+		
+		return solutionFound;
+	}
+	
+	template <size_t NumWords>
+	bool BidirectionalSolver::collectHalves(const BitboardPuzzle<NumWords>& board, HalfPathSet<NumWords>& halves, Path& half,
+	                                        size_t headIndex, Bitboard<NumWords> visitedPoints, const Bitboard<NumWords*2>& visitedEdges)
+	{
+		bool withinLimit = true;
+		++m_numNodes;
+		
+		visitedPoints.set(headIndex);
+		
+		if (half.getNumMoves() == halves.numMoves) {
+			withinLimit = halves.points.size() < halves.maxHalves;
+			if (withinLimit) {
+				// index the half by the meeting point and the dots it covers
+				// (excluding the meeting point, which both halves visit)
+				Bitboard<NumWords> dotPoints = board.getDotPoints() & visitedPoints;
+				dotPoints.reset(headIndex);
+				Bitboard<NumWords*2> dotEdges = board.getDotEdges() & visitedEdges;
+				
+				halves.index.push_back(std::make_pair(getJoinKey(headIndex, dotPoints, dotEdges), halves.points.size()));
+				halves.points.push_back(visitedPoints);
+				halves.dotEdges.push_back(dotEdges);
+				halves.meetingPoints.push_back(headIndex);
+				for (size_t i = 0; i < half.getNumMoves(); ++i) {
+					halves.moves.push_back((char)half.getMove(i));
+				}
+			}
+		}
+		else {
+			// a path ends at the first end point it reaches, so a backward
+			// half can't pass through another one
+			Bitboard<NumWords> nextPoints = board.getNeighbors(headIndex).andNot(visitedPoints).andNot(board.getEndPoints());
+			size_t nextIndex;
+			while (withinLimit && nextPoints.popFirst(nextIndex)) {
+				MoveValue move = board.getMove(headIndex, nextIndex);
+				Bitboard<NumWords*2> nextEdges = visitedEdges;
+				nextEdges.set(board.getEdgeIndex(headIndex, move));
+				
+				if (!m_enablePruning || board.canCompletePath(visitedPoints, nextEdges, headIndex, nextIndex)) {
+					half.addMove(move);
+					withinLimit = collectHalves(board, halves, half, nextIndex, visitedPoints, nextEdges);
+					half.popMove();
+				}
+			}
+		}
+		
+		return withinLimit;
+	}
+	
+	template <size_t NumWords>
+	bool BidirectionalSolver::searchForward(const Puzzle& puzzle, const BitboardPuzzle<NumWords>& board, const HalfPathSet<NumWords>& halves,
+	                                        EvaluationWorkspace& workspace, Path& path,
+	                                        size_t headIndex, Bitboard<NumWords> visitedPoints, const Bitboard<NumWords*2>& visitedEdges)
+	{
+		bool solutionFound = false;
+		++m_numNodes;
+		
+		visitedPoints.set(headIndex);
+		
+		// forward halves are one move longer than backward halves for paths
+		// with an odd number of moves
+		if (path.getNumMoves() >= halves.numMoves) {
+			solutionFound = joinHalves(puzzle, board, halves, workspace, path, headIndex, visitedPoints, visitedEdges);
+		}
+		
+		if (!solutionFound && path.getNumMoves() <= halves.numMoves) {
+			// a forward half can only reach an end point if the backward half
+			// is just that end point
+			Bitboard<NumWords> nextPoints = board.getNeighbors(headIndex).andNot(visitedPoints);
+			if (halves.numMoves > 0) {
+				nextPoints = nextPoints.andNot(board.getEndPoints());
+			}
+			
+			size_t nextIndex;
+			while (!solutionFound && nextPoints.popFirst(nextIndex)) {
+				MoveValue move = board.getMove(headIndex, nextIndex);
+				Bitboard<NumWords*2> nextEdges = visitedEdges;
+				nextEdges.set(board.getEdgeIndex(headIndex, move));
+				
+				if (!m_enablePruning || board.canCompletePath(visitedPoints, nextEdges, headIndex, nextIndex)) {
+					path.addMove(move);
+					solutionFound = searchForward(puzzle, board, halves, workspace, path, nextIndex, visitedPoints, nextEdges);
+					if (!solutionFound) {
+						path.popMove();
+					}
+				}
+			}
+		}
+		
+		return solutionFound;
+	}
+	
+	template <size_t NumWords>
+	bool BidirectionalSolver::joinHalves(const Puzzle& puzzle, const BitboardPuzzle<NumWords>& board, const HalfPathSet<NumWords>& halves,
+	                                     EvaluationWorkspace& workspace, Path& path,
+	                                     size_t headIndex, const Bitboard<NumWords>& visitedPoints, const Bitboard<NumWords*2>& visitedEdges)
+	{
+		bool solutionFound = false;
+		
+		// the backward half must cover exactly the dots this half missed
+		// (it can't cover any of the others without crossing this half)
+		Bitboard<NumWords> missingDots = board.getDotPoints().andNot(visitedPoints);
+		Bitboard<NumWords*2> missingDotEdges = board.getDotEdges().andNot(visitedEdges);
+		uint64_t key = getJoinKey(headIndex, missingDots, missingDotEdges);
+		
+		auto candidate = std::lower_bound(halves.index.begin(), halves.index.end(), std::make_pair(key, (size_t)0));
+		while (!solutionFound && candidate != halves.index.end() && candidate->first == key) {
+			size_t i = candidate->second;
+			
+			// keys can collide, so compare the meeting point and dots too,
+			// and the halves may only share the meeting point
+			Bitboard<NumWords> halfDots = board.getDotPoints() & halves.points[i];
+			halfDots.reset(headIndex);
+			Bitboard<NumWords> sharedPoints = visitedPoints & halves.points[i];
+			sharedPoints.reset(headIndex);
+			if (halves.meetingPoints[i] == headIndex && halfDots == missingDots && halves.dotEdges[i] == missingDotEdges && sharedPoints.none()) {
+				// append the backward half in reverse
+				const char* moves = &halves.moves[i*halves.numMoves];
+				for (size_t j = halves.numMoves; j > 0; --j) {
+					path.addMove(getReverseMove((MoveValue)moves[j - 1]));
+				}
+				
+				++m_numJoins;
+				solutionFound = puzzle.evaluateSolution(path, board.getCompiledPuzzle(), workspace);
+				
+				if (!solutionFound) {
+					for (size_t j = 0; j < halves.numMoves; ++j) {
+						path.popMove();
+					}
+				}
+			}
+			
+			++candidate;
+		}
+		
+		return solutionFound;
+	}
+	
+	template <size_t NumWords>
+	uint64_t BidirectionalSolver::getJoinKey(size_t meetingIndex, const Bitboard<NumWords>& dotPoints, const Bitboard<NumWords*2>& dotEdges)
+	{
+		// multiply-xorshift mixing of every word
+		uint64_t key = (uint64_t)meetingIndex*0x9e3779b97f4a7c15ULL;
+		for (size_t i = 0; i < NumWords; ++i) {
+			key = (key ^ dotPoints.getWord(i))*0xbf58476d1ce4e5b9ULL;
+			key ^= key >> 31;
+		}
+		for (size_t i = 0; i < NumWords*2; ++i) {
+			key = (key ^ dotEdges.getWord(i))*0x94d049bb133111ebULL;
+			key ^= key >> 29;
+		}
+		
+		return key;
+	}
+	
+	MoveValue BidirectionalSolver::getReverseMove(MoveValue move)
+	{
+		MoveValue reverse;
+		switch (move) {
+			case MoveValue::UP:
+				reverse = MoveValue::DOWN;
+				break;
+			case MoveValue::DOWN:
+				reverse = MoveValue::UP;
+				break;
+			case MoveValue::LEFT:
+				reverse = MoveValue::RIGHT;
+				break;
+			case MoveValue::RIGHT:
+				reverse = MoveValue::LEFT;
+				break;
+			default:
+				reverse = MoveValue::NONE;
+				break;
+		}
+		
+		return reverse;
+	}
+}
\ No newline at end of file
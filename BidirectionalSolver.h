@@ -0,0 +1,176 @@
+//////////////////////////////
+// BidirectionalSolver.h    //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_BidirectionalSolver_h
+#define gws_BidirectionalSolver_h
+
+#include "Solver.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace gws
+{
+	class EvaluationWorkspace;
+	class Path;
+	class Puzzle;
+	enum class MoveValue : char;
+	
+	template <size_t NumWords> class Bitboard;
+	template <size_t NumWords> class BitboardPuzzle;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \class BidirectionalSolver
+	/// \brief Meet-in-the-middle puzzle solver that runs on the host CPU
+	/// 
+	/// Every path of n moves is split into a forward half of ceil(n/2) moves
+	/// grown from a start point and a backward half of floor(n/2) moves grown
+	/// from an end point, which share only their last point (the meeting
+	/// point). For each half length h, all backward halves of h moves are
+	/// stored and indexed by their meeting point and the dots they pass
+	/// through. Forward halves of h and h+1 moves then look up the backward
+	/// halves that cover exactly the dots they missed, and only disjoint
+	/// pairs are joined and checked as full solutions. Paths are tried in
+	/// order of increasing length, so the shortest solution is found first.
+	/// 
+	/// Each side only enumerates paths of half the length, so the search
+	/// effort is roughly the square root of a one-directional search on
+	/// long paths. The stored halves are limited to a fixed memory budget;
+	/// if a level needs more, or the puzzle is too large for the widest
+	/// bitboard, the solver falls back to the one-directional HostSolver.
+	///////////////////////////////////////////////////////////////////////////
+	class BidirectionalSolver : public Solver
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Initialize the solver
+		/// 
+		/// \param [in] maxHalfPathBytes the maximum number of bytes used to
+		/// store backward halves at once
+		/// \param [in] enablePruning true to stop growing halves that can no
+		/// longer pass through every dot, false to grow every half
+		///////////////////////////////////////////////////////////////////////
+		BidirectionalSolver(size_t maxHalfPathBytes, bool enablePruning = true);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Virtual destructor
+		///////////////////////////////////////////////////////////////////////
+		virtual ~BidirectionalSolver();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \copydoc Solver::solvePuzzle()
+		///////////////////////////////////////////////////////////////////////
+		virtual bool solvePuzzle(const Puzzle& puzzle, Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of search nodes visited by the last solve
+		/// 
+		/// \returns the number of half paths extended in both directions
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumNodes() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of joined paths checked by the last solve
+		/// 
+		/// \returns the number of full solution checks
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumJoins() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if the last solve fell back to a one-directional
+		/// search
+		/// 
+		/// \returns true if the half path limit was exceeded
+		///////////////////////////////////////////////////////////////////////
+		bool usedFallback() const;
+		
+	private:
+		///////////////////////////////////////////////////////////////////////
+		/// \struct HalfPathSet
+		/// \brief All backward halves with the same number of moves
+		///////////////////////////////////////////////////////////////////////
+		template <size_t NumWords>
+		struct HalfPathSet;
+		
+		size_t m_maxHalfPathBytes;
+		bool m_enablePruning;
+		
+		size_t m_numNodes;
+		size_t m_numJoins;
+		bool m_usedFallback;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Solve a puzzle with the one-directional host search
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [out] path the solution, if one is found
+		/// 
+		/// \returns true if the puzzle was solved, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool solveWithFallback(const Puzzle& puzzle, Path& path);
+		
+		template <size_t NumWords>
+		bool solveBitboard(const Puzzle& puzzle, Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Grow backward halves from an end point and store every
+		/// half with the target number of moves
+		/// 
+		/// \returns false if the half path limit was exceeded
+		///////////////////////////////////////////////////////////////////////
+		template <size_t NumWords>
+		bool collectHalves(const BitboardPuzzle<NumWords>& board, HalfPathSet<NumWords>& halves, Path& half,
+		                   size_t headIndex, Bitboard<NumWords> visitedPoints, const Bitboard<NumWords*2>& visitedEdges);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Grow forward halves from a start point and join the halves
+		/// with the target number of moves (or one more) to stored halves
+		/// 
+		/// \returns true if a joined path solves the puzzle
+		///////////////////////////////////////////////////////////////////////
+		template <size_t NumWords>
+		bool searchForward(const Puzzle& puzzle, const BitboardPuzzle<NumWords>& board, const HalfPathSet<NumWords>& halves,
+		                   EvaluationWorkspace& workspace, Path& path,
+		                   size_t headIndex, Bitboard<NumWords> visitedPoints, const Bitboard<NumWords*2>& visitedEdges);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Try to complete a forward half with every compatible stored
+		/// backward half
+		/// 
+		/// \returns true if a joined path solves the puzzle (the path is left
+		/// holding the full solution)
+		///////////////////////////////////////////////////////////////////////
+		template <size_t NumWords>
+		bool joinHalves(const Puzzle& puzzle, const BitboardPuzzle<NumWords>& board, const HalfPathSet<NumWords>& halves,
+		                EvaluationWorkspace& workspace, Path& path,
+		                size_t headIndex, const Bitboard<NumWords>& visitedPoints, const Bitboard<NumWords*2>& visitedEdges);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the index key of a backward half
+		/// 
+		/// \param [in] meetingIndex the meeting point
+		/// \param [in] dotPoints the dot points of the half (excluding the
+		/// meeting point)
+		/// \param [in] dotEdges the dot edges of the half
+		/// 
+		/// \returns the key
+		///////////////////////////////////////////////////////////////////////
+		template <size_t NumWords>
+		static uint64_t getJoinKey(size_t meetingIndex, const Bitboard<NumWords>& dotPoints, const Bitboard<NumWords*2>& dotEdges);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the move that undoes another move
+		/// 
+		/// \param [in] move the move
+		/// 
+		/// \returns the move in the opposite direction
+		///////////////////////////////////////////////////////////////////////
+		static MoveValue getReverseMove(MoveValue move);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,225 @@
+//////////////////////////////
+// Bitboard.h               //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_Bitboard_h
+#define gws_Bitboard_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace gws
+{
+	///////////////////////////////////////////////////////////////////////////
+	/// \class Bitboard
+	/// \brief Fixed-size set of puzzle element indices stored as 64-bit words
+	/// 
+	/// Bit i of the set is stored in bit (i % 64) of word (i / 64). A single
+	/// word covers puzzles with up to 64 points (8x8), and wider boards are
+	/// used for larger puzzles.
+	/// 
+	/// \tparam NumWords the number of 64-bit words in the set
+	///////////////////////////////////////////////////////////////////////////
+	template <size_t NumWords>
+	class Bitboard
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of indices the set can hold
+		/// 
+		/// \returns the number of bits in the set
+		///////////////////////////////////////////////////////////////////////
+		static size_t getCapacity()
+		{
+			return NumWords*64;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Initialize an empty set
+		///////////////////////////////////////////////////////////////////////
+		Bitboard()
+		{
+			clear();
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Remove all indices from the set
+		///////////////////////////////////////////////////////////////////////
+		void clear()
+		{
+			for (size_t i = 0; i < NumWords; ++i) {
+				m_words[i] = 0;
+			}
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Add an index to the set
+		/// 
+		/// \param [in] index the index (in range [0..getCapacity()-1])
+		///////////////////////////////////////////////////////////////////////
+		void set(size_t index)
+		{
+			m_words[index/64] |= (uint64_t)1 << (index%64);
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Remove an index from the set
+		/// 
+		/// \param [in] index the index (in range [0..getCapacity()-1])
+		///////////////////////////////////////////////////////////////////////
+		void reset(size_t index)
+		{
+			m_words[index/64] &= ~((uint64_t)1 << (index%64));
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if an index is in the set
+		/// 
+		/// \param [in] index the index (in range [0..getCapacity()-1])
+		/// 
+		/// \returns true if the index is in the set, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool test(size_t index) const
+		{
+			return (m_words[index/64] >> (index%64)) & 1;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if the set is empty
+		/// 
+		/// \returns true if no index is in the set, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool none() const
+		{
+			uint64_t bits = 0;
+			for (size_t i = 0; i < NumWords; ++i) {
+				bits |= m_words[i];
+			}
+			
+			return bits == 0;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of indices in the set
+		/// 
+		/// \returns the size of the set
+		///////////////////////////////////////////////////////////////////////
+		size_t count() const
+		{
+			size_t total = 0;
+			for (size_t i = 0; i < NumWords; ++i) {
+				total += __builtin_popcountll(m_words[i]);
+			}
+			
+			return total;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Remove the smallest index from the set
+		/// 
+		/// \param [out] index the removed index
+		/// 
+		/// \returns true if an index was removed, false if the set is empty
+		///////////////////////////////////////////////////////////////////////
+		bool popFirst(size_t& index)
+		{
+			for (size_t i = 0; i < NumWords; ++i) {
+				if (m_words[i] != 0) {
+					index = i*64 + __builtin_ctzll(m_words[i]);
+					m_words[i] &= m_words[i] - 1;
+					return true;
+				}
+			}
+			
+			return false;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the indices in this set that are not in another set
+		/// 
+		/// \param [in] other the other set
+		/// 
+		/// \returns the set difference
+		///////////////////////////////////////////////////////////////////////
+		Bitboard andNot(const Bitboard& other) const
+		{
+			Bitboard result;
+			for (size_t i = 0; i < NumWords; ++i) {
+				result.m_words[i] = m_words[i] & ~other.m_words[i];
+			}
+			
+			return result;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the indices that are in both sets
+		/// 
+		/// \param [in] other the other set
+		/// 
+		/// \returns the set intersection
+		///////////////////////////////////////////////////////////////////////
+		Bitboard operator&(const Bitboard& other) const
+		{
+			Bitboard result;
+			for (size_t i = 0; i < NumWords; ++i) {
+				result.m_words[i] = m_words[i] & other.m_words[i];
+			}
+			
+			return result;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the indices that are in either set
+		/// 
+		/// \param [in] other the other set
+		/// 
+		/// \returns the set union
+		///////////////////////////////////////////////////////////////////////
+		Bitboard operator|(const Bitboard& other) const
+		{
+			Bitboard result;
+			for (size_t i = 0; i < NumWords; ++i) {
+				result.m_words[i] = m_words[i] | other.m_words[i];
+			}
+			
+			return result;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if two sets contain the same indices
+		/// 
+		/// \param [in] other the other set
+		/// 
+		/// \returns true if the sets are equal, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool operator==(const Bitboard& other) const
+		{
+			uint64_t diff = 0;
+			for (size_t i = 0; i < NumWords; ++i) {
+				diff |= m_words[i] ^ other.m_words[i];
+			}
+			
+			return diff == 0;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get one 64-bit word of the set
+		/// 
+		/// \param [in] index the word index (in range [0..NumWords-1])
+		/// 
+		/// \returns the word
+		///////////////////////////////////////////////////////////////////////
+		uint64_t getWord(size_t index) const
+		{
+			return m_words[index];
+		}
+		
+	private:
+		uint64_t m_words[NumWords];
+	};
+}
+
+#endif
\ No newline at end of file
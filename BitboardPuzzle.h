@@ -0,0 +1,309 @@
+//////////////////////////////
+// BitboardPuzzle.h         //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_BitboardPuzzle_h
+#define gws_BitboardPuzzle_h
+
+#include "Bitboard.h"
+#include "CompiledPuzzle.h"
+#include "Path.h"
+#include "Puzzle.h"
+
+#include <stddef.h>
+#include <vector>
+
+namespace gws
+{
+	///////////////////////////////////////////////////////////////////////////
+	/// \class BitboardPuzzle
+	/// \brief Puzzle compiled into bitboards for fast path searches
+	/// 
+	/// Point sets are indexed the same way as Puzzle points, and edge sets
+	/// are indexed the same way as Puzzle edges. Every point also has a set
+	/// of the neighboring points it can move to (built from the puzzle's
+	/// CompiledPuzzle move tables, so blocked points and edges are already
+	/// excluded), and the valid moves from a point are a single set
+	/// difference with the visited points.
+	/// 
+	/// \tparam NumWords the number of 64-bit words in each point set (edge
+	/// sets use twice as many words)
+	///////////////////////////////////////////////////////////////////////////
+	template <size_t NumWords>
+	class BitboardPuzzle
+	{
+	public:
+		typedef Bitboard<NumWords> PointSet;
+		typedef Bitboard<NumWords*2> EdgeSet;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a puzzle fits in this bitboard size
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// 
+		/// \returns true if all points and edges can be indexed
+		///////////////////////////////////////////////////////////////////////
+		static bool canHold(const Puzzle& puzzle)
+		{
+			return puzzle.getNumPoints() <= PointSet::getCapacity()
+			    && puzzle.getNumEdges() <= EdgeSet::getCapacity();
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Compile a puzzle into bitboards
+		/// 
+		/// \param [in] puzzle the puzzle (must satisfy canHold())
+		///////////////////////////////////////////////////////////////////////
+		BitboardPuzzle(const Puzzle& puzzle)
+			: m_width(puzzle.getWidth()),
+			  m_compiled(puzzle),
+			  m_neighbors(puzzle.getNumPoints()),
+			  m_incidentEdges(puzzle.getNumPoints())
+		{
+			for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
+				switch (puzzle.getPointValue(i)) {
+					case PointValue::DOT:
+						m_dotPoints.set(i);
+						break;
+					case PointValue::START:
+						m_startPoints.set(i);
+						break;
+					case PointValue::END:
+						m_endPoints.set(i);
+						break;
+					default:
+						break;
+				}
+			}
+			
+			for (size_t i = 0; i < puzzle.getNumEdges(); ++i) {
+				if (puzzle.getEdgeValue(i) == EdgeValue::DOT) {
+					m_dotEdges.set(i);
+				}
+			}
+			
+			// build neighbor sets from the valid moves of each point
+			for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
+				const CompiledPuzzle::Neighbor* neighbors = m_compiled.getNeighbors(i);
+				for (size_t j = 0; j < m_compiled.getNumNeighbors(i); ++j) {
+					m_neighbors[i].set(neighbors[j].pointIndex);
+					m_incidentEdges[i].set(neighbors[j].edgeIndex);
+				}
+			}
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the move tables the bitboards were built from
+		/// 
+		/// \returns the compiled puzzle
+		///////////////////////////////////////////////////////////////////////
+		const CompiledPuzzle& getCompiledPuzzle() const
+		{
+			return m_compiled;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the start points of the puzzle
+		/// 
+		/// \returns the set of start points
+		///////////////////////////////////////////////////////////////////////
+		const PointSet& getStartPoints() const
+		{
+			return m_startPoints;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the end points of the puzzle
+		/// 
+		/// \returns the set of end points
+		///////////////////////////////////////////////////////////////////////
+		const PointSet& getEndPoints() const
+		{
+			return m_endPoints;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the points containing dots
+		/// 
+		/// \returns the set of dot points
+		///////////////////////////////////////////////////////////////////////
+		const PointSet& getDotPoints() const
+		{
+			return m_dotPoints;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the edges containing dots
+		/// 
+		/// \returns the set of dot edges
+		///////////////////////////////////////////////////////////////////////
+		const EdgeSet& getDotEdges() const
+		{
+			return m_dotEdges;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the points that can be moved to from a point
+		/// 
+		/// \param [in] index the point index
+		/// 
+		/// \returns the set of neighboring points
+		///////////////////////////////////////////////////////////////////////
+		const PointSet& getNeighbors(size_t index) const
+		{
+			return m_neighbors[index];
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the edges that can be traversed from a point
+		/// 
+		/// \param [in] index the point index
+		/// 
+		/// \returns the set of edges touching the point
+		///////////////////////////////////////////////////////////////////////
+		const EdgeSet& getIncidentEdges(size_t index) const
+		{
+			return m_incidentEdges[index];
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the point reached by a move
+		/// 
+		/// \param [in] index the current point index
+		/// \param [in] move the move direction
+		/// 
+		/// \returns the destination point index, or the number of points if
+		/// the move is not valid
+		///////////////////////////////////////////////////////////////////////
+		size_t getNeighborIndex(size_t index, MoveValue move) const
+		{
+			return m_compiled.getNeighborIndex(index, move);
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the move between two neighboring points
+		/// 
+		/// \param [in] from the current point index
+		/// \param [in] to the destination point index
+		/// 
+		/// \returns the move direction
+		///////////////////////////////////////////////////////////////////////
+		MoveValue getMove(size_t from, size_t to) const
+		{
+			MoveValue move;
+			if (to + m_width == from) {
+				move = MoveValue::UP;
+			}
+			else if (from + m_width == to) {
+				move = MoveValue::DOWN;
+			}
+			else if (to + 1 == from) {
+				move = MoveValue::LEFT;
+			}
+			else {
+				move = MoveValue::RIGHT;
+			}
+			
+			return move;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the edge traversed by a move
+		/// 
+		/// \param [in] index the current point index
+		/// \param [in] move the move direction (must be valid)
+		/// 
+		/// \returns the edge index
+		///////////////////////////////////////////////////////////////////////
+		size_t getEdgeIndex(size_t index, MoveValue move) const
+		{
+			return m_compiled.getEdgeIndex(index, move);
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a partial path can still pass through every dot
+		/// after moving the head of the path to a new point
+		/// 
+		/// Only dots next to the previous point are checked, since that point
+		/// can never be visited again. The check also holds for a partial
+		/// path grown backwards from an end point.
+		/// 
+		/// \param [in] visitedPoints the points of the partial path
+		/// \param [in] visitedEdges the edges of the partial path
+		/// \param [in] prevIndex the point the head moved from
+		/// \param [in] headIndex the current head of the path
+		/// 
+		/// \returns false if a dot can no longer be reached, true otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool canCompletePath(const PointSet& visitedPoints, const EdgeSet& visitedEdges, size_t prevIndex, size_t headIndex) const
+		{
+			// any dot edge touching the previous point that wasn't traversed
+			// is lost
+			bool canComplete = (m_incidentEdges[prevIndex] & m_dotEdges).andNot(visitedEdges).none();
+			
+			// any dot next to the previous point must still have two unvisited
+			// neighbors (the head of the path counts as unvisited here) to
+			// enter and leave through
+			PointSet dots = (m_neighbors[prevIndex] & m_dotPoints).andNot(visitedPoints);
+			size_t dotIndex;
+			while (canComplete && dots.popFirst(dotIndex)) {
+				canComplete = dotIndex == headIndex || m_neighbors[dotIndex].andNot(visitedPoints).count() >= 2;
+			}
+			
+			return canComplete;
+		}
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if the unvisited points the head of a partial path
+		/// can still reach contain an end point and every remaining dot
+		/// 
+		/// The reachable points are found with a flood fill from the head,
+		/// so this catches a path that has cut the puzzle in two, which the
+		/// neighbor checks in canCompletePath() can't see.
+		/// 
+		/// \param [in] visitedPoints the points of the partial path
+		/// (including the head)
+		/// \param [in] visitedEdges the edges of the partial path
+		/// \param [in] headIndex the current head of the path
+		/// 
+		/// \returns false if an end point or a dot can no longer be reached,
+		/// true otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool canReachGoal(const PointSet& visitedPoints, const EdgeSet& visitedEdges, size_t headIndex) const
+		{
+			PointSet reachedPoints;
+			EdgeSet reachedEdges;
+			reachedPoints.set(headIndex);
+			
+			PointSet frontier = reachedPoints;
+			size_t index;
+			while (frontier.popFirst(index)) {
+				reachedEdges = reachedEdges | m_incidentEdges[index];
+				PointSet nextPoints = m_neighbors[index].andNot(visitedPoints).andNot(reachedPoints);
+				reachedPoints = reachedPoints | nextPoints;
+				frontier = frontier | nextPoints;
+			}
+			
+			return !(reachedPoints & m_endPoints).none()
+			    && m_dotPoints.andNot(visitedPoints).andNot(reachedPoints).none()
+			    && m_dotEdges.andNot(visitedEdges).andNot(reachedEdges).none();
+		}
+		
+	private:
+		size_t m_width;
+		CompiledPuzzle m_compiled;
+		
+		PointSet m_startPoints;
+		PointSet m_endPoints;
+		PointSet m_dotPoints;
+		EdgeSet m_dotEdges;
+		
+		std::vector<PointSet> m_neighbors;
+		std::vector<EdgeSet> m_incidentEdges;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+//////////////////////////////
+// BufferPool.cpp           //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "BufferPool.h"
+
+// smallest bucket size in bytes (so tiny puzzle buffers share one bucket)
+#define MIN_BUCKET_SIZE 256
+
+namespace gws
+{
+	BufferPool::BufferPool(cl_context context)
+		: m_context(context)
+	{
+	}
+	
+	BufferPool::~BufferPool()
+	{
+		for (auto bucket = m_released.begin(); bucket != m_released.end(); ++bucket) {
+			for (size_t i = 0; i < bucket->second.size(); ++i) {
+				clReleaseMemObject(bucket->second[i]);
+			}
+		}
+	}
+	
+	cl_mem BufferPool::acquire(cl_mem_flags flags, size_t size, cl_int* errNum)
+	{
+		Bucket bucket(flags, getBucketSize(size));
+		cl_mem buffer;
+		auto released = m_released.find(bucket);
+		if (released != m_released.end() && !released->second.empty()) {
+			buffer = released->second.back();
+			released->second.pop_back();
+			*errNum = CL_SUCCESS;
+		}
+		else {
+			buffer = clCreateBuffer(m_context, flags, bucket.second, NULL, errNum);
+			if (*errNum != CL_SUCCESS) {
+				return 0;
+			}
+		}
+		
+		m_acquired[buffer] = bucket;
+		
+		return buffer;
+	}
+	
+	void BufferPool::release(cl_mem buffer)
+	{
+		auto acquired = m_acquired.find(buffer);
+		if (acquired != m_acquired.end()) {
+			m_released[acquired->second].push_back(buffer);
+			m_acquired.erase(acquired);
+		}
+	}
+	
+	size_t BufferPool::getBucketSize(size_t size)
+	{
+		size_t bucketSize = MIN_BUCKET_SIZE;
+		while (bucketSize < size) {
+			bucketSize *= 2;
+		}
+		
+		return bucketSize;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+//////////////////////////////
+// BufferPool.h             //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_BufferPool_h
+#define gws_BufferPool_h
+
+#ifdef __APPLE__
+	#include <OpenCL/cl.h>
+#else
+	#include <CL/cl.h>
+#endif
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace gws
+{
+	///////////////////////////////////////////////////////////////////////////
+	/// \class BufferPool
+	/// \brief Reuses the OpenCL buffers of one context across requests of
+	/// different sizes
+	/// 
+	/// Buffers are allocated in power of two size buckets, so a request is
+	/// served by any released buffer of the same bucket and access flags, and
+	/// a solver switching between puzzle sizes only allocates device memory
+	/// for sizes it hasn't used yet. Released buffers are kept until the pool
+	/// is destroyed.
+	///////////////////////////////////////////////////////////////////////////
+	class BufferPool
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Create an empty pool
+		/// 
+		/// \param [in] context the context buffers are created in
+		///////////////////////////////////////////////////////////////////////
+		BufferPool(cl_context context);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Release every buffer in the pool (buffers that are still
+		/// acquired are owned by the caller)
+		///////////////////////////////////////////////////////////////////////
+		~BufferPool();
+		
+		// prevent creating copies of the pool
+		BufferPool(const BufferPool& other) = delete;
+		BufferPool& operator=(const BufferPool& other) = delete;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get a buffer of at least the given size (reusing a
+		/// released buffer of the same bucket if there is one)
+		/// 
+		/// \param [in] flags the buffer's access flags
+		/// \param [in] size the number of bytes needed
+		/// \param [out] errNum the result of creating a new buffer
+		/// (CL_SUCCESS if a buffer was reused)
+		/// 
+		/// \returns the buffer (0 if it couldn't be created)
+		///////////////////////////////////////////////////////////////////////
+		cl_mem acquire(cl_mem_flags flags, size_t size, cl_int* errNum);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Return an acquired buffer to the pool
+		/// 
+		/// \param [in] buffer the buffer (ignored if it wasn't acquired from the
+		/// pool)
+		///////////////////////////////////////////////////////////////////////
+		void release(cl_mem buffer);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the size of the bucket holding requests of a given size
+		/// 
+		/// \param [in] size the number of bytes needed
+		/// 
+		/// \returns the smallest power of two of at least the size (and at
+		/// least MIN_BUCKET_SIZE)
+		///////////////////////////////////////////////////////////////////////
+		static size_t getBucketSize(size_t size);
+		
+	private:
+		typedef std::pair<cl_mem_flags, size_t> Bucket;
+		
+		cl_context m_context;
+		std::map<Bucket, std::vector<cl_mem>> m_released;
+		std::map<cl_mem, Bucket> m_acquired;
+	};
+}
+
+#endif
\ No newline at end of file
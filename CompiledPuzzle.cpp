@@ -0,0 +1,116 @@
+//////////////////////////////
+// CompiledPuzzle.cpp       //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "CompiledPuzzle.h"
+
+#include "Path.h"
+#include "Puzzle.h"
+
+namespace gws
+{
+	CompiledPuzzle::CompiledPuzzle(const Puzzle& puzzle)
+		: m_numPoints(puzzle.getNumPoints()),
+		  m_neighbors(puzzle.getNumPoints()*NUM_DIRECTIONS),
+		  m_numNeighbors(puzzle.getNumPoints(), 0),
+		  m_moves(puzzle.getNumPoints()*NUM_DIRECTIONS)
+	{
+		// every move starts out invalid
+		for (size_t i = 0; i < m_moves.size(); ++i) {
+			m_moves[i].pointIndex = m_numPoints;
+			m_moves[i].edgeIndex = 0;
+			m_moves[i].move = MoveValue::NONE;
+		}
+		
+		// add the moves that don't leave the grid (neighbors are added in
+		// the same order the host search tries moves)
+		for (size_t row = 0; row < puzzle.getHeight(); ++row) {
+			for (size_t col = 0; col < puzzle.getWidth(); ++col) {
+				size_t index = puzzle.getPointIndex(row, col);
+				if (puzzle.getPointValue(index) != PointValue::BLOCKED) {
+					if (row > 0) {
+						addNeighbor(puzzle, index, UP, MoveValue::UP, puzzle.getPointIndex(row - 1, col), puzzle.getEdgeIndex(row - 1, col, row, col));
+					}
+					if (row < puzzle.getHeight() - 1) {
+						addNeighbor(puzzle, index, DOWN, MoveValue::DOWN, puzzle.getPointIndex(row + 1, col), puzzle.getEdgeIndex(row, col, row + 1, col));
+					}
+					if (col > 0) {
+						addNeighbor(puzzle, index, LEFT, MoveValue::LEFT, puzzle.getPointIndex(row, col - 1), puzzle.getEdgeIndex(row, col - 1, row, col));
+					}
+					if (col < puzzle.getWidth() - 1) {
+						addNeighbor(puzzle, index, RIGHT, MoveValue::RIGHT, puzzle.getPointIndex(row, col + 1), puzzle.getEdgeIndex(row, col, row, col + 1));
+					}
+				}
+			}
+		}
+	}
+	
+	size_t CompiledPuzzle::getNumPoints() const
+	{
+		return m_numPoints;
+	}
+	
+	size_t CompiledPuzzle::getNumNeighbors(size_t index) const
+	{
+		return m_numNeighbors[index];
+	}
+	
+	const CompiledPuzzle::Neighbor* CompiledPuzzle::getNeighbors(size_t index) const
+	{
+		return &m_neighbors[index*NUM_DIRECTIONS];
+	}
+	
+	size_t CompiledPuzzle::getNeighborIndex(size_t index, MoveValue move) const
+	{
+		size_t direction = getDirection(move);
+		
+		return direction < NUM_DIRECTIONS ? m_moves[index*NUM_DIRECTIONS + direction].pointIndex : m_numPoints;
+	}
+	
+	size_t CompiledPuzzle::getEdgeIndex(size_t index, MoveValue move) const
+	{
+		return m_moves[index*NUM_DIRECTIONS + getDirection(move)].edgeIndex;
+	}
+	
+	size_t CompiledPuzzle::getDirection(MoveValue move)
+	{
+		size_t direction;
+		switch (move) {
+			case MoveValue::UP:
+				direction = UP;
+				break;
+			case MoveValue::DOWN:
+				direction = DOWN;
+				break;
+			case MoveValue::LEFT:
+				direction = LEFT;
+				break;
+			case MoveValue::RIGHT:
+				direction = RIGHT;
+				break;
+			default:
+				direction = NUM_DIRECTIONS;
+				break;
+		}
+		
+		return direction;
+	}
+	
+	void CompiledPuzzle::addNeighbor(const Puzzle& puzzle, size_t index, Direction direction, MoveValue move, size_t neighbor, size_t edge)
+	{
+		// a move is valid if neither the edge nor the destination is blocked
+		if (puzzle.getPointValue(neighbor) != PointValue::BLOCKED && puzzle.getEdgeValue(edge) != EdgeValue::BLOCKED) {
+			Neighbor entry;
+			entry.pointIndex = (unsigned int)neighbor;
+			entry.edgeIndex = (unsigned int)edge;
+			entry.move = move;
+			
+			m_moves[index*NUM_DIRECTIONS + direction] = entry;
+			m_neighbors[index*NUM_DIRECTIONS + m_numNeighbors[index]] = entry;
+			++m_numNeighbors[index];
+		}
+	}
+}
\ No newline at end of file
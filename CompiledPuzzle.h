@@ -0,0 +1,125 @@
+//////////////////////////////
+// CompiledPuzzle.h         //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_CompiledPuzzle_h
+#define gws_CompiledPuzzle_h
+
+#include <stddef.h>
+#include <vector>
+
+namespace gws
+{
+	class Puzzle;
+	enum class MoveValue : char;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \class CompiledPuzzle
+	/// \brief Per-point move tables compiled once from a Puzzle
+	/// 
+	/// Every point has a dense list of the moves that can be made from it
+	/// (in up, down, left, right order), each with the destination point and
+	/// the traversed edge. Moves off the grid, through blocked edges or onto
+	/// blocked points are already filtered out, so walking a path or
+	/// generating moves needs no bounds checks or index calculations. The
+	/// same moves are also indexed by direction for following an existing
+	/// path.
+	///////////////////////////////////////////////////////////////////////////
+	class CompiledPuzzle
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \struct Neighbor
+		/// \brief A valid move from a point
+		///////////////////////////////////////////////////////////////////////
+		struct Neighbor
+		{
+			unsigned int pointIndex;
+			unsigned int edgeIndex;
+			MoveValue move;
+		};
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Compile the move tables of a puzzle
+		/// 
+		/// \param [in] puzzle the puzzle
+		///////////////////////////////////////////////////////////////////////
+		explicit CompiledPuzzle(const Puzzle& puzzle);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of points in the compiled puzzle
+		/// 
+		/// \returns the number of points
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumPoints() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of valid moves from a point
+		/// 
+		/// \param [in] index the point index
+		/// 
+		/// \returns the number of neighbors (at most 4)
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumNeighbors(size_t index) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the valid moves from a point
+		/// 
+		/// \param [in] index the point index
+		/// 
+		/// \returns the first of getNumNeighbors() neighbors
+		///////////////////////////////////////////////////////////////////////
+		const Neighbor* getNeighbors(size_t index) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the point reached by a move
+		/// 
+		/// \param [in] index the current point index
+		/// \param [in] move the move direction
+		/// 
+		/// \returns the destination point index, or the number of points if
+		/// the move is not valid
+		///////////////////////////////////////////////////////////////////////
+		size_t getNeighborIndex(size_t index, MoveValue move) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the edge traversed by a move
+		/// 
+		/// \param [in] index the current point index
+		/// \param [in] move the move direction (must be valid)
+		/// 
+		/// \returns the edge index
+		///////////////////////////////////////////////////////////////////////
+		size_t getEdgeIndex(size_t index, MoveValue move) const;
+		
+	private:
+		enum Direction
+		{
+			UP = 0,
+			DOWN,
+			LEFT,
+			RIGHT,
+			NUM_DIRECTIONS
+		};
+		
+		size_t m_numPoints;
+		
+		// NUM_DIRECTIONS entries per point (only the first m_numNeighbors
+		// entries of each point are valid)
+		std::vector<Neighbor> m_neighbors;
+		std::vector<unsigned char> m_numNeighbors;
+		
+		// NUM_DIRECTIONS entries per point, indexed by direction (invalid
+		// moves lead to the number of points)
+		std::vector<Neighbor> m_moves;
+		
+		static size_t getDirection(MoveValue move);
+		
+		void addNeighbor(const Puzzle& puzzle, size_t index, Direction direction, MoveValue move, size_t neighbor, size_t edge);
+	};
+}
+
+#endif
\ No newline at end of file
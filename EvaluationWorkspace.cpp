@@ -0,0 +1,70 @@
+//////////////////////////////
+// EvaluationWorkspace.cpp  //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "EvaluationWorkspace.h"
+
+#include "Puzzle.h"
+
+#include <cstring>
+
+namespace gws
+{
+	EvaluationWorkspace::EvaluationWorkspace(const Puzzle& puzzle)
+		: EvaluationWorkspace(puzzle.getWidth(), puzzle.getHeight())
+	{}
+	
+	EvaluationWorkspace::EvaluationWorkspace(size_t width, size_t height)
+		: m_numPoints(Puzzle::getNumPoints(width, height)),
+		  m_numEdges(Puzzle::getNumEdges(width, height)),
+		  m_numSpaces(Puzzle::getNumSpaces(width, height)),
+		  m_generation(0)
+	{
+		m_pointStamps = new unsigned int[m_numPoints];
+		m_edgeStamps = new unsigned int[m_numEdges];
+		m_spaceStamps = new unsigned int[m_numSpaces];
+		
+		m_whitePartitions = new bool[m_numSpaces];
+		m_blackPartitions = new bool[m_numSpaces];
+		m_searchStack = new size_t[m_numSpaces];
+		
+		// generation 0 is never used, so every element starts unmarked
+		memset(m_pointStamps, 0, sizeof(unsigned int)*m_numPoints);
+		memset(m_edgeStamps, 0, sizeof(unsigned int)*m_numEdges);
+		memset(m_spaceStamps, 0, sizeof(unsigned int)*m_numSpaces);
+	}
+	
+	EvaluationWorkspace::~EvaluationWorkspace()
+	{
+		delete [] m_pointStamps;
+		delete [] m_edgeStamps;
+		delete [] m_spaceStamps;
+		
+		delete [] m_whitePartitions;
+		delete [] m_blackPartitions;
+		delete [] m_searchStack;
+	}
+	
+	bool EvaluationWorkspace::canHold(const Puzzle& puzzle) const
+	{
+		return puzzle.getNumPoints() <= m_numPoints
+		    && puzzle.getNumEdges() <= m_numEdges
+		    && puzzle.getNumSpaces() <= m_numSpaces;
+	}
+	
+	void EvaluationWorkspace::nextGeneration()
+	{
+		++m_generation;
+		
+		// clear stamps when the counter wraps around so old marks can't match
+		if (m_generation == 0) {
+			memset(m_pointStamps, 0, sizeof(unsigned int)*m_numPoints);
+			memset(m_edgeStamps, 0, sizeof(unsigned int)*m_numEdges);
+			memset(m_spaceStamps, 0, sizeof(unsigned int)*m_numSpaces);
+			m_generation = 1;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+//////////////////////////////
+// EvaluationWorkspace.h    //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_EvaluationWorkspace_h
+#define gws_EvaluationWorkspace_h
+
+#include <stddef.h>
+
+namespace gws
+{
+	class Puzzle;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \class EvaluationWorkspace
+	/// \brief Reusable scratch memory for Puzzle::evaluateSolution()
+	/// 
+	/// All scratch arrays are allocated once when the workspace is created.
+	/// Visited points, edges and spaces are marked with the current
+	/// generation number, so starting a new evaluation only increments the
+	/// generation instead of clearing every array. A workspace must not be
+	/// shared between threads.
+	///////////////////////////////////////////////////////////////////////////
+	class EvaluationWorkspace
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Allocate a workspace for puzzles with the same dimensions as
+		/// a given puzzle
+		/// 
+		/// \param [in] puzzle the puzzle
+		///////////////////////////////////////////////////////////////////////
+		explicit EvaluationWorkspace(const Puzzle& puzzle);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Allocate a workspace for puzzles with given dimensions
+		/// 
+		/// \param [in] width the width of the puzzle
+		/// \param [in] height the height of the puzzle
+		///////////////////////////////////////////////////////////////////////
+		EvaluationWorkspace(size_t width, size_t height);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Destructor
+		///////////////////////////////////////////////////////////////////////
+		~EvaluationWorkspace();
+		
+		// prevent creating copies of the workspace
+		EvaluationWorkspace(const EvaluationWorkspace& other) = delete;
+		EvaluationWorkspace& operator=(const EvaluationWorkspace& other) = delete;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if the workspace is large enough for a puzzle
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// 
+		/// \returns true if the puzzle can be evaluated with this workspace
+		///////////////////////////////////////////////////////////////////////
+		bool canHold(const Puzzle& puzzle) const;
+		
+	private:
+		friend class Puzzle;
+		
+		size_t m_numPoints;
+		size_t m_numEdges;
+		size_t m_numSpaces;
+		
+		unsigned int m_generation;
+		
+		// elements are marked if their stamp equals the current generation
+		unsigned int* m_pointStamps;
+		unsigned int* m_edgeStamps;
+		unsigned int* m_spaceStamps;
+		
+		// partition scratch space (only the first N partitions are valid)
+		bool* m_whitePartitions;
+		bool* m_blackPartitions;
+		size_t* m_searchStack;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Start a new evaluation, unmarking all elements
+		///////////////////////////////////////////////////////////////////////
+		void nextGeneration();
+	};
+}
+
+#endif
\ No newline at end of file
@@ -20,11 +20,108 @@
 #define SPACE_BLACK 'b'
 
 #define NUM_POSSIBLE_MOVES 4
-#define MOVE_UP 'u'
-#define MOVE_DOWN 'd'
-#define MOVE_LEFT 'l'
-#define MOVE_RIGHT 'r'
-#define MOVE_NONE '\0'
+#define MOVE_UP 0
+#define MOVE_DOWN 1
+#define MOVE_LEFT 2
+#define MOVE_RIGHT 3
+
+#define PACKED_MOVES_PER_BYTE 4
+#define PATH_HEADER_BYTES 2
+
+#define BITSET_WORD_BITS 32
+
+#define PHILOX_BLOCK_BYTES 16
+#define STREAM_POPULATION 0
+#define STREAM_CROSSOVER 1
+#define STREAM_MUTATION 2
+#define STREAM_SELECTION 3
+#define STREAM_MIGRATION 4
+
+// Philox4x32-10 counter-based random number generator (must produce the same
+// blocks as philox4x32() in Philox.h)
+uint4 philox4x32(
+	const uint4 counter,
+	const uint2 key)
+{
+	uint4 c = counter;
+	uint2 k = key;
+	for (int round = 0; round < 10; ++round) {
+		uint hi0 = mul_hi((uint)0xD2511F53, c.x);
+		uint lo0 = (uint)0xD2511F53*c.x;
+		uint hi1 = mul_hi((uint)0xCD9E8D57, c.z);
+		uint lo1 = (uint)0xCD9E8D57*c.z;
+		c = (uint4)(hi1 ^ c.y ^ k.x, lo1, hi0 ^ c.w ^ k.y, lo0);
+		
+		// bump key (Weyl sequence)
+		k.x += 0x9E3779B9;
+		k.y += 0xBB67AE85;
+	}
+	
+	return c;
+}
+
+// generate a block of random words for the genetic algorithm (must match
+// generateRandomWords() in Philox.h)
+uint4 generateRandomWords(
+	const unsigned int seed,
+	const unsigned int stream,
+	const unsigned int generation,
+	const unsigned int index,
+	const unsigned int subIndex)
+{
+	return philox4x32((uint4)(index, generation, stream, subIndex), (uint2)(seed, 0));
+}
+
+// get one byte of a random block (bytes are in little-endian order of the
+// four output words)
+unsigned char getBlockByte(
+	const uint4 block,
+	const unsigned int byteIndex)
+{
+	uint word;
+	switch (byteIndex/4) {
+		case 0:
+			word = block.x;
+			break;
+		case 1:
+			word = block.y;
+			break;
+		case 2:
+			word = block.z;
+			break;
+		default:
+			word = block.w;
+			break;
+	}
+	
+	return (unsigned char)(word >> (8*(byteIndex%4)));
+}
+
+// fitness statistics of a population (must match the layout of
+// GeneticSolver::FitnessStats)
+typedef struct
+{
+	int maxFitness;
+	int minFitness;
+	int totalFitness;
+	unsigned int maxMember;
+	int solved;
+} FitnessStats;
+
+// location and size of one puzzle of a batch in the concatenated puzzle
+// buffers (must match the layout of GeneticSolver::BatchPuzzle)
+typedef struct
+{
+	unsigned int pointOffset;
+	unsigned int edgeOffset;
+	unsigned int spaceOffset;
+	unsigned int numPoints;
+	unsigned int numEdges;
+	unsigned int numSpaces;
+	unsigned int width;
+	unsigned int height;
+	int maxFitness;
+} BatchPuzzle;
 
 // helper functions for calculating puzzle buffer indicies
 
@@ -132,6 +229,86 @@ unsigned int getNextEdge(
 	return nextEdge;
 }
 
+// get the number of words in a packed bitset
+unsigned int getBitsetWords(const unsigned int numBits)
+{
+	return (numBits + BITSET_WORD_BITS - 1)/BITSET_WORD_BITS;
+}
+
+// check if a bit of a packed bitset is set
+bool testBit(
+	__local const unsigned int* bits,
+	const unsigned int startWord,
+	const unsigned int index)
+{
+	return (bits[startWord + index/BITSET_WORD_BITS] >> (index%BITSET_WORD_BITS)) & 1;
+}
+
+// set a bit of a packed bitset
+void setBit(
+	__local unsigned int* bits,
+	const unsigned int startWord,
+	const unsigned int index)
+{
+	bits[startWord + index/BITSET_WORD_BITS] |= 1u << (index%BITSET_WORD_BITS);
+}
+
+// get the index of a genome (or packed path) byte of a population member
+// (members are interleaved if the program is built with
+// INTERLEAVED_POPULATION, so adjacent work items access adjacent bytes)
+unsigned int getByteIndex(
+	const unsigned int member,
+	const unsigned int byte,
+	const unsigned int popStride,
+	const unsigned int memberBytes)
+{
+#ifdef INTERLEAVED_POPULATION
+	return byte*popStride + member;
+#else
+	return member*memberBytes + byte;
+#endif
+}
+
+// get the number of bytes in one population member's genome (a start
+// selector byte followed by 2-bit move genes, must match getGenomeBytes() in
+// Genome.h)
+unsigned int getGenomeBytes(
+	const unsigned int maxLength)
+{
+	return 1 + (maxLength + PACKED_MOVES_PER_BYTE - 1)/PACKED_MOVES_PER_BYTE;
+}
+
+// get the number of bytes in one member's packed path (a move count followed
+// by 2-bit moves, must match getPackedPathBytes() in Genome.h)
+unsigned int getPackedPathBytes(
+	const unsigned int maxLength)
+{
+	return PATH_HEADER_BYTES + (maxLength + PACKED_MOVES_PER_BYTE - 1)/PACKED_MOVES_PER_BYTE;
+}
+
+// find the range of members of an island (the population is split into
+// contiguous islands of equal size, and the last island takes any remainder)
+void getIslandRange(
+	const unsigned int island,
+	const unsigned int popSize,
+	const unsigned int numIslands,
+	unsigned int* first,
+	unsigned int* last)
+{
+	unsigned int islandSize = popSize/numIslands;
+	*first = island*islandSize;
+	*last = island + 1 < numIslands ? *first + islandSize : popSize;
+}
+
+// find the island containing a member
+unsigned int getIsland(
+	const unsigned int member,
+	const unsigned int popSize,
+	const unsigned int numIslands)
+{
+	return min(member/(popSize/numIslands), numIslands - 1);
+}
+
 // check if a move from one point to the next is valid
 bool checkMove(
 	const unsigned int currentRow,
@@ -143,8 +320,8 @@ bool checkMove(
 	const unsigned int numPoints,
 	const unsigned int puzzleWidth,
 	const unsigned int puzzleHeight,
-	__local bool* visitedPoints,
-	const unsigned int localPointStartIndex)
+	__local const unsigned int* visitedPoints,
+	const unsigned int localPointStartWord)
 {
 	// get desired point index
 	unsigned int nextPoint = getPointIndex(nextRow, nextCol, puzzleWidth);
@@ -157,7 +334,7 @@ bool checkMove(
 	    && nextCol < puzzleWidth
 	    && puzzlePoints[nextPoint] != POINT_BLOCKED
 	    && puzzleEdges[nextEdge] != EDGE_BLOCKED
-	    && !visitedPoints[localPointStartIndex + nextPoint];
+	    && !testBit(visitedPoints, localPointStartWord, nextPoint);
 }
 
 // check if a move from the current point upward is valid
@@ -169,8 +346,8 @@ bool checkMoveUp(
 	const unsigned int numPoints,
 	const unsigned int puzzleWidth,
 	const unsigned int puzzleHeight,
-	__local bool* visitedPoints,
-	const unsigned int localPointStartIndex)
+	__local const unsigned int* visitedPoints,
+	const unsigned int localPointStartWord)
 {
 	return checkMove(
 		currentRow,
@@ -183,7 +360,7 @@ bool checkMoveUp(
 		puzzleWidth,
 		puzzleHeight,
 		visitedPoints,
-		localPointStartIndex);
+		localPointStartWord);
 }
 
 // check if a move from the current point downward is valid
@@ -195,8 +372,8 @@ bool checkMoveDown(
 	const unsigned int numPoints,
 	const unsigned int puzzleWidth,
 	const unsigned int puzzleHeight,
-	__local bool* visitedPoints,
-	const unsigned int localPointStartIndex)
+	__local const unsigned int* visitedPoints,
+	const unsigned int localPointStartWord)
 {
 	return checkMove(
 		currentRow,
@@ -209,7 +386,7 @@ bool checkMoveDown(
 		puzzleWidth,
 		puzzleHeight,
 		visitedPoints,
-		localPointStartIndex);
+		localPointStartWord);
 }
 
 // check if a move from the current point leftward is valid
@@ -221,8 +398,8 @@ bool checkMoveLeft(
 	const unsigned int numPoints,
 	const unsigned int puzzleWidth,
 	const unsigned int puzzleHeight,
-	__local bool* visitedPoints,
-	const unsigned int localPointStartIndex)
+	__local const unsigned int* visitedPoints,
+	const unsigned int localPointStartWord)
 {
 	return checkMove(
 		currentRow,
@@ -235,7 +412,7 @@ bool checkMoveLeft(
 		puzzleWidth,
 		puzzleHeight,
 		visitedPoints,
-		localPointStartIndex);
+		localPointStartWord);
 }
 
 // check if a move from the current point rightward is valid
@@ -247,8 +424,8 @@ bool checkMoveRight(
 	const unsigned int numPoints,
 	const unsigned int puzzleWidth,
 	const unsigned int puzzleHeight,
-	__local bool* visitedPoints,
-	const unsigned int localPointStartIndex)
+	__local const unsigned int* visitedPoints,
+	const unsigned int localPointStartWord)
 {
 	return checkMove(
 		currentRow,
@@ -261,43 +438,58 @@ bool checkMoveRight(
 		puzzleWidth,
 		puzzleHeight,
 		visitedPoints,
-		localPointStartIndex);
+		localPointStartWord);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-/// \brief Calculate solution fitness on a population
+/// \brief Generate a random initial population
 /// 
-/// \param [in] population the random population data
-/// \param [in] popSize the poulation size
-/// \param [in] maxLength the max length of each population member's data
-/// \param [in] puzzlePoints the puzzle point buffer
-/// \param [in] puzzleEdges the puzzle edge buffer
-/// \param [in] puzzleSpaces the puzzle space buffer
-/// \param [in] numPoints the number of points in the puzzle
-/// \param [in] numEdges the number of edges in the puzzle
-/// \param [in] numSpaces the number of spaces in the puzzle
-/// \param [in] puzzleWidth the width of the puzzle (points per row)
-/// \param [in] puzzleHeight the height of the puzzle (points per column)
+/// Each work item fills one block of PHILOX_BLOCK_BYTES population bytes.
+/// Every byte only depends on the seed and its position in the population
+/// (counted member by member, whatever the layout), so the population is
+/// the same for any work-group size (and matches HostGeneticSolver). Move
+/// gene bytes are used as is (four random genes each).
 /// 
-/// \param [in] visitedPoints local scratch space for keeping track of points
-/// \param [in] visitedEdges local scratch space for keeping track of edges
-/// \param [in] spacePartitionNumbers local scratch space for keeping track of
-/// partitions
-/// \param [in] whitePartitions local scratch space for keeping track of which
-/// partitions contain white spaces
-/// \param [in] blackPartitions local scratch space for keeping track of which
-/// partitions contain black spaces
-/// \param [in] searchStack local scratch space to use as a stack during
-/// depth-first search during space partitioning
+/// \param [in] popSize the population size
+/// \param [in] maxLength the max number of moves of each population member
+/// \param [in] seed the random seed
 /// 
-/// \param [out] fitness the calculated fitness values
-/// \param [out] startPoints the selected start points
-/// \param [out] paths the solution paths generated from the population data
+/// \param [out] population the random population data
 ///////////////////////////////////////////////////////////////////////////////
-__kernel void evaluatePopulation(
-	__global const unsigned char* population,
+__kernel void generatePopulation(
 	const unsigned int popSize,
 	const unsigned int maxLength,
+	const unsigned int seed,
+	__global unsigned char* population)
+{
+	unsigned int gid = get_global_id(0);
+	unsigned int genomeBytes = getGenomeBytes(maxLength);
+	unsigned int totalBytes = popSize*genomeBytes;
+	unsigned int firstByte = gid*PHILOX_BLOCK_BYTES;
+	if (firstByte < totalBytes) {
+		uint4 block = generateRandomWords(seed, STREAM_POPULATION, 0, gid, 0);
+		for (unsigned int i = 0; i < PHILOX_BLOCK_BYTES && firstByte + i < totalBytes; ++i) {
+			unsigned int byte = firstByte + i;
+			unsigned char value = getBlockByte(block, i);
+			if (byte%genomeBytes == 0) {
+				// start selector
+				value %= UCHAR_MAX;
+			}
+			population[getByteIndex(byte/genomeBytes, byte%genomeBytes, popSize, genomeBytes)] = value;
+		}
+	}
+}
+
+// calculate the fitness of one population member and output its start point
+// and packed path (each work item passes the start of its own part of each
+// scratch bitset)
+int evaluateMember(
+	__global const unsigned char* population,
+	const unsigned int member,
+	const unsigned int popStride,
+	const unsigned int genomeBytes,
+	const unsigned int pathBytes,
+	const unsigned int maxLength,
 	__constant const char* puzzlePoints,
 	__constant const char* puzzleEdges,
 	__constant const char* puzzleSpaces,
@@ -306,240 +498,1185 @@ __kernel void evaluatePopulation(
 	const unsigned int numSpaces,
 	const unsigned int puzzleWidth,
 	const unsigned int puzzleHeight,
-	__local bool* visitedPoints,
-	__local bool* visitedEdges,
-	__local char* spacePartitionNumbers,
-	__local bool* whitePartitions,
-	__local bool* blackPartitions,
-	__local unsigned char* searchStack,
-	__global int* fitness,
+	__local unsigned int* visitedPoints,
+	__local unsigned int* visitedEdges,
+	__local unsigned int* partitionedSpaces,
+	__local unsigned int* pendingSpaces,
+	const unsigned int localPointStartWord,
+	const unsigned int localEdgeStartWord,
+	const unsigned int localSpaceStartWord,
 	__global unsigned int* startPoints,
-	__global char* paths)
+	__global unsigned char* paths)
 {
-	unsigned int gid = get_global_id(0);
-	if (gid < popSize) {
-		int fitnessValue = 0;
-		
-		// calculate first index of memory arrays used by this work item
-		unsigned int popStartIndex = gid*maxLength;
-		
-		unsigned int lid = get_local_id(0);
-		unsigned int localPointStartIndex = lid*numPoints;
-		unsigned int localEdgeStartIndex = lid*numEdges;
-		unsigned int localSpaceStartIndex = lid*numSpaces;
+	int fitnessValue = 0;
+	unsigned int numPointWords = getBitsetWords(numPoints);
+	unsigned int numEdgeWords = getBitsetWords(numEdges);
+	unsigned int numSpaceWords = getBitsetWords(numSpaces);
+	
+	// mark all points and edges as unvisited (they can only be visited once)
+	for (unsigned int i = 0; i < numPointWords; ++i) {
+		visitedPoints[localPointStartWord + i] = 0;
+	}
+	for (unsigned int i = 0; i < numEdgeWords; ++i) {
+		visitedEdges[localEdgeStartWord + i] = 0;
+	}
+	
+	// initialize paths to empty
+	for (unsigned int i = 0; i < pathBytes; ++i) {
+		paths[getByteIndex(member, i, popStride, pathBytes)] = 0;
+	}
+	
+	// find start point of path
+	bool canContinue = true;
+	unsigned int startIndex = findStartIndex(population[getByteIndex(member, 0, popStride, genomeBytes)], puzzlePoints, numPoints);
+	unsigned int row = getPointRow(startIndex, puzzleWidth);
+	unsigned int col = getPointCol(startIndex, puzzleWidth);
+	unsigned int nextRow = row;
+	unsigned int nextCol = col;
+	unsigned int move = 0;
+	
+	// moves are packed into a byte at a time (and genes are unpacked from
+	// a byte at a time)
+	unsigned int numMoves = 0;
+	unsigned char packedMoves = 0;
+	unsigned char genes = 0;
+	
+	// output start point of path
+	startPoints[member] = startIndex;
+	
+	// follow path
+	while (canContinue && move < maxLength) {
+		unsigned int currentPointIndex = getPointIndex(row, col, puzzleWidth);
 		
-		// mark all points and edges as unvisited (they can only be visited once)
-		for (unsigned int i = 0; i < numPoints; ++i) {
-			visitedPoints[localPointStartIndex + i] = false;
-		}
-		for (unsigned int i = 0; i < numEdges; ++i) {
-			visitedEdges[localEdgeStartIndex + i] = false;
-		}
+		// mark point as visited
+		setBit(visitedPoints, localPointStartWord, currentPointIndex);
 		
-		// initialize paths to empty
-		for (unsigned int i = 0; i < numPoints; ++i) {
-			paths[popStartIndex + i] = MOVE_NONE;
+		// check dot constraint
+		if (puzzlePoints[currentPointIndex] == POINT_DOT) {
+			// dots earn 1 fitness point
+			++fitnessValue;
 		}
 		
-		// find start point of path
-		bool canContinue = true;
-		unsigned int startIndex = findStartIndex(population[popStartIndex], puzzlePoints, numPoints);
-		unsigned int row = getPointRow(startIndex, puzzleWidth);
-		unsigned int col = getPointCol(startIndex, puzzleWidth);
-		unsigned int nextRow = row;
-		unsigned int nextCol = col;
-		unsigned int move = 0;
-		
-		// output start point of path
-		startPoints[gid] = startIndex;
-		
-		// follow path
-		while (canContinue && move < maxLength) {
-			unsigned int currentPointIndex = getPointIndex(row, col, puzzleWidth);
-			
-			// mark point as visited
-			visitedPoints[localPointStartIndex + currentPointIndex] = true;
-			
-			// check dot constraint
-			if (puzzlePoints[currentPointIndex] == POINT_DOT) {
-				// dots earn 1 fitness point
-				++fitnessValue;
+		// only continue  reached the end of the puzzle
+		if (puzzlePoints[currentPointIndex] != POINT_END) {
+			// get next move (check which moves are valid)
+			unsigned char possibleMoves[NUM_POSSIBLE_MOVES];
+			unsigned int choices = 0;
+			if (checkMoveUp(row, col, puzzlePoints, puzzleEdges, numPoints,
+			                puzzleWidth, puzzleHeight, visitedPoints, localPointStartWord)) {
+				possibleMoves[choices] = MOVE_UP;
+				++choices;
+			}
+			if (checkMoveDown(row, col, puzzlePoints, puzzleEdges, numPoints,
+			                  puzzleWidth, puzzleHeight, visitedPoints, localPointStartWord)) {
+				possibleMoves[choices] = MOVE_DOWN;
+				++choices;
+			}
+			if (checkMoveLeft(row, col, puzzlePoints, puzzleEdges, numPoints,
+			                  puzzleWidth, puzzleHeight, visitedPoints, localPointStartWord)) {
+				possibleMoves[choices] = MOVE_LEFT;
+				++choices;
+			}
+			if (checkMoveRight(row, col, puzzlePoints, puzzleEdges, numPoints,
+			                   puzzleWidth, puzzleHeight, visitedPoints, localPointStartWord)) {
+				possibleMoves[choices] = MOVE_RIGHT;
+				++choices;
 			}
 			
-			// only continue  reached the end of the puzzle
-			if (puzzlePoints[currentPointIndex] != POINT_END) {
-				// get next move (check which moves are valid)
-				char possibleMoves[NUM_POSSIBLE_MOVES];
-				unsigned int choices = 0;
-				if (checkMoveUp(row, col, puzzlePoints, puzzleEdges, numPoints,
-				                puzzleWidth, puzzleHeight, visitedPoints, localPointStartIndex)) {
-					possibleMoves[choices] = MOVE_UP;
-					++choices;
-				}
-				if (checkMoveDown(row, col, puzzlePoints, puzzleEdges, numPoints,
-				                  puzzleWidth, puzzleHeight, visitedPoints, localPointStartIndex)) {
-					possibleMoves[choices] = MOVE_DOWN;
-					++choices;
+			// if moves are possible continue, otherwise
+			if (choices > 0) {
+				nextRow = row;
+				nextCol = col;
+				unsigned int shift = 2*(move%PACKED_MOVES_PER_BYTE);
+				if (shift == 0) {
+					genes = population[getByteIndex(member, 1 + move/PACKED_MOVES_PER_BYTE, popStride, genomeBytes)];
 				}
-				if (checkMoveLeft(row, col, puzzlePoints, puzzleEdges, numPoints,
-				                  puzzleWidth, puzzleHeight, visitedPoints, localPointStartIndex)) {
-					possibleMoves[choices] = MOVE_LEFT;
-					++choices;
+				
+				// (with 3 choices the first is picked by 2 of the 4 gene
+				// values, see MOVE_GENE_VALUES in Genome.h)
+				unsigned char nextMove = possibleMoves[((genes >> shift) & 3) % choices];
+				switch (nextMove) {
+					case MOVE_UP:
+						nextRow = row - 1;
+						break;
+					case MOVE_DOWN:
+						nextRow = row + 1;
+						break;
+					case MOVE_LEFT:
+						nextCol = col - 1;
+						break;
+					case MOVE_RIGHT:
+						nextCol = col + 1;
+						break;
+					default:
+						// something weird happened, so stop
+						canContinue = false;
+						break;
 				}
-				if (checkMoveRight(row, col, puzzlePoints, puzzleEdges, numPoints,
-				                   puzzleWidth, puzzleHeight, visitedPoints, localPointStartIndex)) {
-					possibleMoves[choices] = MOVE_RIGHT;
-					++choices;
+				
+				// output move (moves are only made on consecutive genes,
+				// so the path's move index is the gene's move index)
+				packedMoves |= nextMove << shift;
+				++numMoves;
+				if (numMoves%PACKED_MOVES_PER_BYTE == 0) {
+					paths[getByteIndex(member, PATH_HEADER_BYTES + move/PACKED_MOVES_PER_BYTE, popStride, pathBytes)] = packedMoves;
+					packedMoves = 0;
 				}
 				
-				// if moves are possible continue, otherwise
-				if (choices > 0) {
-					nextRow = row;
-					nextCol = col;
-					switch (possibleMoves[population[popStartIndex + move] % choices]) {
-						case MOVE_UP:
-							nextRow = row - 1;
-							paths[popStartIndex + move] = MOVE_UP;
-							break;
-						case MOVE_DOWN:
-							nextRow = row + 1;
-							paths[popStartIndex + move] = MOVE_DOWN;
-							break;
-						case MOVE_LEFT:
-							nextCol = col - 1;
-							paths[popStartIndex + move] = MOVE_LEFT;
-							break;
-						case MOVE_RIGHT:
-							nextCol = col + 1;
-							paths[popStartIndex + move] = MOVE_RIGHT;
-							break;
-						default:
-							// something weird happened, so stop
-							canContinue = false;
-							break;
-					}
-					
-					// mark edge as visited
-					unsigned int nextEdge = getNextEdge(row, col, nextRow, nextCol, puzzleWidth);
-					visitedEdges[localEdgeStartIndex + nextEdge] = true;
-					
-					// check dot constraint
-					if (puzzleEdges[nextEdge] == EDGE_DOT) {
-						// dots earn 1 fitness point
-						++fitnessValue;
-					}
-					
-					row = nextRow;
-					col = nextCol;
+				// mark edge as visited
+				unsigned int nextEdge = getNextEdge(row, col, nextRow, nextCol, puzzleWidth);
+				setBit(visitedEdges, localEdgeStartWord, nextEdge);
+				
+				// check dot constraint
+				if (puzzleEdges[nextEdge] == EDGE_DOT) {
+					// dots earn 1 fitness point
+					++fitnessValue;
 				}
-				else {
-					canContinue = false;
-				}	
+				
+				row = nextRow;
+				col = nextCol;
 			}
 			else {
-				// reaching the end earns 1 fitness point
-				++fitnessValue;
 				canContinue = false;
+			}	
+		}
+		else {
+			// reaching the end earns 1 fitness point
+			++fitnessValue;
+			canContinue = false;
+		}
+		
+		++move;
+	}
+	
+	// output the last partly filled byte of moves and the move count
+	if (numMoves%PACKED_MOVES_PER_BYTE != 0) {
+		paths[getByteIndex(member, PATH_HEADER_BYTES + numMoves/PACKED_MOVES_PER_BYTE, popStride, pathBytes)] = packedMoves;
+	}
+	paths[getByteIndex(member, 0, popStride, pathBytes)] = numMoves & 0xff;
+	paths[getByteIndex(member, 1, popStride, pathBytes)] = numMoves >> 8;
+	
+	// validate white/black space parition constraints
+	
+	// partition spaces into regions separated by the path (a space is
+	// marked as partitioned when it becomes pending, so it's only
+	// searched once)
+	for (unsigned int i = 0; i < numSpaceWords; ++i) {
+		partitionedSpaces[localSpaceStartWord + i] = 0;
+		pendingSpaces[localSpaceStartWord + i] = 0;
+	}
+	
+	unsigned int numPendingSpaces = 0;
+	unsigned int firstPendingWord = 0;
+	unsigned int numPartitionedSpaces = 0;
+	unsigned int spaceIndex = 0;
+	while (numPartitionedSpaces < numSpaces) {
+		// find starting point for search
+		while (testBit(partitionedSpaces, localSpaceStartWord, spaceIndex)) {
+			++spaceIndex;
+		}
+		
+		// index is guaranteed to be valid since when all
+		// spaces are assigned this loop won't execute
+		setBit(partitionedSpaces, localSpaceStartWord, spaceIndex);
+		setBit(pendingSpaces, localSpaceStartWord, spaceIndex);
+		numPendingSpaces = 1;
+		firstPendingWord = spaceIndex/BITSET_WORD_BITS;
+		
+		// count the white and black spaces of this partition
+		unsigned int numWhiteSpaces = 0;
+		unsigned int numBlackSpaces = 0;
+		while (numPendingSpaces > 0) {
+			// take the lowest pending space (the order spaces are searched
+			// in doesn't change the partitions)
+			while (pendingSpaces[localSpaceStartWord + firstPendingWord] == 0) {
+				++firstPendingWord;
+			}
+			unsigned int pendingWord = pendingSpaces[localSpaceStartWord + firstPendingWord];
+			unsigned int lowestBit = pendingWord & (0u - pendingWord);
+			unsigned int currentSpace = firstPendingWord*BITSET_WORD_BITS + (BITSET_WORD_BITS - 1 - clz(lowestBit));
+			pendingSpaces[localSpaceStartWord + firstPendingWord] = pendingWord ^ lowestBit;
+			--numPendingSpaces;
+			
+			++numPartitionedSpaces;
+			switch (puzzleSpaces[currentSpace]) {
+				case SPACE_WHITE:
+					++numWhiteSpaces;
+					break;
+				case SPACE_BLACK:
+					++numBlackSpaces;
+					break;
+				default:
+					break;
+			}
+			
+			// check if reachable neighboring spaces need to be processed
+			unsigned int spaceRow = getSpaceRow(currentSpace, puzzleWidth);
+			unsigned int spaceCol = getSpaceCol(currentSpace, puzzleWidth);
+			unsigned int neighbors[4];
+			unsigned int numNeighbors = 0;
+			
+			// space row/col coordinates correspond to the same coordinates of the upper-left point on the space
+			if (spaceRow > 0 && !testBit(visitedEdges, localEdgeStartWord, getEdgeIndex(spaceRow, spaceCol, spaceRow, spaceCol + 1, puzzleWidth))) {
+				neighbors[numNeighbors++] = getSpaceIndex(spaceRow - 1, spaceCol, puzzleWidth);
+			}
+			if (spaceRow < puzzleHeight - 2 && !testBit(visitedEdges, localEdgeStartWord, getEdgeIndex(spaceRow + 1, spaceCol, spaceRow + 1, spaceCol + 1, puzzleWidth))) {
+				neighbors[numNeighbors++] = getSpaceIndex(spaceRow + 1, spaceCol, puzzleWidth);
+			}
+			if (spaceCol > 0 && !testBit(visitedEdges, localEdgeStartWord, getEdgeIndex(spaceRow, spaceCol, spaceRow + 1, spaceCol, puzzleWidth))) {
+				neighbors[numNeighbors++] = getSpaceIndex(spaceRow, spaceCol - 1, puzzleWidth);
+			}
+			if (spaceCol < puzzleWidth - 2 && !testBit(visitedEdges, localEdgeStartWord, getEdgeIndex(spaceRow, spaceCol + 1, spaceRow + 1, spaceCol + 1, puzzleWidth))) {
+				neighbors[numNeighbors++] = getSpaceIndex(spaceRow, spaceCol + 1, puzzleWidth);
 			}
 			
-			++move;
+			for (unsigned int i = 0; i < numNeighbors; ++i) {
+				if (!testBit(partitionedSpaces, localSpaceStartWord, neighbors[i])) {
+					setBit(partitionedSpaces, localSpaceStartWord, neighbors[i]);
+					setBit(pendingSpaces, localSpaceStartWord, neighbors[i]);
+					++numPendingSpaces;
+					firstPendingWord = min(firstPendingWord, neighbors[i]/BITSET_WORD_BITS);
+				}
+			}
 		}
 		
-		// validate white/black space parition constraints
+		// each white/black space in a valid partition earns 1 fitness
+		// point (partitions are scored as soon as they're complete, so
+		// partition numbers never need to be stored)
+		if (numBlackSpaces == 0) {
+			fitnessValue += numWhiteSpaces;
+		}
+		if (numWhiteSpaces == 0) {
+			fitnessValue += numBlackSpaces;
+		}
+	}
+	
+	return fitnessValue;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Calculate solution fitness on a population
+/// 
+/// \param [in] population the random population data
+/// \param [in] popSize the number of members to evaluate
+/// \param [in] popStride the number of members the population and paths
+/// buffers hold
+/// \param [in] maxLengthArg the max number of moves of each population
+/// member
+/// \param [in] puzzlePoints the puzzle point buffer
+/// \param [in] puzzleEdges the puzzle edge buffer
+/// \param [in] puzzleSpaces the puzzle space buffer
+/// \param [in] numPointsArg the number of points in the puzzle
+/// \param [in] numEdgesArg the number of edges in the puzzle
+/// \param [in] numSpacesArg the number of spaces in the puzzle
+/// \param [in] puzzleWidthArg the width of the puzzle (points per row)
+/// \param [in] puzzleHeightArg the height of the puzzle (points per column)
+/// 
+/// The puzzle dimension arguments (including the max length, which is always
+/// the number of points) are ignored if the program is built with PUZZLE_WIDTH,
+/// PUZZLE_HEIGHT, PUZZLE_NUM_POINTS, PUZZLE_NUM_EDGES and PUZZLE_NUM_SPACES
+/// defined, so the compiler can unroll loops and fold index arithmetic for
+/// one puzzle size.
+/// 
+/// \param [in] visitedPoints local scratch space for keeping track of points
+/// (one bit per point)
+/// \param [in] visitedEdges local scratch space for keeping track of edges
+/// (one bit per edge)
+/// \param [in] partitionedSpaces local scratch space for keeping track of
+/// which spaces have been assigned to a partition (one bit per space)
+/// \param [in] pendingSpaces local scratch space for keeping track of which
+/// spaces are waiting to be searched during space partitioning (one bit per
+/// space)
+/// 
+/// \param [out] fitness the calculated fitness values
+/// \param [out] startPoints the selected start points
+/// \param [out] paths the packed solution paths generated from the population
+/// data (see getPackedPathBytes)
+///////////////////////////////////////////////////////////////////////////////
+__kernel void evaluatePopulation(
+	__global const unsigned char* population,
+	const unsigned int popSize,
+	const unsigned int popStride,
+	const unsigned int maxLengthArg,
+	__constant const char* puzzlePoints,
+	__constant const char* puzzleEdges,
+	__constant const char* puzzleSpaces,
+	const unsigned int numPointsArg,
+	const unsigned int numEdgesArg,
+	const unsigned int numSpacesArg,
+	const unsigned int puzzleWidthArg,
+	const unsigned int puzzleHeightArg,
+	__local unsigned int* visitedPoints,
+	__local unsigned int* visitedEdges,
+	__local unsigned int* partitionedSpaces,
+	__local unsigned int* pendingSpaces,
+	__global int* fitness,
+	__global unsigned int* startPoints,
+	__global unsigned char* paths)
+{
+#ifdef PUZZLE_WIDTH
+	const unsigned int maxLength = PUZZLE_NUM_POINTS;
+	const unsigned int numPoints = PUZZLE_NUM_POINTS;
+	const unsigned int numEdges = PUZZLE_NUM_EDGES;
+	const unsigned int numSpaces = PUZZLE_NUM_SPACES;
+	const unsigned int puzzleWidth = PUZZLE_WIDTH;
+	const unsigned int puzzleHeight = PUZZLE_HEIGHT;
+#else
+	const unsigned int maxLength = maxLengthArg;
+	const unsigned int numPoints = numPointsArg;
+	const unsigned int numEdges = numEdgesArg;
+	const unsigned int numSpaces = numSpacesArg;
+	const unsigned int puzzleWidth = puzzleWidthArg;
+	const unsigned int puzzleHeight = puzzleHeightArg;
+#endif
+	
+	unsigned int gid = get_global_id(0);
+	if (gid < popSize) {
+		unsigned int lid = get_local_id(0);
+		fitness[gid] = evaluateMember(
+			population,
+			gid,
+			popStride,
+			getGenomeBytes(maxLength),
+			getPackedPathBytes(maxLength),
+			maxLength,
+			puzzlePoints,
+			puzzleEdges,
+			puzzleSpaces,
+			numPoints,
+			numEdges,
+			numSpaces,
+			puzzleWidth,
+			puzzleHeight,
+			visitedPoints,
+			visitedEdges,
+			partitionedSpaces,
+			pendingSpaces,
+			lid*getBitsetWords(numPoints),
+			lid*getBitsetWords(numEdges),
+			lid*getBitsetWords(numSpaces),
+			startPoints,
+			paths);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Calculate solution fitness on a population holding members of a
+/// batch of puzzles
+/// 
+/// The population is split between the puzzles like islands (see
+/// getIslandRange), and the puzzles are concatenated in the puzzle buffers.
+/// Each member only makes as many moves as its own puzzle has points, and
+/// members of puzzles that are already solved are skipped (with 0 fitness
+/// and an empty path). The local scratch space is sized for the largest
+/// puzzle of the batch.
+/// 
+/// \param [in] population the random population data
+/// \param [in] popSize the number of members to evaluate
+/// \param [in] popStride the number of members the population and paths
+/// buffers hold (the whole batch population)
+/// \param [in] maxLength the max number of moves of each population member
+/// (the number of points in the largest puzzle)
+/// \param [in] maxEdges the number of edges in the largest puzzle
+/// \param [in] maxSpaces the number of spaces in the largest puzzle
+/// \param [in] puzzlePoints the concatenated puzzle point buffers
+/// \param [in] puzzleEdges the concatenated puzzle edge buffers
+/// \param [in] puzzleSpaces the concatenated puzzle space buffers
+/// \param [in] puzzles the location and size of each puzzle
+/// \param [in] numPuzzles the number of puzzles
+/// \param [in] solvedPuzzles whether each puzzle is already solved
+/// 
+/// \param [in] visitedPoints local scratch space for keeping track of points
+/// \param [in] visitedEdges local scratch space for keeping track of edges
+/// \param [in] partitionedSpaces local scratch space for keeping track of
+/// which spaces have been assigned to a partition
+/// \param [in] pendingSpaces local scratch space for keeping track of which
+/// spaces are waiting to be searched during space partitioning
+/// 
+/// \param [out] fitness the calculated fitness values
+/// \param [out] startPoints the selected start points
+/// \param [out] paths the packed solution paths generated from the population
+/// data
+///////////////////////////////////////////////////////////////////////////////
+__kernel void evaluatePopulationBatch(
+	__global const unsigned char* population,
+	const unsigned int popSize,
+	const unsigned int popStride,
+	const unsigned int maxLength,
+	const unsigned int maxEdges,
+	const unsigned int maxSpaces,
+	__constant const char* puzzlePoints,
+	__constant const char* puzzleEdges,
+	__constant const char* puzzleSpaces,
+	__constant const BatchPuzzle* puzzles,
+	const unsigned int numPuzzles,
+	__global const int* solvedPuzzles,
+	__local unsigned int* visitedPoints,
+	__local unsigned int* visitedEdges,
+	__local unsigned int* partitionedSpaces,
+	__local unsigned int* pendingSpaces,
+	__global int* fitness,
+	__global unsigned int* startPoints,
+	__global unsigned char* paths)
+{
+	unsigned int gid = get_global_id(0);
+	if (gid < popSize) {
+		unsigned int genomeBytes = getGenomeBytes(maxLength);
+		unsigned int pathBytes = getPackedPathBytes(maxLength);
+		unsigned int puzzle = getIsland(gid, popStride, numPuzzles);
+		if (solvedPuzzles[puzzle]) {
+			fitness[gid] = 0;
+			startPoints[gid] = 0;
+			paths[getByteIndex(gid, 0, popStride, pathBytes)] = 0;
+			paths[getByteIndex(gid, 1, popStride, pathBytes)] = 0;
+		}
+		else {
+			BatchPuzzle info = puzzles[puzzle];
+			unsigned int lid = get_local_id(0);
+			fitness[gid] = evaluateMember(
+				population,
+				gid,
+				popStride,
+				genomeBytes,
+				pathBytes,
+				info.numPoints,
+				puzzlePoints + info.pointOffset,
+				puzzleEdges + info.edgeOffset,
+				puzzleSpaces + info.spaceOffset,
+				info.numPoints,
+				info.numEdges,
+				info.numSpaces,
+				info.width,
+				info.height,
+				visitedPoints,
+				visitedEdges,
+				partitionedSpaces,
+				pendingSpaces,
+				lid*getBitsetWords(maxLength),
+				lid*getBitsetWords(maxEdges),
+				lid*getBitsetWords(maxSpaces),
+				startPoints,
+				paths);
+		}
+	}
+}
+
+// reduce the fitness values of a range of members to their statistics (every
+// work item of the group must call this, and the result is only complete in
+// work item 0)
+FitnessStats reduceFitnessRange(
+	__global const int* fitness,
+	const unsigned int first,
+	const unsigned int last,
+	__local FitnessStats* partialStats)
+{
+	unsigned int lid = get_local_id(0);
+	unsigned int numWorkItems = get_local_size(0);
+	
+	// reduce this work item's members
+	FitnessStats localStats;
+	localStats.maxFitness = INT_MIN;
+	localStats.minFitness = INT_MAX;
+	localStats.totalFitness = 0;
+	localStats.maxMember = last;
+	localStats.solved = 0;
+	for (unsigned int i = first + lid; i < last; i += numWorkItems) {
+		int value = fitness[i];
+		if (value > localStats.maxFitness) {
+			localStats.maxFitness = value;
+			localStats.maxMember = i;
+		}
+		localStats.minFitness = min(localStats.minFitness, value);
+		localStats.totalFitness += value;
+	}
+	partialStats[lid] = localStats;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	
+	// combine partial statistics (ties keep the lowest member index)
+	for (unsigned int stride = 1; stride < numWorkItems; stride *= 2) {
+		if (lid%(2*stride) == 0 && lid + stride < numWorkItems) {
+			FitnessStats other = partialStats[lid + stride];
+			if (other.maxFitness > localStats.maxFitness
+			    || (other.maxFitness == localStats.maxFitness && other.maxMember < localStats.maxMember)) {
+				localStats.maxFitness = other.maxFitness;
+				localStats.maxMember = other.maxMember;
+			}
+			localStats.minFitness = min(localStats.minFitness, other.minFitness);
+			localStats.totalFitness += other.totalFitness;
+			partialStats[lid] = localStats;
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+	
+	return localStats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Calculate the fitness statistics of a population
+/// 
+/// Must be run as a single work group: each work item reduces an interleaved
+/// subset of the population, and the partial results are combined in local
+/// memory. The max member is the first member with the max fitness, and the
+/// population is solved if the max fitness reaches the puzzle's max fitness.
+/// 
+/// \param [in] fitness the fitness values
+/// \param [in] popSize the population size
+/// \param [in] maxPuzzleFitness the max fitness of the puzzle
+/// 
+/// \param [in] partialStats local scratch space for the partial statistics
+/// 
+/// \param [out] stats the fitness statistics
+///////////////////////////////////////////////////////////////////////////////
+__kernel void reduceFitness(
+	__global const int* fitness,
+	const unsigned int popSize,
+	const int maxPuzzleFitness,
+	__local FitnessStats* partialStats,
+	__global FitnessStats* stats)
+{
+	FitnessStats localStats = reduceFitnessRange(fitness, 0, popSize, partialStats);
+	if (get_local_id(0) == 0) {
+		localStats.solved = localStats.maxFitness == maxPuzzleFitness;
+		*stats = localStats;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Calculate the fitness statistics of each puzzle of a batch and of
+/// the whole population
+/// 
+/// Must be run as a single work group, which reduces one puzzle's members at
+/// a time. A puzzle is only reported as solved by the generation that solves
+/// it, and its solved flag is set so later evaluations skip its members. The
+/// whole population's statistics (used for selection) are solved once every
+/// puzzle is.
+/// 
+/// \param [in] fitness the fitness values
+/// \param [in] popSize the population size
+/// \param [in] puzzles the location, size and max fitness of each puzzle
+/// \param [in] numPuzzles the number of puzzles
+/// 
+/// \param [in] partialStats local scratch space for the partial statistics
+/// 
+/// \param [in,out] solvedPuzzles whether each puzzle is solved
+/// \param [out] stats the fitness statistics of the whole population
+/// \param [out] puzzleStats the fitness statistics of each puzzle
+///////////////////////////////////////////////////////////////////////////////
+__kernel void reduceFitnessBatch(
+	__global const int* fitness,
+	const unsigned int popSize,
+	__constant const BatchPuzzle* puzzles,
+	const unsigned int numPuzzles,
+	__local FitnessStats* partialStats,
+	__global int* solvedPuzzles,
+	__global FitnessStats* stats,
+	__global FitnessStats* puzzleStats)
+{
+	FitnessStats totalStats;
+	totalStats.maxFitness = INT_MIN;
+	totalStats.minFitness = INT_MAX;
+	totalStats.totalFitness = 0;
+	totalStats.maxMember = popSize;
+	totalStats.solved = 1;
+	for (unsigned int puzzle = 0; puzzle < numPuzzles; ++puzzle) {
+		unsigned int first;
+		unsigned int last;
+		getIslandRange(puzzle, popSize, numPuzzles, &first, &last);
 		
-		// keep track of which partition each space belongs to
-		// and which partitions have white or black spaces
-		for (size_t i = 0; i < numSpaces; ++i) {
-			spacePartitionNumbers[localSpaceStartIndex + i] = -1;
-			whitePartitions[localSpaceStartIndex + i] = false;
-			blackPartitions[localSpaceStartIndex + i] = false;
-			searchStack[localSpaceStartIndex + i] = false;
+		FitnessStats localStats = reduceFitnessRange(fitness, first, last, partialStats);
+		if (get_local_id(0) == 0) {
+			localStats.solved = !solvedPuzzles[puzzle] && localStats.maxFitness == puzzles[puzzle].maxFitness;
+			if (localStats.solved) {
+				solvedPuzzles[puzzle] = 1;
+			}
+			puzzleStats[puzzle] = localStats;
+			
+			// (puzzles are in member order, so ties keep the lowest member)
+			if (localStats.maxFitness > totalStats.maxFitness) {
+				totalStats.maxFitness = localStats.maxFitness;
+				totalStats.maxMember = localStats.maxMember;
+			}
+			totalStats.minFitness = min(totalStats.minFitness, localStats.minFitness);
+			totalStats.totalFitness += localStats.totalFitness;
+			totalStats.solved = totalStats.solved && solvedPuzzles[puzzle];
+		}
+	}
+	
+	if (get_local_id(0) == 0) {
+		*stats = totalStats;
+	}
+}
+
+// replace each work item's value in local memory with the inclusive prefix
+// sum of the work group's values (every work item must call this)
+void scanChunkSums(__local unsigned int* chunkSums)
+{
+	unsigned int lid = get_local_id(0);
+	unsigned int numWorkItems = get_local_size(0);
+	for (unsigned int offset = 1; offset < numWorkItems; offset *= 2) {
+		unsigned int value = lid >= offset ? chunkSums[lid - offset] : 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+		chunkSums[lid] += value;
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Calculate the inclusive prefix sum of normalized fitness values
+/// 
+/// Fitness is normalized so that every member has a value of at least 1 (and
+/// so a chance of being selected). Must be run as a single work group: each
+/// work item sums a contiguous chunk of the population, the chunk sums are
+/// scanned in local memory, and each work item then writes the prefix sums of
+/// its own chunk.
+/// 
+/// \param [in] fitness the fitness values
+/// \param [in] popSize the population size
+/// \param [in] stats the fitness statistics (for the minimum fitness)
+/// 
+/// \param [in] chunkSums local scratch space for the chunk sums
+/// 
+/// \param [out] fitnessPrefix the prefix sums of the normalized fitness
+///////////////////////////////////////////////////////////////////////////////
+__kernel void scanFitness(
+	__global const int* fitness,
+	const unsigned int popSize,
+	__global const FitnessStats* stats,
+	__local unsigned int* chunkSums,
+	__global unsigned int* fitnessPrefix)
+{
+	int minFitness = stats->minFitness;
+	unsigned int lid = get_local_id(0);
+	unsigned int numWorkItems = get_local_size(0);
+	unsigned int chunkSize = (popSize + numWorkItems - 1)/numWorkItems;
+	unsigned int first = min(lid*chunkSize, popSize);
+	unsigned int last = min(first + chunkSize, popSize);
+	
+	// sum this work item's chunk
+	unsigned int chunkSum = 0;
+	for (unsigned int i = first; i < last; ++i) {
+		chunkSum += fitness[i] - minFitness + 1;
+	}
+	chunkSums[lid] = chunkSum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	
+	// inclusive scan of chunk sums
+	scanChunkSums(chunkSums);
+	
+	// write prefix sums of this work item's chunk
+	unsigned int runningSum = chunkSums[lid] - chunkSum;
+	for (unsigned int i = first; i < last; ++i) {
+		runningSum += fitness[i] - minFitness + 1;
+		fitnessPrefix[i] = runningSum;
+	}
+}
+
+// find the first member of a range whose fitness prefix sum is greater than a
+// target value (fitness-proportional selection)
+unsigned int findMate(
+	__global const unsigned int* fitnessPrefix,
+	const unsigned int first,
+	const unsigned int last,
+	const unsigned int target)
+{
+	unsigned int low = first;
+	unsigned int high = last - 1;
+	while (low < high) {
+		unsigned int middle = low + (high - low)/2;
+		if (fitnessPrefix[middle] > target) {
+			high = middle;
+		}
+		else {
+			low = middle + 1;
+		}
+	}
+	
+	return low;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Build a Walker alias table of the normalized fitness values of each
+/// island
+/// 
+/// Uses Vose's method with integer weights: each column holds the island's
+/// total weight, split between the column's own member and its alias (both
+/// relative to the start of the island). Must be run as one work group per
+/// island: the work items sum the weights and sort the members into underfull
+/// and full columns in parallel (each over a contiguous chunk of the island,
+/// placed in the worklist by a scan of the chunk counts), and the first work
+/// item then pairs the columns up, which is sequential. The table must match
+/// buildAliasTable in Selection.cpp.
+/// 
+/// \param [in] fitness the fitness values
+/// \param [in] popSize the population size
+/// \param [in] numIslands the number of islands
+/// \param [in] stats the fitness statistics
+/// 
+/// \param [in] chunkCounts local scratch space for the chunk sums and counts
+/// 
+/// \param [out] probabilities the weight of each column's own member
+/// \param [out] aliases the alias member of each column
+/// \param [out] worklist scratch space for the member indices
+/// \param [out] totals the total weight of each island
+///////////////////////////////////////////////////////////////////////////////
+__kernel void buildAliasTable(
+	__global const int* fitness,
+	const unsigned int popSize,
+	const unsigned int numIslands,
+	__global const FitnessStats* stats,
+	__local unsigned int* chunkCounts,
+	__global ulong* probabilities,
+	__global unsigned int* aliases,
+	__global unsigned int* worklist,
+	__global unsigned int* totals)
+{
+	unsigned int island = get_group_id(0);
+	unsigned int first;
+	unsigned int last;
+	getIslandRange(island, popSize, numIslands, &first, &last);
+	
+	// work with the island's part of each table
+	__global const int* islandFitness = fitness + first;
+	__global ulong* islandProbabilities = probabilities + first;
+	__global unsigned int* islandAliases = aliases + first;
+	__global unsigned int* islandWorklist = worklist + first;
+	unsigned int islandSize = last - first;
+	
+	unsigned int lid = get_local_id(0);
+	unsigned int numWorkItems = get_local_size(0);
+	unsigned int chunkSize = (islandSize + numWorkItems - 1)/numWorkItems;
+	unsigned int chunkFirst = min(lid*chunkSize, islandSize);
+	unsigned int chunkLast = min(chunkFirst + chunkSize, islandSize);
+	
+	// sum the island's weights
+	int minFitness = stats->minFitness;
+	unsigned int chunkWeight = 0;
+	for (unsigned int i = chunkFirst; i < chunkLast; ++i) {
+		chunkWeight += islandFitness[i] - minFitness + 1;
+	}
+	chunkCounts[lid] = chunkWeight;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	scanChunkSums(chunkCounts);
+	unsigned int totalWeight = chunkCounts[numWorkItems - 1];
+	barrier(CLK_LOCAL_MEM_FENCE);
+	
+	// scale weights by the island size so an average member fills exactly
+	// one column, and count the underfull columns of this chunk
+	unsigned int chunkSmall = 0;
+	for (unsigned int i = chunkFirst; i < chunkLast; ++i) {
+		ulong probability = (ulong)(unsigned int)(islandFitness[i] - minFitness + 1)*islandSize;
+		islandProbabilities[i] = probability;
+		islandAliases[i] = i;
+		if (probability < totalWeight) {
+			++chunkSmall;
+		}
+	}
+	chunkCounts[lid] = chunkSmall;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	scanChunkSums(chunkCounts);
+	
+	// sort members into underfull columns (stacked from the front of the
+	// worklist) and full ones (stacked from the back) in member order
+	unsigned int numSmall = chunkCounts[lid] - chunkSmall;
+	unsigned int numLarge = chunkFirst - numSmall;
+	for (unsigned int i = chunkFirst; i < chunkLast; ++i) {
+		if (islandProbabilities[i] < totalWeight) {
+			islandWorklist[numSmall++] = i;
 		}
+		else {
+			islandWorklist[islandSize - 1 - numLarge++] = i;
+		}
+	}
+	barrier(CLK_GLOBAL_MEM_FENCE);
+	
+	if (lid == 0) {
+		totals[island] = totalWeight;
+		numSmall = chunkCounts[numWorkItems - 1];
+		numLarge = islandSize - numSmall;
 		
-		// run depth-first search until all spaces are partitioned
-		char currentPartition = 0;
-		unsigned int stackSize = 0;
-		unsigned int partitionedSpaces = 0;
-		while (partitionedSpaces < numSpaces) {
-			// find starting point for search
-			unsigned int spaceIndex = 0;
-			while (spacePartitionNumbers[localSpaceStartIndex + spaceIndex] >= 0) {
-				++spaceIndex;
+		// top up each underfull column with the weight of a full member
+		while (numSmall > 0 && numLarge > 0) {
+			unsigned int small = islandWorklist[--numSmall];
+			unsigned int large = islandWorklist[islandSize - numLarge--];
+			islandAliases[small] = large;
+			ulong probability = islandProbabilities[large] + islandProbabilities[small] - totalWeight;
+			islandProbabilities[large] = probability;
+			if (probability < totalWeight) {
+				islandWorklist[numSmall++] = large;
+			}
+			else {
+				islandWorklist[islandSize - 1 - numLarge++] = large;
 			}
+		}
+		
+		// remaining columns are exactly full
+		while (numLarge > 0) {
+			islandProbabilities[islandWorklist[islandSize - numLarge--]] = totalWeight;
+		}
+		while (numSmall > 0) {
+			islandProbabilities[islandWorklist[--numSmall]] = totalWeight;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Select crossover mates by binary search of the fitness prefix sums
+/// (fitness-proportional selection)
+/// 
+/// Each work item decides whether one member crosses over. Members that
+/// don't are their own mate, which keeps all of their own genes, and mates
+/// are always from the member's own island.
+/// 
+/// \param [in] fitnessPrefix the prefix sums of the normalized fitness
+/// \param [in] popSize the population size
+/// \param [in] numIslands the number of islands
+/// \param [in] crossoverThreshold the crossover threshold for random words
+/// \param [in] seed the random seed
+/// \param [in] generation the current generation
+/// 
+/// \param [out] mates the mate of each member
+///////////////////////////////////////////////////////////////////////////////
+__kernel void selectRoulette(
+	__global const unsigned int* fitnessPrefix,
+	const unsigned int popSize,
+	const unsigned int numIslands,
+	const ulong crossoverThreshold,
+	const unsigned int seed,
+	const unsigned int generation,
+	__global unsigned int* mates)
+{
+	unsigned int gid = get_global_id(0);
+	if (gid < popSize) {
+		uint4 crossoverDraws = generateRandomWords(seed, STREAM_CROSSOVER, generation, gid, 0);
+		unsigned int mate = gid;
+		if ((ulong)crossoverDraws.x < crossoverThreshold) {
+			unsigned int first;
+			unsigned int last;
+			getIslandRange(getIsland(gid, popSize, numIslands), popSize, numIslands, &first, &last);
 			
-			// index is guaranteed to be valid since when all
-			// spaces are assigned this loop won't execute
-			searchStack[localSpaceStartIndex + stackSize] = spaceIndex;
-			++stackSize;
+			// the prefix sums cover the whole population, so offset the
+			// target by the sum before the island
+			unsigned int base = first > 0 ? fitnessPrefix[first - 1] : 0;
+			unsigned int islandFitness = fitnessPrefix[last - 1] - base;
+			mate = findMate(fitnessPrefix, first, last, base + (unsigned int)(((ulong)crossoverDraws.y*islandFitness) >> 32));
+		}
+		
+		mates[gid] = mate;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Select crossover mates from the Walker alias table of each island
+/// (fitness-proportional selection in constant time)
+/// 
+/// \param [in] probabilities the weight of each column's own member
+/// \param [in] aliases the alias member of each column
+/// \param [in] totals the total weight of each island
+/// \param [in] popSize the population size
+/// \param [in] numIslands the number of islands
+/// \param [in] crossoverThreshold the crossover threshold for random words
+/// \param [in] seed the random seed
+/// \param [in] generation the current generation
+/// 
+/// \param [out] mates the mate of each member
+///////////////////////////////////////////////////////////////////////////////
+__kernel void selectAlias(
+	__global const ulong* probabilities,
+	__global const unsigned int* aliases,
+	__global const unsigned int* totals,
+	const unsigned int popSize,
+	const unsigned int numIslands,
+	const ulong crossoverThreshold,
+	const unsigned int seed,
+	const unsigned int generation,
+	__global unsigned int* mates)
+{
+	unsigned int gid = get_global_id(0);
+	if (gid < popSize) {
+		uint4 crossoverDraws = generateRandomWords(seed, STREAM_CROSSOVER, generation, gid, 0);
+		unsigned int mate = gid;
+		if ((ulong)crossoverDraws.x < crossoverThreshold) {
+			unsigned int island = getIsland(gid, popSize, numIslands);
+			unsigned int first;
+			unsigned int last;
+			getIslandRange(island, popSize, numIslands, &first, &last);
 			
-			while (stackSize > 0) {
-				// pop space from stack
-				spaceIndex = searchStack[localSpaceStartIndex + stackSize - 1];
-				--stackSize;
-				
-				// assign partition number to current space and handle space value
-				spacePartitionNumbers[localSpaceStartIndex + spaceIndex] = currentPartition;
-				++partitionedSpaces;
-				switch (puzzleSpaces[spaceIndex]) {
-					case SPACE_WHITE:
-						whitePartitions[localSpaceStartIndex + currentPartition] = true;
-						break;
-					case SPACE_BLACK:
-						blackPartitions[localSpaceStartIndex + currentPartition] = true;
-						break;
-					default:
-						break;
+			unsigned int column = first + (unsigned int)(((ulong)crossoverDraws.y*(last - first)) >> 32);
+			ulong target = ((ulong)crossoverDraws.w*totals[island]) >> 32;
+			mate = target < probabilities[column] ? column : first + aliases[column];
+		}
+		
+		mates[gid] = mate;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Select crossover mates as the fittest of a number of uniformly
+/// drawn members of the same island (ties keep the first candidate drawn)
+/// 
+/// \param [in] fitness the fitness values
+/// \param [in] tournamentSize the number of candidates
+/// \param [in] popSize the population size
+/// \param [in] numIslands the number of islands
+/// \param [in] crossoverThreshold the crossover threshold for random words
+/// \param [in] seed the random seed
+/// \param [in] generation the current generation
+/// 
+/// \param [out] mates the mate of each member
+///////////////////////////////////////////////////////////////////////////////
+__kernel void selectTournament(
+	__global const int* fitness,
+	const unsigned int tournamentSize,
+	const unsigned int popSize,
+	const unsigned int numIslands,
+	const ulong crossoverThreshold,
+	const unsigned int seed,
+	const unsigned int generation,
+	__global unsigned int* mates)
+{
+	unsigned int gid = get_global_id(0);
+	if (gid < popSize) {
+		uint4 crossoverDraws = generateRandomWords(seed, STREAM_CROSSOVER, generation, gid, 0);
+		unsigned int mate = gid;
+		if ((ulong)crossoverDraws.x < crossoverThreshold) {
+			unsigned int first;
+			unsigned int last;
+			getIslandRange(getIsland(gid, popSize, numIslands), popSize, numIslands, &first, &last);
+			
+			// each block of selection draws covers four candidates
+			uint4 draws;
+			for (unsigned int i = 0; i < tournamentSize; ++i) {
+				if (i%4 == 0) {
+					draws = generateRandomWords(seed, STREAM_SELECTION, generation, gid, i/4);
 				}
 				
-				// check if reachable neighboring spaces need to be processed
-				unsigned int spaceRow = getSpaceRow(spaceIndex, puzzleWidth);
-				unsigned int spaceCol = getSpaceCol(spaceIndex, puzzleWidth);
-				
-				// space row/col coordinates correspond to the same coordinates of the upper-left point on the space
-				if (spaceRow > 0 && spacePartitionNumbers[localSpaceStartIndex + getSpaceIndex(spaceRow - 1, spaceCol, puzzleWidth)] == -1
-				                 && !visitedEdges[localEdgeStartIndex + getEdgeIndex(spaceRow, spaceCol, spaceRow, spaceCol + 1, puzzleWidth)]) {
-					searchStack[localSpaceStartIndex + stackSize] = getSpaceIndex(spaceRow - 1, spaceCol, puzzleWidth);
-					++stackSize;
-				}
-				if (spaceRow < puzzleHeight - 2 && spacePartitionNumbers[localSpaceStartIndex + getSpaceIndex(spaceRow + 1, spaceCol, puzzleWidth)] == -1
-				                               && !visitedEdges[localEdgeStartIndex + getEdgeIndex(spaceRow + 1, spaceCol, spaceRow + 1, spaceCol + 1, puzzleWidth)]) {
-					searchStack[localSpaceStartIndex + stackSize] = getSpaceIndex(spaceRow + 1, spaceCol, puzzleWidth);
-					++stackSize;
+				uint draw = i%4 == 0 ? draws.x : (i%4 == 1 ? draws.y : (i%4 == 2 ? draws.z : draws.w));
+				unsigned int candidate = first + (unsigned int)(((ulong)draw*(last - first)) >> 32);
+				if (i == 0 || fitness[candidate] > fitness[mate]) {
+					mate = candidate;
 				}
-				if (spaceCol > 0 && spacePartitionNumbers[localSpaceStartIndex + getSpaceIndex(spaceRow, spaceCol - 1, puzzleWidth)] == -1
-				                 && !visitedEdges[localEdgeStartIndex + getEdgeIndex(spaceRow, spaceCol, spaceRow + 1, spaceCol, puzzleWidth)]) {
-					searchStack[localSpaceStartIndex + stackSize] = getSpaceIndex(spaceRow, spaceCol - 1, puzzleWidth);
-					++stackSize;
-				}
-				if (spaceCol < puzzleWidth - 2 && spacePartitionNumbers[localSpaceStartIndex + getSpaceIndex(spaceRow, spaceCol + 1, puzzleWidth)] == -1
-				                              && !visitedEdges[localEdgeStartIndex + getEdgeIndex(spaceRow, spaceCol + 1, spaceRow + 1, spaceCol + 1, puzzleWidth)]) {
-					searchStack[localSpaceStartIndex + stackSize] = getSpaceIndex(spaceRow, spaceCol + 1, puzzleWidth);
-					++stackSize;
+			}
+		}
+		
+		mates[gid] = mate;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Copy out the fittest members of each island and find the weakest
+/// members they will replace
+/// 
+/// Each work item handles one island, and nothing is replaced until every
+/// island's emigrants have been copied (by receiveImmigrants). Must match
+/// HostGeneticSolver::migrateMembers.
+/// 
+/// \param [in] population the current population data
+/// \param [in] fitness the fitness values
+/// \param [in] popSize the population size
+/// \param [in] maxLength the max number of moves of each population member
+/// \param [in] numIslands the number of islands
+/// \param [in] numMigrants the number of migrants per island
+/// 
+/// \param [out] emigrants the population data of each island's emigrants
+/// \param [out] emigrantFitness the fitness of each island's emigrants
+/// \param [out] replaced the members replaced in each island
+///////////////////////////////////////////////////////////////////////////////
+__kernel void collectEmigrants(
+	__global const unsigned char* population,
+	__global const int* fitness,
+	const unsigned int popSize,
+	const unsigned int maxLength,
+	const unsigned int numIslands,
+	const unsigned int numMigrants,
+	__global unsigned char* emigrants,
+	__global int* emigrantFitness,
+	__global unsigned int* replaced)
+{
+	unsigned int island = get_global_id(0);
+	if (island < numIslands) {
+		unsigned int first;
+		unsigned int last;
+		getIslandRange(island, popSize, numIslands, &first, &last);
+		unsigned int genomeBytes = getGenomeBytes(maxLength);
+		
+		// each pass finds the fittest member ranked after the previous one
+		// (ties keep the lowest index)
+		unsigned int previous = first;
+		for (unsigned int i = 0; i < numMigrants; ++i) {
+			unsigned int best = first;
+			bool found = false;
+			for (unsigned int j = first; j < last; ++j) {
+				bool afterPrevious = i == 0
+				                     || fitness[j] < fitness[previous]
+				                     || (fitness[j] == fitness[previous] && j > previous);
+				if (afterPrevious && (!found || fitness[j] > fitness[best])) {
+					best = j;
+					found = true;
 				}
 			}
 			
-			++currentPartition;
+			unsigned int emigrant = island*numMigrants + i;
+			for (unsigned int j = 0; j < genomeBytes; ++j) {
+				emigrants[emigrant*genomeBytes + j] = population[getByteIndex(best, j, popSize, genomeBytes)];
+			}
+			emigrantFitness[emigrant] = fitness[best];
+			previous = best;
 		}
 		
-		// each white/black space in a valid partition earns 1 fitness point
-		for (size_t i = 0; i < numSpaces; ++i) {
-			char partition = spacePartitionNumbers[localSpaceStartIndex + i];
-			switch (puzzleSpaces[i]) {
-				case SPACE_WHITE:
-					if (whitePartitions[localSpaceStartIndex + partition] && !blackPartitions[localSpaceStartIndex + partition]) {
-						++fitnessValue;
-					}
-					break;
-				case SPACE_BLACK:
-					if (blackPartitions[localSpaceStartIndex + partition] && !whitePartitions[localSpaceStartIndex + partition]) {
-						++fitnessValue;
-					}
-					break;
-				default:
-					break;
+		// each pass finds the weakest member ranked after the previous one
+		// (scanning backwards so ties keep the highest index)
+		for (unsigned int i = 0; i < numMigrants; ++i) {
+			unsigned int worst = first;
+			bool found = false;
+			for (unsigned int j = last; j > first; --j) {
+				unsigned int member = j - 1;
+				bool afterPrevious = i == 0
+				                     || fitness[member] > fitness[previous]
+				                     || (fitness[member] == fitness[previous] && member < previous);
+				if (afterPrevious && (!found || fitness[member] < fitness[worst])) {
+					worst = member;
+					found = true;
+				}
 			}
+			
+			replaced[island*numMigrants + i] = worst;
+			previous = worst;
 		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Replace the weakest members of each island with the emigrants of
+/// the island a given distance behind it (in rank order)
+/// 
+/// Each work item copies one migrant, along with its fitness so selection
+/// in the same generation sees it (the minimum fitness is lowered if the
+/// migrant is less fit than every member).
+/// 
+/// \param [in] emigrants the population data of each island's emigrants
+/// \param [in] emigrantFitness the fitness of each island's emigrants
+/// \param [in] replaced the members replaced in each island
+/// \param [in] popSize the population size
+/// \param [in] maxLength the max number of moves of each population member
+/// \param [in] numIslands the number of islands
+/// \param [in] numMigrants the number of migrants per island
+/// \param [in] shift the distance (in islands) that emigrants travel
+/// 
+/// \param [in,out] population the current population data
+/// \param [in,out] fitness the fitness values
+/// \param [in,out] stats the fitness statistics
+///////////////////////////////////////////////////////////////////////////////
+__kernel void receiveImmigrants(
+	__global const unsigned char* emigrants,
+	__global const int* emigrantFitness,
+	__global const unsigned int* replaced,
+	const unsigned int popSize,
+	const unsigned int maxLength,
+	const unsigned int numIslands,
+	const unsigned int numMigrants,
+	const unsigned int shift,
+	__global unsigned char* population,
+	__global int* fitness,
+	__global FitnessStats* stats)
+{
+	unsigned int gid = get_global_id(0);
+	if (gid < numIslands*numMigrants) {
+		unsigned int island = gid/numMigrants;
+		unsigned int source = (island + numIslands - shift)%numIslands;
+		unsigned int emigrant = source*numMigrants + gid%numMigrants;
+		unsigned int member = replaced[gid];
+		unsigned int genomeBytes = getGenomeBytes(maxLength);
+		for (unsigned int j = 0; j < genomeBytes; ++j) {
+			population[getByteIndex(member, j, popSize, genomeBytes)] = emigrants[emigrant*genomeBytes + j];
+		}
+		fitness[member] = emigrantFitness[emigrant];
+		atomic_min(&stats->minFitness, emigrantFitness[emigrant]);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Generate the next population via crossover/mutation
+/// 
+/// Each work item creates one member of the next population, taking its
+/// mate's genes up to (and including) a random crossover point (a member
+/// that doesn't cross over is its own mate). Every gene of the new member
+/// can then mutate. The start selector counts as gene 0 and move gene i as
+/// gene i + 1, and move genes are unpacked and repacked a byte at a time.
+/// All random values only depend on the seed, the
+/// generation and the member, so the result is the same for any work-group
+/// size (and matches HostGeneticSolver).
+/// 
+/// \param [in] population the current population data
+/// \param [in] mates the mate of each member
+/// \param [in] popSize the population size
+/// \param [in] maxLength the max number of moves of each population member
+/// \param [in] mutationThreshold the mutation threshold for random words
+/// \param [in] seed the random seed
+/// \param [in] generation the current generation
+/// 
+/// \param [out] nextPopulation the next population data
+///////////////////////////////////////////////////////////////////////////////
+__kernel void reproducePopulation(
+	__global const unsigned char* population,
+	__global const unsigned int* mates,
+	const unsigned int popSize,
+	const unsigned int maxLength,
+	const ulong mutationThreshold,
+	const unsigned int seed,
+	const unsigned int generation,
+	__global unsigned char* nextPopulation)
+{
+	unsigned int gid = get_global_id(0);
+	if (gid < popSize) {
+		uint4 crossoverDraws = generateRandomWords(seed, STREAM_CROSSOVER, generation, gid, 0);
+		unsigned int mate = mates[gid];
+		unsigned int genomeBytes = getGenomeBytes(maxLength);
+		unsigned int crossoverPoint = crossoverDraws.z%(maxLength + 1);
 		
-		fitness[gid] = fitnessValue;
+		// each block of mutation draws covers two genes
+		uint4 mutationDraws;
+		unsigned char genes = 0;
+		unsigned char mateGenes = 0;
+		unsigned char nextGenes = 0;
+		for (unsigned int i = 0; i <= maxLength; ++i) {
+			unsigned char gene;
+			unsigned int shift = 0;
+			if (i == 0) {
+				genes = population[getByteIndex(gid, 0, popSize, genomeBytes)];
+				mateGenes = population[getByteIndex(mate, 0, popSize, genomeBytes)];
+				gene = i > crossoverPoint ? genes : mateGenes;
+			}
+			else {
+				unsigned int move = i - 1;
+				shift = 2*(move%PACKED_MOVES_PER_BYTE);
+				if (shift == 0) {
+					genes = population[getByteIndex(gid, 1 + move/PACKED_MOVES_PER_BYTE, popSize, genomeBytes)];
+					mateGenes = population[getByteIndex(mate, 1 + move/PACKED_MOVES_PER_BYTE, popSize, genomeBytes)];
+				}
+				gene = ((i > crossoverPoint ? genes : mateGenes) >> shift) & 3;
+			}
+			
+			if (i%2 == 0) {
+				mutationDraws = generateRandomWords(seed, STREAM_MUTATION, generation, gid, i/2);
+			}
+			uint decision = i%2 == 0 ? mutationDraws.x : mutationDraws.z;
+			uint value = i%2 == 0 ? mutationDraws.y : mutationDraws.w;
+			if ((ulong)decision < mutationThreshold) {
+				gene = i == 0 ? value%UCHAR_MAX : value%NUM_POSSIBLE_MOVES;
+			}
+			
+			// output the start selector, or each byte of move genes once it's
+			// full (or the genome ends)
+			if (i == 0) {
+				nextPopulation[getByteIndex(gid, 0, popSize, genomeBytes)] = gene;
+			}
+			else {
+				nextGenes |= gene << shift;
+				if (shift == 2*(PACKED_MOVES_PER_BYTE - 1) || i == maxLength) {
+					nextPopulation[getByteIndex(gid, 1 + (i - 1)/PACKED_MOVES_PER_BYTE, popSize, genomeBytes)] = nextGenes;
+					nextGenes = 0;
+				}
+			}
+		}
 	}
 }
\ No newline at end of file
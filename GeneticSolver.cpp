@@ -7,38 +7,177 @@
 
 #include "GeneticSolver.h"
 
+#include "Genome.h"
 #include "Path.h"
+#include "Philox.h"
 #include "Puzzle.h"
 
-#include <climits>
+// kernel source embedded at build time (generated from GeneticSolver.cl)
+#include "GeneticSolverSource.h"
+
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
-#include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <exception>
 #include <stdexcept>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
 
-// selected to fit under local memory size constraints
+// work group size of the kernels with one work item per member (the
+// evaluation kernel starts with this size until it is tuned, if it fits
+// under local memory size constraints)
 #define LOCAL_WORK_SIZE 32
 
+// number of timed evaluation runs per candidate work group size when tuning
+#define TUNING_RUNS 3
+
+// max number of work items in kernels that run as a single work group
+// (fitness reduction and prefix sum)
+#define SINGLE_GROUP_WORK_SIZE 256
+
+// number of bits in each word of the evaluation kernel's scratch bitsets
+#define BITSET_WORD_BITS 32
+
+// number of candidates drawn for tournament selection unless configured
+#define DEFAULT_TOURNAMENT_SIZE 4
+
 namespace gws
 {
-	GeneticSolver::GeneticSolver(size_t puzzleWidth, size_t puzzleHeight, size_t populationSize, size_t maxIterations, float crossoverRate, float mutationRate, unsigned int seed)
+	// evaluation work group sizes chosen for each device, puzzle size,
+	// program variant, population layout, kernel (single puzzle or batch) and
+	// population size (rounded up to a power of two)
+	// (shared by every solver in the process so each combination is only
+	// tuned once)
+	static std::map<std::tuple<cl_device_id, size_t, size_t, bool, PopulationLayout, bool, size_t>, size_t> s_tunedWorkSizes;
+	static std::mutex s_tunedWorkSizesMutex;
+	
+	// number of words in one of the evaluation kernel's scratch bitsets
+	static size_t getBitsetWords(size_t numBits)
+	{
+		return (numBits + BITSET_WORD_BITS - 1)/BITSET_WORD_BITS;
+	}
+	
+	// packed paths can't count more moves than their header holds (a path
+	// has fewer moves than the puzzle has points)
+	static void checkPackedPathLength(size_t numPoints)
+	{
+		if (numPoints > ((size_t)1 << (8*PATH_HEADER_BYTES))) {
+			throw std::runtime_error("Puzzle has too many points for packed paths");
+		}
+	}
+	
+	GeneticSolver::GeneticSolver(size_t puzzleWidth, size_t puzzleHeight, size_t populationSize, size_t maxIterations, float crossoverRate, float mutationRate, unsigned int seed, PopulationLayout populationLayout)
 		: m_puzzleWidth(puzzleWidth),
 		  m_puzzleHeight(puzzleHeight),
 		  m_numPuzzlePoints(Puzzle::getNumPoints(puzzleWidth, puzzleHeight)),
 		  m_numPuzzleEdges(Puzzle::getNumEdges(puzzleWidth, puzzleHeight)),
 		  m_numPuzzleSpaces(Puzzle::getNumSpaces(puzzleWidth, puzzleHeight)),
+		  m_genomeBytes(getGenomeBytes(m_numPuzzlePoints)),
+		  m_pathBytes(getPackedPathBytes(m_numPuzzlePoints)),
 		  m_populationSize(populationSize),
 		  m_maxIterations(maxIterations),
 		  m_crossoverRate(crossoverRate),
 		  m_mutationRate(mutationRate),
-		  m_seed(seed)
+		  m_seed(seed),
+		  m_populationLayout(populationLayout),
+		  m_selectionMethod(SelectionMethod::ROULETTE),
+		  m_tournamentSize(DEFAULT_TOURNAMENT_SIZE),
+		  m_numIslands(1),
+		  m_migrationInterval(0),
+		  m_numMigrants(0),
+		  m_migrationTopology(MigrationTopology::RING),
+		  m_islandExchange(NULL),
+		  m_island(0),
+		  m_numIterations(0),
+		  m_generationTime(0.0f),
+		  m_selectionTime(0.0f),
+		  m_specializedEvaluation(false),
+		  m_bufferPool(NULL),
+		  m_shardPopulation(NULL),
+		  m_memberPath(NULL),
+		  m_hostPointCapacity(0),
+		  m_evaluateKernel(0),
+		  m_evaluateWorkSize(LOCAL_WORK_SIZE),
+		  m_workSizesTuned(false),
+		  m_batchPointBuffer(0),
+		  m_batchEdgeBuffer(0),
+		  m_batchSpaceBuffer(0),
+		  m_batchPuzzleBuffer(0),
+		  m_solvedPuzzleBuffer(0)
 	{
+		checkPackedPathLength(m_numPuzzlePoints);
+		
 		// initialize OpenCL components
 		initDeviceContextAndQueue();
 		initBuffers();
 		initProgramAndKernels();
+		initShards();
+		createEvaluateKernels();
+		reserveHostMemory(m_numPuzzlePoints);
+	}
+	
+	GeneticSolver::GeneticSolver(const GeneticSolver& parent, size_t island, size_t populationSize, cl_device_id deviceID,
+	                             cl_context context, cl_program program)
+		: m_puzzleWidth(parent.m_puzzleWidth),
+		  m_puzzleHeight(parent.m_puzzleHeight),
+		  m_numPuzzlePoints(parent.m_numPuzzlePoints),
+		  m_numPuzzleEdges(parent.m_numPuzzleEdges),
+		  m_numPuzzleSpaces(parent.m_numPuzzleSpaces),
+		  m_genomeBytes(parent.m_genomeBytes),
+		  m_pathBytes(parent.m_pathBytes),
+		  m_populationSize(populationSize),
+		  m_maxIterations(parent.m_maxIterations),
+		  m_crossoverRate(parent.m_crossoverRate),
+		  m_mutationRate(parent.m_mutationRate),
+		  m_seed(getIslandSeed(parent.m_seed, island)),
+		  m_populationLayout(parent.m_populationLayout),
+		  m_selectionMethod(parent.m_selectionMethod),
+		  m_tournamentSize(parent.m_tournamentSize),
+		  m_numIslands(1),
+		  m_migrationInterval(parent.m_migrationInterval),
+		  m_numMigrants(parent.m_numMigrants),
+		  m_migrationTopology(parent.m_migrationTopology),
+		  m_islandExchange(NULL),
+		  m_island(island),
+		  m_numIterations(0),
+		  m_generationTime(0.0f),
+		  m_selectionTime(0.0f),
+		  m_specializedEvaluation(parent.m_specializedEvaluation),
+		  m_deviceID(deviceID),
+		  m_context(context),
+		  m_bufferPool(NULL),
+		  m_shardPopulation(NULL),
+		  m_memberPath(NULL),
+		  m_hostPointCapacity(0),
+		  m_program(program),
+		  m_evaluateKernel(0),
+		  m_evaluateWorkSize(LOCAL_WORK_SIZE),
+		  m_workSizesTuned(false),
+		  m_batchPointBuffer(0),
+		  m_batchEdgeBuffer(0),
+		  m_batchSpaceBuffer(0),
+		  m_batchPuzzleBuffer(0),
+		  m_solvedPuzzleBuffer(0)
+	{
+		// the context and program stay alive until every solver sharing them
+		// releases them
+		m_lastErrNum = clRetainContext(m_context);
+		checkLastErr("clRetainContext");
+		m_lastErrNum = clRetainProgram(m_program);
+		checkLastErr("clRetainProgram");
+		
+		// initialize the island's own OpenCL components
+		initQueues();
+		initBuffers();
+		initKernels();
+		createEvaluateKernels();
+		reserveHostMemory(m_numPuzzlePoints);
 	}
 	
 	GeneticSolver::~GeneticSolver()
@@ -49,150 +188,431 @@ namespace gws
 	
 	bool GeneticSolver::solvePuzzle(const Puzzle& puzzle, Path& path)
 	{
-		// transfer puzzle data to device
-		transferPuzzleData(puzzle);
+		// islands evolve as separate solvers on their own threads
+		if (m_numIslands > 1) {
+			return solveIslands(puzzle, path);
+		}
+		
+		preparePuzzle(puzzle);
 		
 		// find the max fitness value of the puzzle
 		int maxPuzzleFitness = calcMaxFitness(puzzle);
 		std::cout << "Max puzzle fitness is " << maxPuzzleFitness << std::endl;
-		// seed random number generator
-		srand(m_seed);
 		
-		// randomly generate initial population (TODO: move to deivce)
-		size_t totalPopulationBytes = m_populationSize*m_numPuzzlePoints;
-		unsigned char* population = new unsigned char[totalPopulationBytes];
-		for (size_t i = 0; i < totalPopulationBytes; ++i) {
-			population[i] = (unsigned char)(rand() % UCHAR_MAX);
+		return evolvePopulation(maxPuzzleFitness, path);
+	}
+	
+	size_t GeneticSolver::solvePuzzles(const std::vector<const Puzzle*>& puzzles, const std::vector<Path*>& paths, std::vector<BatchResult>& results)
+	{
+		size_t numPuzzles = puzzles.size();
+		results.clear();
+		if (numPuzzles == 0) {
+			return 0;
+		}
+		if (paths.size() != numPuzzles) {
+			throw std::runtime_error("Batch needs one path per puzzle");
 		}
 		
-		// iterate over each generation until a correct solution is found or max iterations is reached
-		bool solutionFound = false;
-		m_numIterations = 0;
-		int* fitness = new int[m_populationSize];
-		unsigned int* startPoints = new unsigned int[m_populationSize];
-		char* paths = new char[totalPopulationBytes];
-		size_t maxMember = 0;
-		while (!solutionFound && m_numIterations < m_maxIterations) {
-			runEvaluationKernel(population, fitness, startPoints, paths);
-			
-			// check for correct solution (break early if solution found)
-			size_t currentMember = 0;
-			int totalFitness = 0;
-			int currentFitness = 0;
-			int currentMinFitness = INT_MAX;
-			int currentMaxFitness = INT_MIN;
-			while (!solutionFound && currentMember < m_populationSize) {
-				currentFitness = fitness[currentMember];
-				if (currentFitness == maxPuzzleFitness) {
-					fillPath(paths, startPoints, currentMember, m_numPuzzlePoints, path);
-					solutionFound = true;
+		// every puzzle's island needs at least two members
+		if (m_populationSize/numPuzzles < 2) {
+			throw std::runtime_error("Population is too small to split between the batch puzzles");
+		}
+		
+		// size the solver for the largest puzzle of the batch (every other
+		// puzzle fits in its genomes, paths and scratch space)
+		size_t batchWidth = 0;
+		size_t batchHeight = 0;
+		for (size_t i = 0; i < numPuzzles; ++i) {
+			batchWidth = std::max(batchWidth, puzzles[i]->getWidth());
+			batchHeight = std::max(batchHeight, puzzles[i]->getHeight());
+		}
+		if (batchWidth != m_puzzleWidth || batchHeight != m_puzzleHeight) {
+			resizePuzzle(batchWidth, batchHeight);
+		}
+		
+		// release the batch buffers and restore the island model however the
+		// solve ends (an error would otherwise leave the solver in batch mode
+		// and the buffers acquired)
+		struct BatchScope
+		{
+			GeneticSolver& solver;
+			size_t numIslands;
+			size_t migrationInterval;
+			size_t numMigrants;
+			
+			~BatchScope()
+			{
+				try {
+					solver.releaseBatchBuffers();
+					solver.setIslandModel(numIslands, migrationInterval, numMigrants, solver.m_migrationTopology);
 				}
-				
-				// collect fitness metrics to assist with crossover phase
-				totalFitness += currentFitness;
-				if (currentFitness < currentMinFitness) {
-					currentMinFitness = currentFitness;
+				catch (const std::exception&) {
+					// (the solve's own error is the one reported)
 				}
-				if (currentFitness > currentMaxFitness) {
-					currentMaxFitness = currentFitness;
-					maxMember = currentMember;
+			}
+		} batchScope = { *this, m_numIslands, m_migrationInterval, m_numMigrants };
+		
+		// transfer the concatenated puzzle data to the device
+		transferBatchPuzzleData(puzzles, results);
+		std::cout << "Solving a batch of " << numPuzzles << " puzzles" << std::endl;
+		
+		// each puzzle's members evolve as a separate island
+		setIslandModel(numPuzzles, 0, 0, m_migrationTopology);
+		
+		// randomly generate initial population on the device
+		auto start = std::chrono::high_resolution_clock::now();
+		m_selectionTime = 0.0f;
+		runGenerationKernel();
+		enqueueBatchEvaluation(m_generationBuffers[0], numPuzzles);
+		
+		// iterate over each generation until every puzzle is solved or max
+		// iterations is reached
+		size_t numSolved = 0;
+		m_numIterations = 0;
+		char* memberPath = m_memberPath;
+		unsigned int startPoint;
+		while (numSolved < numPuzzles && m_numIterations < m_maxIterations) {
+			GenerationBuffers& current = m_generationBuffers[m_numIterations%2];
+			GenerationBuffers& next = m_generationBuffers[(m_numIterations + 1)%2];
+			
+			// queue up the next generation before waiting on this one (as in
+			// solvePuzzle)
+			if (m_numIterations + 1 < m_maxIterations) {
+				runReproductionKernels(current);
+				enqueueBatchEvaluation(next, numPuzzles);
+			}
+			
+			waitForStats(current);
+			
+			// record the puzzles solved by this generation (the first member
+			// of a puzzle with its max fitness is its solution)
+			for (size_t i = 0; i < numPuzzles; ++i) {
+				const FitnessStats& stats = current.hostPuzzleStats[i];
+				BatchResult& result = results[i];
+				if (!result.solved) {
+					result.maxFitness = std::max(result.maxFitness, (int)stats.maxFitness);
+					result.numIterations = m_numIterations + 1;
+					if (stats.solved) {
+						readMember(current, stats.maxMember, memberPath, startPoint);
+						fillPath(memberPath, startPoint, m_numPuzzlePoints, *paths[i]);
+						result.solved = true;
+						++numSolved;
+					}
 				}
-				
-				++currentMember;
 			}
 			
 			if (m_numIterations % 100 == 0) {
-				std::cout << m_numIterations << " | current max: " << currentMaxFitness << " | start: " << startPoints[maxMember] << " | path: " << paths + (maxMember*m_numPuzzlePoints) << std::endl;
+				std::cout << m_numIterations << " | puzzles solved: " << numSolved << "/" << numPuzzles << std::endl;
 			}
 			
-			// generate next population via crossover/mutation (TODO: move to device)
-			if (!solutionFound) {
-				// normalize fitness so that all values are positive
-				// (need at least 1 to have chance of being chosen)
-				totalFitness = totalFitness - currentMinFitness + 1;
-				
-				// randomly crossover population according to crossover rate
-				for (size_t i = 0; i < m_populationSize; ++i) {
-					float crossoverDecision = (float)rand()/RAND_MAX;
-					if (crossoverDecision <= m_crossoverRate) {
-						size_t mate = 0;
-						float fitnessCount = 0.0f;
-						float fitnessDecision = ((float)rand()/RAND_MAX)*totalFitness;
-						bool mateFound = false;
-						while (!mateFound && mate < m_populationSize) {
-							// normalize fitness so that all values are positive
-							// (need at least 1 to have chance of being chosen)
-							fitnessCount += fitness[mate] - currentMinFitness + 1;
-							if (fitnessCount >= fitnessDecision) {
-								mateFound = true;
-							}
-							else {
-								++mate;
-							}
-						}
-						
-						// perform single-point crossover
-						size_t crossoverPoint = rand()%m_numPuzzlePoints;
-						for (size_t j = 0; j < m_numPuzzlePoints; ++j) {
-							size_t destinationIndex = i*m_numPuzzlePoints + j;
-							size_t parentIndex1 = destinationIndex;
-							size_t parentIndex2 = mate*m_numPuzzlePoints + j;
-							
-							// "mate" is more likely to have a high fitness, so use it as the starting parent
-							if (j > crossoverPoint) {
-								population[destinationIndex] = population[parentIndex1];
-							}
-							else {
-								population[destinationIndex] = population[parentIndex2];
-							}
-						}
-					}
+			++m_numIterations;
+		}
+		
+		// wait for any generation that was queued but not needed
+		m_lastErrNum = clFinish(m_queue);
+		checkLastErr("clFinish");
+		for (size_t i = 0; i < 2; ++i) {
+			waitForStats(m_generationBuffers[i]);
+			recordSelectionTime(m_generationBuffers[i]);
+		}
+		
+		auto stop = std::chrono::high_resolution_clock::now();
+		m_generationTime = std::chrono::duration<float>(stop - start).count()*1000.0f;
+		
+		return numSolved;
+	}
+	
+	void GeneticSolver::preparePuzzle(const Puzzle& puzzle)
+	{
+		// a puzzle of another size only resizes the buffers that depend on it
+		if (puzzle.getWidth() != m_puzzleWidth || puzzle.getHeight() != m_puzzleHeight) {
+			resizePuzzle(puzzle.getWidth(), puzzle.getHeight());
+		}
+		
+		// transfer puzzle data to device
+		transferPuzzleData(puzzle);
+		
+		// pick the evaluation work group sizes for the puzzle (before timing
+		// the generations)
+		if (!m_workSizesTuned) {
+			tuneWorkSizes();
+			m_workSizesTuned = true;
+		}
+	}
+	
+	bool GeneticSolver::evolvePopulation(int maxPuzzleFitness, Path& path)
+	{
+		// randomly generate initial population on the device (the population
+		// stays on the device for every generation)
+		auto start = std::chrono::high_resolution_clock::now();
+		m_selectionTime = 0.0f;
+		runGenerationKernel();
+		enqueueEvaluation(m_generationBuffers[0], maxPuzzleFitness);
+		finishEvaluation(m_generationBuffers[0], maxPuzzleFitness);
+		
+		// iterate over each generation until a correct solution is found or max iterations is reached (or
+		// another island found a solution in an earlier generation)
+		bool solutionFound = false;
+		m_numIterations = 0;
+		char* memberPath = m_memberPath;
+		memberPath[m_numPuzzlePoints] = (char)MoveValue::NONE;
+		unsigned int startPoint;
+		while (!solutionFound && m_numIterations < m_maxIterations
+		       && (m_islandExchange == NULL || m_islandExchange->isRunning(m_numIterations))) {
+			GenerationBuffers& current = m_generationBuffers[m_numIterations%2];
+			GenerationBuffers& next = m_generationBuffers[(m_numIterations + 1)%2];
+			
+			// queue up the next generation before waiting on this one so the
+			// device stays busy while the host handles the results (the next
+			// generation is discarded if this one is solved)
+			if (m_numIterations + 1 < m_maxIterations) {
+				runReproductionKernels(current);
+				enqueueEvaluation(next, maxPuzzleFitness);
+			}
+			
+			waitForStats(current);
+			
+			// check for correct solution (the first member with the max
+			// fitness is the solution)
+			if (current.stats.solved) {
+				readMember(current, current.stats.maxMember, memberPath, startPoint);
+				fillPath(memberPath, startPoint, m_numPuzzlePoints, path);
+				solutionFound = true;
+				if (m_islandExchange != NULL) {
+					m_islandExchange->recordSolution(m_island, m_numIterations);
 				}
-				
-				// randomly mutate population according to mutation rate
-				for (size_t i = 0; i < totalPopulationBytes; ++i) {
-					float mutationDecision = (float)rand()/RAND_MAX;
-					if (mutationDecision <= m_mutationRate) {
-						population[i] = (unsigned char)(rand() % UCHAR_MAX);
-					}
+			}
+			
+			if (m_numIterations % 100 == 0) {
+				// only the displayed path is read back from the device (islands
+				// print whole lines, so lines from different islands don't
+				// interleave)
+				readMember(current, current.stats.maxMember, memberPath, startPoint);
+				std::ostringstream progress;
+				if (m_islandExchange != NULL) {
+					progress << "island " << m_island << " | ";
 				}
+				progress << m_numIterations << " | current max: " << current.stats.maxFitness << " | start: " << startPoint << " | path: " << memberPath << std::endl;
+				std::cout << progress.str() << std::flush;
+			}
+			
+			// the other devices evaluate their shares of the next generation
+			// only after this one has been handled (waiting on them doesn't
+			// hold up the results)
+			if (!solutionFound) {
+				finishEvaluation(next, maxPuzzleFitness);
 			}
 			
 			++m_numIterations;
 		}
 		
-		delete [] population;
-		delete [] fitness;
-		delete [] startPoints;
-		delete [] paths;
+		// wait for any generation that was queued but not needed
+		m_lastErrNum = clFinish(m_queue);
+		checkLastErr("clFinish");
+		for (size_t i = 0; i < 2; ++i) {
+			GenerationBuffers& buffers = m_generationBuffers[i];
+			if (buffers.populationEvent != 0) {
+				clReleaseEvent(buffers.populationEvent);
+				buffers.populationEvent = 0;
+			}
+			waitForStats(buffers);
+			recordSelectionTime(buffers);
+		}
+		
+		auto stop = std::chrono::high_resolution_clock::now();
+		m_generationTime = std::chrono::duration<float>(stop - start).count()*1000.0f;
+		
+		return solutionFound;
+	}
+	
+	bool GeneticSolver::solveIslands(const Puzzle& puzzle, Path& path)
+	{
+		if (m_islandSolvers.empty()) {
+			createIslandSolvers();
+		}
+		
+		// find the max fitness value of the puzzle
+		int maxPuzzleFitness = calcMaxFitness(puzzle);
+		std::cout << "Max puzzle fitness is " << maxPuzzleFitness << std::endl;
+		
+		// prepare every island's device for the puzzle before any island
+		// starts (each island has its own path for a solution)
+		size_t numPuzzlePoints = puzzle.getNumPoints();
+		std::vector<std::vector<char>> islandMoves(m_numIslands, std::vector<char>(numPuzzlePoints));
+		std::vector<Path> islandPaths;
+		for (size_t i = 0; i < m_numIslands; ++i) {
+			GeneticSolver* island = m_islandSolvers[i];
+			island->setSelectionMethod(m_selectionMethod);
+			island->setTournamentSize(m_tournamentSize);
+			island->setSpecializedEvaluation(m_specializedEvaluation);
+			island->preparePuzzle(puzzle);
+			islandPaths.push_back(Path(islandMoves[i].data(), numPuzzlePoints));
+		}
+		
+		// each island runs its own generation loop on its own queue (an island
+		// that fails stops the others)
+		IslandExchange exchange(m_numIslands, m_migrationInterval, m_numMigrants, getGenomeBytes(numPuzzlePoints),
+		                        m_migrationTopology, m_seed);
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<std::exception_ptr> errors(m_numIslands);
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < m_numIslands; ++i) {
+			m_islandSolvers[i]->m_islandExchange = &exchange;
+			threads.push_back(std::thread([&, i]() {
+				try {
+					m_islandSolvers[i]->evolvePopulation(maxPuzzleFitness, islandPaths[i]);
+				}
+				catch (...) {
+					errors[i] = std::current_exception();
+					exchange.stop();
+				}
+			}));
+		}
+		for (size_t i = 0; i < threads.size(); ++i) {
+			threads[i].join();
+			m_islandSolvers[i]->m_islandExchange = NULL;
+		}
+		
+		auto stop = std::chrono::high_resolution_clock::now();
+		m_generationTime = std::chrono::duration<float>(stop - start).count()*1000.0f;
+		for (size_t i = 0; i < errors.size(); ++i) {
+			if (errors[i]) {
+				std::rethrow_exception(errors[i]);
+			}
+		}
+		
+		m_numIterations = 0;
+		m_selectionTime = 0.0f;
+		for (size_t i = 0; i < m_islandSolvers.size(); ++i) {
+			m_numIterations = std::max(m_numIterations, m_islandSolvers[i]->m_numIterations);
+			m_selectionTime += m_islandSolvers[i]->m_selectionTime;
+		}
+		
+		// report the winning island's solution
+		size_t solvedIsland;
+		size_t solvedGeneration;
+		bool solutionFound = exchange.getSolution(solvedIsland, solvedGeneration);
+		if (solutionFound) {
+			m_numIterations = solvedGeneration + 1;
+			const Path& islandPath = islandPaths[solvedIsland];
+			path.clear();
+			path.setStartPointIndex(islandPath.getStartPointIndex());
+			for (size_t i = 0; i < islandPath.getNumMoves(); ++i) {
+				path.addMove(islandPath.getMove(i));
+			}
+		}
 		
 		return solutionFound;
 	}
 	
+	void GeneticSolver::createIslandSolvers()
+	{
+		// islands take turns on the primary device and the others
+		for (size_t i = 0; i < m_numIslands; ++i) {
+			size_t first;
+			size_t last;
+			getIslandRange(m_populationSize, m_numIslands, i, first, last);
+			
+			size_t device = i%(1 + m_shards.size());
+			if (device == 0) {
+				m_islandSolvers.push_back(new GeneticSolver(*this, i, last - first, m_deviceID, m_context, m_program));
+			}
+			else {
+				const DeviceShard& shard = m_shards[device - 1];
+				m_islandSolvers.push_back(new GeneticSolver(*this, i, last - first, shard.deviceID, shard.context, shard.program));
+			}
+		}
+	}
+	
+	void GeneticSolver::releaseIslandSolvers()
+	{
+		for (size_t i = 0; i < m_islandSolvers.size(); ++i) {
+			delete m_islandSolvers[i];
+		}
+		m_islandSolvers.clear();
+	}
+	
 	size_t GeneticSolver::getNumIterations() const
 	{
 		return m_numIterations;
 	}
 	
+	void GeneticSolver::setSelectionMethod(SelectionMethod method)
+	{
+		m_selectionMethod = method;
+	}
+	
+	void GeneticSolver::setTournamentSize(size_t tournamentSize)
+	{
+		m_tournamentSize = tournamentSize > 0 ? tournamentSize : 1;
+		
+		m_lastErrNum = clSetKernelArg(m_selectTournamentKernel, 1, sizeof(unsigned int), &m_tournamentSize);
+		checkLastErr("clSetKernelArg");
+	}
+	
+	void GeneticSolver::setIslandModel(size_t numIslands, size_t migrationInterval, size_t numMigrants, MigrationTopology topology)
+	{
+		// every island needs at least two members, and migrants can replace
+		// at most half of an island
+		m_numIslands = std::max(std::min(numIslands, m_populationSize/2), (size_t)1);
+		m_migrationInterval = migrationInterval;
+		m_numMigrants = std::min(numMigrants, (m_populationSize/m_numIslands)/2);
+		m_migrationTopology = topology;
+		
+		// the islands are created again for the new model on the next solve
+		releaseIslandSolvers();
+		releaseIslandBuffers();
+		createIslandBuffers();
+		setIslandKernelArgs();
+	}
+	
+	float GeneticSolver::getGenerationTime() const
+	{
+		return m_generationTime;
+	}
+	
+	float GeneticSolver::getSelectionTime() const
+	{
+		return m_selectionTime;
+	}
+	
+	size_t GeneticSolver::getNumDevices() const
+	{
+		return 1 + m_shards.size();
+	}
+	
+	size_t GeneticSolver::getEvaluateWorkSize() const
+	{
+		return m_islandSolvers.empty() ? m_evaluateWorkSize : m_islandSolvers[0]->m_evaluateWorkSize;
+	}
+	
+	void GeneticSolver::setSpecializedEvaluation(bool specialized)
+	{
+		if (specialized != m_specializedEvaluation) {
+			m_specializedEvaluation = specialized;
+			createEvaluateKernels();
+		}
+	}
+	
 	int GeneticSolver::calcMaxFitness(const Puzzle& puzzle) const
 	{
 		// start with 1 fitness point for reaching the end
 		int maxFitness = 1;
 		
 		// count dot constraints (each dot is 1 fitness point)
-		for (size_t i = 0; i < m_numPuzzlePoints; ++i) {
+		for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
 			if (puzzle.getPointValue(i) == PointValue::DOT) {
 				++maxFitness;
 			}
 		}
-		for (size_t i = 0; i < m_numPuzzleEdges; ++i) {
+		for (size_t i = 0; i < puzzle.getNumEdges(); ++i) {
 			if (puzzle.getEdgeValue(i) == EdgeValue::DOT) {
 				++maxFitness;
 			}
 		}
 		
 		// count space constraints (each white/black space is 1 fitness point)
-		for (size_t i = 0; i < m_numPuzzleSpaces; ++i) {
+		for (size_t i = 0; i < puzzle.getNumSpaces(); ++i) {
 			if (puzzle.getSpaceValue(i) == SpaceValue::WHITE || puzzle.getSpaceValue(i) == SpaceValue::BLACK) {
 				++maxFitness;
 			}
@@ -201,20 +621,19 @@ namespace gws
 		return maxFitness;
 	}
 	
-	void GeneticSolver::fillPath(const char* paths, const unsigned int* startPoints, size_t member, size_t maxLength, Path& path) const
+	void GeneticSolver::fillPath(const char* memberPath, unsigned int startPoint, size_t maxLength, Path& path) const
 	{
 		// clear out path
 		path.clear();
 		
 		// set start point
-		path.setStartPointIndex(startPoints[member]);
+		path.setStartPointIndex(startPoint);
 		
 		// extract path data
-		size_t startIndex = member*maxLength;
 		size_t i = 0;
 		bool morePath = true;
 		while (i < maxLength && morePath) {
-			MoveValue value = (MoveValue)paths[startIndex + i];
+			MoveValue value = (MoveValue)memberPath[i];
 			if (value != MoveValue::NONE) {
 				path.addMove(value);
 			}
@@ -229,9 +648,8 @@ namespace gws
 	void GeneticSolver::initDeviceContextAndQueue()
 	{
 		cl_uint numPlatforms;
-		cl_uint numDevices;
 		
-		// first, select an OpenCL platform to run on
+		// first, find the OpenCL platforms
 		m_lastErrNum = clGetPlatformIDs(0, NULL, &numPlatforms);
 		if (m_lastErrNum == CL_SUCCESS && numPlatforms <= 0) {
 			m_lastErrNum = -1;
@@ -243,348 +661,2247 @@ namespace gws
 		m_lastErrNum = clGetPlatformIDs(numPlatforms, platformIDs, NULL);
 		checkLastErr("clGetPlatformIDs");
 		
-		// iterate through the list of platforms until we find one that supports a GPU device,
-		// otherwise fail with an error
-		cl_uint i;
-		cl_device_id* deviceIDs = NULL;
-		for (i = 0; i < numPlatforms; ++i) {
+		// collect the devices of every type on every platform
+		std::vector<cl_device_id> deviceIDs;
+		std::vector<cl_platform_id> devicePlatformIDs;
+		for (cl_uint i = 0; i < numPlatforms; ++i) {
+			cl_uint numDevices = 0;
 			m_lastErrNum = clGetDeviceIDs(
 				platformIDs[i],
-				CL_DEVICE_TYPE_GPU,
+				CL_DEVICE_TYPE_ALL,
 				0,
 				NULL,
 				&numDevices);
 			if (m_lastErrNum != CL_SUCCESS && m_lastErrNum != CL_DEVICE_NOT_FOUND) {
 				checkLastErr("clGetDeviceIDs");
 			}
-			else if (numDevices > 0) {
-				deviceIDs = (cl_device_id *)alloca(sizeof(cl_device_id) * numDevices);
+			else if (m_lastErrNum == CL_SUCCESS && numDevices > 0) {
+				size_t firstDevice = deviceIDs.size();
+				deviceIDs.resize(firstDevice + numDevices);
+				devicePlatformIDs.resize(firstDevice + numDevices, platformIDs[i]);
 				m_lastErrNum = clGetDeviceIDs(
 					platformIDs[i],
-					CL_DEVICE_TYPE_GPU,
+					CL_DEVICE_TYPE_ALL,
 					numDevices,
-					&deviceIDs[0],
+					&deviceIDs[firstDevice],
 					NULL);
 				checkLastErr("clGetDeviceIDs");
-				
-				m_deviceID = deviceIDs[0];
+			}
+		}
+		
+		// fail with an error if there are no devices at all
+		m_lastErrNum = deviceIDs.empty() ? CL_DEVICE_NOT_FOUND : CL_SUCCESS;
+		checkLastErr("clGetDeviceIDs");
+		
+		// the first GPU (or the first device if there is no GPU) runs every
+		// stage of the algorithm
+		size_t primary = 0;
+		for (size_t i = 0; i < deviceIDs.size(); ++i) {
+			if ((getDeviceType(deviceIDs[i]) & CL_DEVICE_TYPE_GPU) != 0) {
+				primary = i;
 				break;
 			}
 		}
 		
-		// next, create an OpenCL context on the selected platform
+		m_deviceID = deviceIDs[primary];
+		m_context = createContext(devicePlatformIDs[primary], m_deviceID);
+		initQueues();
+		
+		// every other device evaluates a share of the population, as long as
+		// each device can be given at least one work group
+		size_t maxShards = m_populationSize/LOCAL_WORK_SIZE > 0 ? m_populationSize/LOCAL_WORK_SIZE - 1 : 0;
+		for (size_t i = 0; i < deviceIDs.size() && m_shards.size() < maxShards; ++i) {
+			if (i == primary) {
+				continue;
+			}
+			
+			DeviceShard shard = {};
+			shard.deviceID = deviceIDs[i];
+			shard.share.estimatedThroughput = estimateDeviceThroughput(shard.deviceID);
+			shard.context = createContext(devicePlatformIDs[i], shard.deviceID);
+			
+			// (the evaluation is timed to balance the shares)
+			shard.queue = clCreateCommandQueue(
+				shard.context,
+				shard.deviceID,
+				CL_QUEUE_PROFILING_ENABLE,
+				&m_lastErrNum);
+			checkLastErr("clCreateCommandQueue");
+			
+			m_shards.push_back(shard);
+		}
+	}
+	
+	void GeneticSolver::initQueues()
+	{
+		// create the command queues (kernels run in order on one queue while
+		// results are read back on the other, and kernels are profiled for
+		// timing reports)
+		m_queue = clCreateCommandQueue(
+			m_context,
+			m_deviceID,
+			CL_QUEUE_PROFILING_ENABLE,
+			&m_lastErrNum);
+		checkLastErr("clCreateCommandQueue");
+		
+		m_transferQueue = clCreateCommandQueue(
+			m_context,
+			m_deviceID,
+			0,
+			&m_lastErrNum);
+		checkLastErr("clCreateCommandQueue");
+		
+		m_primaryShare.firstMember = 0;
+		m_primaryShare.numMembers = m_populationSize;
+		m_primaryShare.estimatedThroughput = estimateDeviceThroughput(m_deviceID);
+		m_primaryShare.measuredThroughput = 0.0;
+		m_primaryShare.measured = false;
+	}
+	
+	cl_context GeneticSolver::createContext(cl_platform_id platformID, cl_device_id deviceID)
+	{
 		cl_context_properties contextProperties[] =
 		{
 			CL_CONTEXT_PLATFORM,
-			(cl_context_properties)platformIDs[i],
+			(cl_context_properties)platformID,
 			0
 		};
 		
-		m_context = clCreateContext(
+		cl_context context = clCreateContext(
 			contextProperties,
-			numDevices,
-			deviceIDs,
+			1,
+			&deviceID,
 			NULL,
 			NULL,
 			&m_lastErrNum);
 		checkLastErr("clCreateContext");
 		
-		// create the command queue
-		m_queue = clCreateCommandQueue(
-			m_context,
-			m_deviceID,
-			0,
-			&m_lastErrNum);
-		checkLastErr("clCreateCommandQueue");
+		return context;
+	}
+	
+	cl_device_type GeneticSolver::getDeviceType(cl_device_id deviceID)
+	{
+		cl_device_type deviceType;
+		m_lastErrNum = clGetDeviceInfo(
+			deviceID,
+			CL_DEVICE_TYPE,
+			sizeof(cl_device_type),
+			&deviceType,
+			NULL);
+		checkLastErr("clGetDeviceInfo");
+		
+		return deviceType;
+	}
+	
+	double GeneticSolver::estimateDeviceThroughput(cl_device_id deviceID)
+	{
+		cl_uint computeUnits;
+		m_lastErrNum = clGetDeviceInfo(
+			deviceID,
+			CL_DEVICE_MAX_COMPUTE_UNITS,
+			sizeof(cl_uint),
+			&computeUnits,
+			NULL);
+		checkLastErr("clGetDeviceInfo");
+		
+		// the clock frequency is optional for the estimate
+		cl_uint clockFrequency;
+		if (clGetDeviceInfo(deviceID, CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(cl_uint), &clockFrequency, NULL) != CL_SUCCESS || clockFrequency == 0) {
+			clockFrequency = 1;
+		}
+		
+		return std::max(1.0, (double)computeUnits*clockFrequency);
 	}
 	
 	void GeneticSolver::initBuffers()
 	{
+		// buffers sized by the puzzle come from the pool, so they can be
+		// resized for other puzzles
+		m_bufferPool = new BufferPool(m_context);
+		
 		// create read-only buffers to hold constant puzzle data
-		m_puzzlePointBuffer = clCreateBuffer(
-			m_context,
+		m_puzzlePointBuffer = m_bufferPool->acquire(
 			CL_MEM_READ_ONLY,
 			sizeof(char)*m_numPuzzlePoints,
-			NULL,
 			&m_lastErrNum);
 		checkLastErr("clCreateBuffer");
 		
-		m_puzzleEdgeBuffer = clCreateBuffer(
-			m_context,
+		m_puzzleEdgeBuffer = m_bufferPool->acquire(
 			CL_MEM_READ_ONLY,
 			sizeof(char)*m_numPuzzleEdges,
-			NULL,
 			&m_lastErrNum);
 		checkLastErr("clCreateBuffer");
 		
-		m_puzzleSpaceBuffer = clCreateBuffer(
-			m_context,
+		m_puzzleSpaceBuffer = m_bufferPool->acquire(
 			CL_MEM_READ_ONLY,
 			sizeof(char)*m_numPuzzleSpaces,
-			NULL,
 			&m_lastErrNum);
 		checkLastErr("clCreateBuffer");
 		
 		// create buffers to store populations (path solutions) and fitness results
-		// (max path length is the number of puzzle points)
-		m_populationBuffer = clCreateBuffer(
+		// (max path length is the number of puzzle points, and genomes are
+		// packed)
+		m_populationBuffer = m_bufferPool->acquire(
+			CL_MEM_READ_WRITE,
+			sizeof(unsigned char)*m_genomeBytes*m_populationSize,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		m_nextPopulationBuffer = m_bufferPool->acquire(
+			CL_MEM_READ_WRITE,
+			sizeof(unsigned char)*m_genomeBytes*m_populationSize,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		m_fitnessPrefixBuffer = clCreateBuffer(
 			m_context,
-			CL_MEM_READ_ONLY,
-			sizeof(unsigned char)*m_numPuzzlePoints*m_populationSize,
+			CL_MEM_READ_WRITE,
+			sizeof(unsigned int)*m_populationSize,
 			NULL,
 			&m_lastErrNum);
 		checkLastErr("clCreateBuffer");
 		
-		m_fitnessBuffer = clCreateBuffer(
+		// create buffers for the selection methods (only the buffers of the
+		// configured method are used)
+		m_aliasProbabilityBuffer = clCreateBuffer(
 			m_context,
-			CL_MEM_WRITE_ONLY,
-			sizeof(int)*m_populationSize,
+			CL_MEM_READ_WRITE,
+			sizeof(cl_ulong)*m_populationSize,
 			NULL,
 			&m_lastErrNum);
 		checkLastErr("clCreateBuffer");
 		
-		m_startPointBuffer = clCreateBuffer(
+		m_aliasBuffer = clCreateBuffer(
 			m_context,
-			CL_MEM_WRITE_ONLY,
+			CL_MEM_READ_WRITE,
 			sizeof(unsigned int)*m_populationSize,
 			NULL,
 			&m_lastErrNum);
 		checkLastErr("clCreateBuffer");
 		
-		m_pathsBuffer = clCreateBuffer(
+		m_aliasWorklistBuffer = clCreateBuffer(
 			m_context,
-			CL_MEM_WRITE_ONLY,
-			sizeof(char)*m_numPuzzlePoints*m_populationSize,
+			CL_MEM_READ_WRITE,
+			sizeof(unsigned int)*m_populationSize,
+			NULL,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		m_mateBuffer = clCreateBuffer(
+			m_context,
+			CL_MEM_READ_WRITE,
+			sizeof(unsigned int)*m_populationSize,
 			NULL,
 			&m_lastErrNum);
 		checkLastErr("clCreateBuffer");
+		
+		createIslandBuffers();
+		
+		// create one set of evaluation buffers per generation in flight
+		for (size_t i = 0; i < 2; ++i) {
+			createGenerationBuffers(m_generationBuffers[i]);
+		}
 	}
 	
-	void GeneticSolver::initProgramAndKernels()
+	void GeneticSolver::createIslandBuffers()
 	{
-		std::ifstream srcFile("GeneticSolver.cl");
-		if (!srcFile.is_open()) {
-			m_lastErrNum = -1;
-		}
-		checkLastErr("Reading GeneticSolver.cl");
+		// (migration buffers always hold at least one migrant so that they
+		// are valid kernel arguments)
+		size_t numTotalMigrants = std::max(m_numIslands*m_numMigrants, (size_t)1);
 		
-		std::string srcProg(
-			std::istreambuf_iterator<char>(srcFile),
-			(std::istreambuf_iterator<char>()));
+		m_aliasTotalBuffer = clCreateBuffer(
+			m_context,
+			CL_MEM_READ_WRITE,
+			sizeof(unsigned int)*m_numIslands,
+			NULL,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
 		
-		const char* src = srcProg.c_str();
-		size_t length = srcProg.length();
+		m_emigrantBuffer = m_bufferPool->acquire(
+			CL_MEM_READ_WRITE,
+			sizeof(unsigned char)*m_genomeBytes*numTotalMigrants,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
 		
-		// create program from source
-		m_program = clCreateProgramWithSource(
+		m_emigrantFitnessBuffer = clCreateBuffer(
 			m_context,
-			1,
-			&src,
-			&length,
+			CL_MEM_READ_WRITE,
+			sizeof(int)*numTotalMigrants,
+			NULL,
 			&m_lastErrNum);
-		checkLastErr("clCreateProgramWithSource");
+		checkLastErr("clCreateBuffer");
 		
-		// build program
-		m_lastErrNum = clBuildProgram(
-			m_program,
-			1,
-			&m_deviceID,
-			NULL,
+		m_replacedBuffer = clCreateBuffer(
+			m_context,
+			CL_MEM_READ_WRITE,
+			sizeof(unsigned int)*numTotalMigrants,
 			NULL,
-			NULL);
-		if (m_lastErrNum != CL_SUCCESS) {
-			// determine the reason for the error
-			char buildLog[16384];
-			clGetProgramBuildInfo(
-				m_program,
-				m_deviceID,
-				CL_PROGRAM_BUILD_LOG,
-				sizeof(buildLog),
-				buildLog,
-				NULL);
-			
-			std::cerr << "Error in OpenCL C source: " << std::endl;
-			std::cerr << buildLog;
-			checkLastErr("clBuildProgram");
-		}
-		
-		// create kernel
-		m_evaluateKernel = clCreateKernel(
-			m_program,
-			"evaluatePopulation",
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+	}
+	
+	void GeneticSolver::releaseIslandBuffers()
+	{
+		if (m_aliasTotalBuffer != 0) {
+			clReleaseMemObject(m_aliasTotalBuffer);
+		}
+		m_bufferPool->release(m_emigrantBuffer);
+		if (m_emigrantFitnessBuffer != 0) {
+			clReleaseMemObject(m_emigrantFitnessBuffer);
+		}
+		if (m_replacedBuffer != 0) {
+			clReleaseMemObject(m_replacedBuffer);
+		}
+	}
+	
+	void GeneticSolver::createGenerationBuffers(GenerationBuffers& buffers)
+	{
+		buffers.fitness = clCreateBuffer(
+			m_context,
+			CL_MEM_READ_WRITE,
+			sizeof(int)*m_populationSize,
+			NULL,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		buffers.fitnessStats = clCreateBuffer(
+			m_context,
+			CL_MEM_READ_WRITE,
+			sizeof(FitnessStats),
+			NULL,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		buffers.startPoints = clCreateBuffer(
+			m_context,
+			CL_MEM_WRITE_ONLY,
+			sizeof(unsigned int)*m_populationSize,
+			NULL,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		buffers.paths = m_bufferPool->acquire(
+			CL_MEM_WRITE_ONLY,
+			sizeof(unsigned char)*m_pathBytes*m_populationSize,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		buffers.statsEvent = 0;
+		buffers.puzzleStats = 0;
+		buffers.hostPuzzleStats = NULL;
+		buffers.selectionEvents[0] = 0;
+		buffers.selectionEvents[1] = 0;
+		buffers.evaluateEvent = 0;
+		buffers.evaluatedMembers = 0;
+		buffers.populationEvent = 0;
+		
+		// (staging memory is allocated with the other devices' buffers)
+		buffers.shardFitness = NULL;
+		buffers.shardStartPoints = NULL;
+		buffers.shardPaths = NULL;
+	}
+	
+	void GeneticSolver::initProgramAndKernels()
+	{
+		m_program = buildProgram(m_context, m_deviceID, getBuildOptions());
+		initKernels();
+	}
+	
+	void GeneticSolver::initKernels()
+	{
+		// create population generation kernel (the population buffer is set
+		// before each run)
+		m_generateKernel = clCreateKernel(
+			m_program,
+			"generatePopulation",
 			&m_lastErrNum);
 		checkLastErr("clCreateKernel");
 		
+		m_lastErrNum = clSetKernelArg(m_generateKernel, 0, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(m_generateKernel, 1, sizeof(unsigned int), &m_numPuzzlePoints);
+		m_lastErrNum |= clSetKernelArg(m_generateKernel, 2, sizeof(unsigned int), &m_seed);
+		checkLastErr("clSetKernelArg");
+		
+		// (the evaluation kernels are created once every device's program
+		// is built)
+		
+		// create fitness reduction kernel (runs as a single work group, and
+		// the fitness buffers are set before each run)
+		m_reduceKernel = clCreateKernel(
+			m_program,
+			"reduceFitness",
+			&m_lastErrNum);
+		checkLastErr("clCreateKernel");
+		
+		m_reduceWorkSize = getSingleGroupWorkSize(m_reduceKernel);
+		m_lastErrNum = clSetKernelArg(m_reduceKernel, 1, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(m_reduceKernel, 3, sizeof(FitnessStats)*m_reduceWorkSize, NULL);
+		checkLastErr("clSetKernelArg");
+		
+		// create fitness prefix sum kernel (runs as a single work group, and
+		// the fitness buffers are set before each run)
+		m_scanKernel = clCreateKernel(
+			m_program,
+			"scanFitness",
+			&m_lastErrNum);
+		checkLastErr("clCreateKernel");
+		
+		m_scanWorkSize = getSingleGroupWorkSize(m_scanKernel);
+		m_lastErrNum = clSetKernelArg(m_scanKernel, 1, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(m_scanKernel, 3, sizeof(unsigned int)*m_scanWorkSize, NULL);
+		m_lastErrNum |= clSetKernelArg(m_scanKernel, 4, sizeof(cl_mem), &m_fitnessPrefixBuffer);
+		checkLastErr("clSetKernelArg");
+		
+		// create alias table kernel (runs as one work group per island, and
+		// the fitness buffers are set before each run)
+		m_aliasKernel = clCreateKernel(
+			m_program,
+			"buildAliasTable",
+			&m_lastErrNum);
+		checkLastErr("clCreateKernel");
+		
+		m_aliasWorkSize = getSingleGroupWorkSize(m_aliasKernel);
+		m_lastErrNum = clSetKernelArg(m_aliasKernel, 1, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(m_aliasKernel, 4, sizeof(unsigned int)*m_aliasWorkSize, NULL);
+		m_lastErrNum |= clSetKernelArg(m_aliasKernel, 5, sizeof(cl_mem), &m_aliasProbabilityBuffer);
+		m_lastErrNum |= clSetKernelArg(m_aliasKernel, 6, sizeof(cl_mem), &m_aliasBuffer);
+		m_lastErrNum |= clSetKernelArg(m_aliasKernel, 7, sizeof(cl_mem), &m_aliasWorklistBuffer);
+		checkLastErr("clSetKernelArg");
+		
+		// create mate selection kernels (the fitness buffers and generation
+		// are set before each run)
+		m_selectRouletteKernel = createSelectionKernel("selectRoulette", 1);
+		m_lastErrNum = clSetKernelArg(m_selectRouletteKernel, 0, sizeof(cl_mem), &m_fitnessPrefixBuffer);
+		checkLastErr("clSetKernelArg");
+		
+		m_selectAliasKernel = createSelectionKernel("selectAlias", 3);
+		m_lastErrNum = clSetKernelArg(m_selectAliasKernel, 0, sizeof(cl_mem), &m_aliasProbabilityBuffer);
+		m_lastErrNum |= clSetKernelArg(m_selectAliasKernel, 1, sizeof(cl_mem), &m_aliasBuffer);
+		checkLastErr("clSetKernelArg");
+		
+		m_selectTournamentKernel = createSelectionKernel("selectTournament", 2);
+		m_lastErrNum = clSetKernelArg(m_selectTournamentKernel, 1, sizeof(unsigned int), &m_tournamentSize);
+		checkLastErr("clSetKernelArg");
+		
+		// create crossover/mutation kernel (the population buffers and
+		// generation are set before each run)
+		m_reproduceKernel = clCreateKernel(
+			m_program,
+			"reproducePopulation",
+			&m_lastErrNum);
+		checkLastErr("clCreateKernel");
+		
+		cl_ulong mutationThreshold = getRandomThreshold(m_mutationRate);
+		m_lastErrNum = clSetKernelArg(m_reproduceKernel, 1, sizeof(cl_mem), &m_mateBuffer);
+		m_lastErrNum |= clSetKernelArg(m_reproduceKernel, 2, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(m_reproduceKernel, 3, sizeof(unsigned int), &m_numPuzzlePoints);
+		m_lastErrNum |= clSetKernelArg(m_reproduceKernel, 4, sizeof(cl_ulong), &mutationThreshold);
+		m_lastErrNum |= clSetKernelArg(m_reproduceKernel, 5, sizeof(unsigned int), &m_seed);
+		checkLastErr("clSetKernelArg");
+		
+		// create migration kernels (the population and fitness buffers are
+		// set before each run)
+		m_collectKernel = clCreateKernel(
+			m_program,
+			"collectEmigrants",
+			&m_lastErrNum);
+		checkLastErr("clCreateKernel");
+		
+		m_lastErrNum = clSetKernelArg(m_collectKernel, 2, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(m_collectKernel, 3, sizeof(unsigned int), &m_numPuzzlePoints);
+		checkLastErr("clSetKernelArg");
+		
+		m_receiveKernel = clCreateKernel(
+			m_program,
+			"receiveImmigrants",
+			&m_lastErrNum);
+		checkLastErr("clCreateKernel");
+		
+		m_lastErrNum = clSetKernelArg(m_receiveKernel, 3, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(m_receiveKernel, 4, sizeof(unsigned int), &m_numPuzzlePoints);
+		checkLastErr("clSetKernelArg");
+		
+		// create batch evaluation and reduction kernels (the batch buffers
+		// and sizes are set when a batch solve starts, and the reduction
+		// runs as a single work group)
+		m_batchEvaluateKernel = clCreateKernel(
+			m_program,
+			"evaluatePopulationBatch",
+			&m_lastErrNum);
+		checkLastErr("clCreateKernel");
+		
+		m_batchReduceKernel = clCreateKernel(
+			m_program,
+			"reduceFitnessBatch",
+			&m_lastErrNum);
+		checkLastErr("clCreateKernel");
+		
+		m_batchReduceWorkSize = getSingleGroupWorkSize(m_batchReduceKernel);
+		m_lastErrNum = clSetKernelArg(m_batchReduceKernel, 1, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(m_batchReduceKernel, 4, sizeof(FitnessStats)*m_batchReduceWorkSize, NULL);
+		checkLastErr("clSetKernelArg");
+		
+		setIslandKernelArgs();
+	}
+	
+	cl_program GeneticSolver::buildProgram(cl_context context, cl_device_id deviceID, const std::string& options)
+	{
+		// a binary only matches the device, driver, source and options it
+		// was built with
+		std::vector<std::string> keyParts;
+		keyParts.push_back(getDeviceInfoString(deviceID, CL_DEVICE_VENDOR));
+		keyParts.push_back(getDeviceInfoString(deviceID, CL_DEVICE_NAME));
+		keyParts.push_back(getDeviceInfoString(deviceID, CL_DEVICE_VERSION));
+		keyParts.push_back(getDeviceInfoString(deviceID, CL_DRIVER_VERSION));
+		keyParts.push_back(GENETIC_SOLVER_SOURCE);
+		keyParts.push_back(options);
+		std::string key = ProgramCache::makeKey(keyParts);
+		
+		// try the cached binary first (it may be stale or corrupt, in which
+		// case it is rebuilt from source and replaced)
+		cl_program program = 0;
+		std::vector<unsigned char> binary;
+		if (m_programCache.load(key, binary)) {
+			program = buildProgramFromBinary(context, deviceID, binary, options.c_str());
+		}
+		
+		if (program == 0) {
+			// create program from the embedded source
+			const char* src = GENETIC_SOLVER_SOURCE;
+			size_t length = sizeof(GENETIC_SOLVER_SOURCE) - 1;
+			program = clCreateProgramWithSource(
+				context,
+				1,
+				&src,
+				&length,
+				&m_lastErrNum);
+			checkLastErr("clCreateProgramWithSource");
+			
+			// build program
+			m_lastErrNum = clBuildProgram(
+				program,
+				1,
+				&deviceID,
+				options.c_str(),
+				NULL,
+				NULL);
+			if (m_lastErrNum != CL_SUCCESS) {
+				// determine the reason for the error
+				char buildLog[16384];
+				clGetProgramBuildInfo(
+					program,
+					deviceID,
+					CL_PROGRAM_BUILD_LOG,
+					sizeof(buildLog),
+					buildLog,
+					NULL);
+				
+				std::cerr << "Error in OpenCL C source: " << std::endl;
+				std::cerr << buildLog;
+				checkLastErr("clBuildProgram");
+			}
+			
+			if (m_programCache.isEnabled()) {
+				getProgramBinary(program, binary);
+				m_programCache.store(key, binary);
+			}
+		}
+		
+		return program;
+	}
+	
+	cl_program GeneticSolver::buildProgramFromBinary(cl_context context, cl_device_id deviceID, const std::vector<unsigned char>& binary, const char* options)
+	{
+		const unsigned char* binaryData = binary.data();
+		size_t binarySize = binary.size();
+		cl_int binaryStatus = CL_SUCCESS;
+		cl_program program = clCreateProgramWithBinary(
+			context,
+			1,
+			&deviceID,
+			&binarySize,
+			&binaryData,
+			&binaryStatus,
+			&m_lastErrNum);
+		
+		// binaries still have to be built (which is fast since they are
+		// already compiled)
+		if (m_lastErrNum == CL_SUCCESS && binaryStatus == CL_SUCCESS) {
+			m_lastErrNum = clBuildProgram(
+				program,
+				1,
+				&deviceID,
+				options,
+				NULL,
+				NULL);
+		}
+		
+		if (m_lastErrNum != CL_SUCCESS || binaryStatus != CL_SUCCESS) {
+			if (program != 0) {
+				clReleaseProgram(program);
+			}
+			program = 0;
+			m_lastErrNum = CL_SUCCESS;
+		}
+		
+		return program;
+	}
+	
+	void GeneticSolver::getProgramBinary(cl_program program, std::vector<unsigned char>& binary)
+	{
+		size_t binarySize;
+		m_lastErrNum = clGetProgramInfo(
+			program,
+			CL_PROGRAM_BINARY_SIZES,
+			sizeof(size_t),
+			&binarySize,
+			NULL);
+		checkLastErr("clGetProgramInfo");
+		
+		binary.resize(binarySize);
+		unsigned char* binaryData = binary.data();
+		if (binarySize > 0) {
+			m_lastErrNum = clGetProgramInfo(
+				program,
+				CL_PROGRAM_BINARIES,
+				sizeof(unsigned char*),
+				&binaryData,
+				NULL);
+			checkLastErr("clGetProgramInfo");
+		}
+	}
+	
+	std::string GeneticSolver::getDeviceInfoString(cl_device_id deviceID, cl_device_info param)
+	{
+		size_t size;
+		m_lastErrNum = clGetDeviceInfo(deviceID, param, 0, NULL, &size);
+		checkLastErr("clGetDeviceInfo");
+		
+		std::vector<char> value(size + 1, '\0');
+		m_lastErrNum = clGetDeviceInfo(deviceID, param, size, value.data(), NULL);
+		checkLastErr("clGetDeviceInfo");
+		
+		return std::string(value.data());
+	}
+	
+	void GeneticSolver::setEvaluateKernelArgs(cl_kernel kernel, cl_mem population, cl_mem puzzlePoints, cl_mem puzzleEdges, cl_mem puzzleSpaces)
+	{
 		// set input arguments
-		m_lastErrNum = clSetKernelArg(m_evaluateKernel, 0, sizeof(cl_mem), &m_populationBuffer);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 1, sizeof(unsigned int), &m_populationSize);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 2, sizeof(unsigned int), &m_numPuzzlePoints);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 3, sizeof(cl_mem), &m_puzzlePointBuffer);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 4, sizeof(cl_mem), &m_puzzleEdgeBuffer);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 5, sizeof(cl_mem), &m_puzzleSpaceBuffer);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 6, sizeof(unsigned int), &m_numPuzzlePoints);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 7, sizeof(unsigned int), &m_numPuzzleEdges);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 8, sizeof(unsigned int), &m_numPuzzleSpaces);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 9, sizeof(unsigned int), &m_puzzleWidth);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 10, sizeof(unsigned int), &m_puzzleHeight);
+		m_lastErrNum = clSetKernelArg(kernel, 0, sizeof(cl_mem), &population);
+		m_lastErrNum |= clSetKernelArg(kernel, 1, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(kernel, 2, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(kernel, 3, sizeof(unsigned int), &m_numPuzzlePoints);
+		m_lastErrNum |= clSetKernelArg(kernel, 4, sizeof(cl_mem), &puzzlePoints);
+		m_lastErrNum |= clSetKernelArg(kernel, 5, sizeof(cl_mem), &puzzleEdges);
+		m_lastErrNum |= clSetKernelArg(kernel, 6, sizeof(cl_mem), &puzzleSpaces);
+		m_lastErrNum |= clSetKernelArg(kernel, 7, sizeof(unsigned int), &m_numPuzzlePoints);
+		m_lastErrNum |= clSetKernelArg(kernel, 8, sizeof(unsigned int), &m_numPuzzleEdges);
+		m_lastErrNum |= clSetKernelArg(kernel, 9, sizeof(unsigned int), &m_numPuzzleSpaces);
+		m_lastErrNum |= clSetKernelArg(kernel, 10, sizeof(unsigned int), &m_puzzleWidth);
+		m_lastErrNum |= clSetKernelArg(kernel, 11, sizeof(unsigned int), &m_puzzleHeight);
+		checkLastErr("clSetKernelArg");
+	}
+	
+	size_t GeneticSolver::getEvaluateScratchSize() const
+	{
+		// bitsets of visited points and edges, and of partitioned and
+		// pending spaces for the flood fill
+		return sizeof(cl_uint)*(getBitsetWords(m_numPuzzlePoints) +
+		                        getBitsetWords(m_numPuzzleEdges) +
+		                        2*getBitsetWords(m_numPuzzleSpaces));
+	}
+	
+	size_t GeneticSolver::getMaxEvaluateWorkSize(cl_device_id deviceID, cl_kernel kernel)
+	{
+		size_t kernelWorkSize;
+		m_lastErrNum = clGetKernelWorkGroupInfo(
+			kernel,
+			deviceID,
+			CL_KERNEL_WORK_GROUP_SIZE,
+			sizeof(size_t),
+			&kernelWorkSize,
+			NULL);
+		checkLastErr("clGetKernelWorkGroupInfo");
+		
+		cl_ulong localMemSize;
+		m_lastErrNum = clGetDeviceInfo(
+			deviceID,
+			CL_DEVICE_LOCAL_MEM_SIZE,
+			sizeof(cl_ulong),
+			&localMemSize,
+			NULL);
+		checkLastErr("clGetDeviceInfo");
+		
+		// every work item of a group needs its own scratch space
+		size_t maxWorkSize = std::min(kernelWorkSize, (size_t)(localMemSize/getEvaluateScratchSize()));
+		if (maxWorkSize == 0) {
+			m_lastErrNum = CL_OUT_OF_RESOURCES;
+		}
+		checkLastErr("Fitting evaluation scratch space in local memory");
+		
+		return maxWorkSize;
+	}
+	
+	void GeneticSolver::setEvaluateWorkSize(cl_kernel kernel, size_t workSize)
+	{
+		// set sizes of local memory scratch space arrays for each work group
+		m_lastErrNum = clSetKernelArg(kernel, 12, sizeof(cl_uint)*getBitsetWords(m_numPuzzlePoints)*workSize, NULL);
+		m_lastErrNum |= clSetKernelArg(kernel, 13, sizeof(cl_uint)*getBitsetWords(m_numPuzzleEdges)*workSize, NULL);
+		m_lastErrNum |= clSetKernelArg(kernel, 14, sizeof(cl_uint)*getBitsetWords(m_numPuzzleSpaces)*workSize, NULL);
+		m_lastErrNum |= clSetKernelArg(kernel, 15, sizeof(cl_uint)*getBitsetWords(m_numPuzzleSpaces)*workSize, NULL);
+		checkLastErr("clSetKernelArg");
+	}
+	
+	std::string GeneticSolver::getBuildOptions() const
+	{
+		// every kernel indexes the population through the same layout
+		std::string options;
+		if (m_populationLayout == PopulationLayout::INTERLEAVED) {
+			options = "-D INTERLEAVED_POPULATION";
+		}
+		
+		return options;
+	}
+	
+	std::string GeneticSolver::getSpecializationOptions() const
+	{
+		std::ostringstream oss;
+		if (m_populationLayout == PopulationLayout::INTERLEAVED) {
+			oss << getBuildOptions() << " ";
+		}
+		oss << "-D PUZZLE_WIDTH=" << m_puzzleWidth
+		    << " -D PUZZLE_HEIGHT=" << m_puzzleHeight
+		    << " -D PUZZLE_NUM_POINTS=" << m_numPuzzlePoints
+		    << " -D PUZZLE_NUM_EDGES=" << m_numPuzzleEdges
+		    << " -D PUZZLE_NUM_SPACES=" << m_numPuzzleSpaces;
+		
+		return oss.str();
+	}
+	
+	cl_program GeneticSolver::getEvaluateProgram(cl_context context, cl_device_id deviceID, cl_program program, std::map<std::pair<size_t, size_t>, cl_program>& specializedPrograms)
+	{
+		// specialized variants are built once per puzzle size (and their
+		// binaries are cached on disk under their build options)
+		if (m_specializedEvaluation) {
+			std::pair<size_t, size_t> dimensions(m_puzzleWidth, m_puzzleHeight);
+			auto variant = specializedPrograms.find(dimensions);
+			if (variant == specializedPrograms.end()) {
+				cl_program specializedProgram = buildProgram(context, deviceID, getSpecializationOptions());
+				variant = specializedPrograms.insert(std::make_pair(dimensions, specializedProgram)).first;
+			}
+			program = variant->second;
+		}
+		
+		return program;
+	}
+	
+	cl_kernel GeneticSolver::createEvaluateKernel(cl_program program, cl_device_id deviceID, cl_mem population, cl_mem puzzlePoints, cl_mem puzzleEdges, cl_mem puzzleSpaces, size_t& workSize)
+	{
+		cl_kernel kernel = clCreateKernel(
+			program,
+			"evaluatePopulation",
+			&m_lastErrNum);
+		checkLastErr("clCreateKernel");
+		
+		// start with the default work group size (if it fits) until the
+		// size is tuned
+		setEvaluateKernelArgs(kernel, population, puzzlePoints, puzzleEdges, puzzleSpaces);
+		workSize = std::min((size_t)LOCAL_WORK_SIZE, getMaxEvaluateWorkSize(deviceID, kernel));
+		setEvaluateWorkSize(kernel, workSize);
+		
+		return kernel;
+	}
+	
+	void GeneticSolver::createEvaluateKernels()
+	{
+		// the number of members and the primary device's outputs are set
+		// before each run
+		if (m_evaluateKernel != 0) {
+			clReleaseKernel(m_evaluateKernel);
+		}
+		m_evaluateKernel = createEvaluateKernel(
+			getEvaluateProgram(m_context, m_deviceID, m_program, m_specializedPrograms),
+			m_deviceID,
+			m_populationBuffer,
+			m_puzzlePointBuffer,
+			m_puzzleEdgeBuffer,
+			m_puzzleSpaceBuffer,
+			m_evaluateWorkSize);
+		
+		// the other devices' outputs are fixed since their shares always
+		// start at the beginning of their buffers
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			DeviceShard& shard = m_shards[i];
+			if (shard.evaluateKernel != 0) {
+				clReleaseKernel(shard.evaluateKernel);
+			}
+			shard.evaluateKernel = createEvaluateKernel(
+				getEvaluateProgram(shard.context, shard.deviceID, shard.program, shard.specializedPrograms),
+				shard.deviceID,
+				shard.populationBuffer,
+				shard.puzzlePointBuffer,
+				shard.puzzleEdgeBuffer,
+				shard.puzzleSpaceBuffer,
+				shard.evaluateWorkSize);
+			
+			m_lastErrNum = clSetKernelArg(shard.evaluateKernel, 16, sizeof(cl_mem), &shard.fitnessBuffer);
+			m_lastErrNum |= clSetKernelArg(shard.evaluateKernel, 17, sizeof(cl_mem), &shard.startPointBuffer);
+			m_lastErrNum |= clSetKernelArg(shard.evaluateKernel, 18, sizeof(cl_mem), &shard.pathsBuffer);
+			checkLastErr("clSetKernelArg");
+		}
+		
+		// new kernels are tuned on the next solve
+		m_workSizesTuned = false;
+	}
+	
+	void GeneticSolver::tuneWorkSizes()
+	{
+		// evaluate the initial population (it is generated again when the
+		// solve starts, so tuning doesn't change the results)
+		runGenerationKernel();
+		
+		GenerationBuffers& buffers = m_generationBuffers[0];
+		m_lastErrNum = clSetKernelArg(m_evaluateKernel, 16, sizeof(cl_mem), &buffers.fitness);
+		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 17, sizeof(cl_mem), &buffers.startPoints);
+		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 18, sizeof(cl_mem), &buffers.paths);
+		checkLastErr("clSetKernelArg");
+		
+		m_evaluateWorkSize = tuneEvaluateWorkSize(m_deviceID, m_queue, m_evaluateKernel);
+		
+		// the other devices evaluate a copy of the same population
+		if (!m_shards.empty()) {
+			m_lastErrNum = clEnqueueReadBuffer(
+				m_queue,
+				m_populationBuffer,
+				CL_TRUE,
+				0,
+				sizeof(unsigned char)*m_populationSize*m_genomeBytes,
+				(void*)m_shardPopulation,
+				0,
+				NULL,
+				NULL);
+			checkLastErr("clEnqueueReadBuffer");
+		}
+		
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			DeviceShard& shard = m_shards[i];
+			m_lastErrNum = clEnqueueWriteBuffer(
+				shard.queue,
+				shard.populationBuffer,
+				CL_FALSE,
+				0,
+				sizeof(unsigned char)*m_populationSize*m_genomeBytes,
+				(void*)m_shardPopulation,
+				0,
+				NULL,
+				NULL);
+			checkLastErr("clEnqueueWriteBuffer");
+			
+			shard.evaluateWorkSize = tuneEvaluateWorkSize(shard.deviceID, shard.queue, shard.evaluateKernel);
+		}
+	}
+	
+	size_t GeneticSolver::tuneEvaluateWorkSize(cl_device_id deviceID, cl_command_queue queue, cl_kernel kernel, bool batch)
+	{
+		// the candidate sizes stop at the population size, so a result tuned
+		// for a small population doesn't carry over to a much larger one
+		size_t populationBucket = 1;
+		while (populationBucket < m_populationSize) {
+			populationBucket *= 2;
+		}
+		
+		std::tuple<cl_device_id, size_t, size_t, bool, PopulationLayout, bool, size_t> key(deviceID, m_puzzleWidth, m_puzzleHeight,
+		                                                                                   m_specializedEvaluation && !batch,
+		                                                                                   m_populationLayout, batch, populationBucket);
+		size_t bestWorkSize = 0;
+		{
+			std::lock_guard<std::mutex> lock(s_tunedWorkSizesMutex);
+			auto cached = s_tunedWorkSizes.find(key);
+			if (cached != s_tunedWorkSizes.end()) {
+				bestWorkSize = cached->second;
+			}
+		}
+		
+		if (bestWorkSize == 0) {
+			// try power of two sizes up to the device's limit (and the limit
+			// itself), stopping once one work group covers the population
+			size_t maxWorkSize = getMaxEvaluateWorkSize(deviceID, kernel);
+			std::vector<size_t> candidates;
+			for (size_t workSize = 1; workSize < maxWorkSize; workSize *= 2) {
+				candidates.push_back(workSize);
+				if (workSize >= m_populationSize) {
+					break;
+				}
+			}
+			if (candidates.empty() || candidates.back() < m_populationSize) {
+				candidates.push_back(maxWorkSize);
+			}
+			
+			// keep the fastest of several runs of each size (the first run of
+			// a size may include one-time setup)
+			cl_ulong bestTime = 0;
+			for (size_t i = 0; i < candidates.size(); ++i) {
+				setEvaluateWorkSize(kernel, candidates[i]);
+				for (size_t run = 0; run < TUNING_RUNS; ++run) {
+					cl_event event;
+					runEvaluateKernel(queue, kernel, candidates[i], m_populationSize, &event);
+					m_lastErrNum = clWaitForEvents(1, &event);
+					checkLastErr("clWaitForEvents");
+					
+					cl_ulong startTime;
+					cl_ulong endTime;
+					m_lastErrNum = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &startTime, NULL);
+					m_lastErrNum |= clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &endTime, NULL);
+					clReleaseEvent(event);
+					checkLastErr("clGetEventProfilingInfo");
+					
+					if (bestWorkSize == 0 || endTime - startTime < bestTime) {
+						bestWorkSize = candidates[i];
+						bestTime = endTime - startTime;
+					}
+				}
+			}
+			
+			std::lock_guard<std::mutex> lock(s_tunedWorkSizesMutex);
+			s_tunedWorkSizes[key] = bestWorkSize;
+		}
+		
+		setEvaluateWorkSize(kernel, bestWorkSize);
+		
+		return bestWorkSize;
+	}
+	
+	void GeneticSolver::runEvaluateKernel(cl_command_queue queue, cl_kernel kernel, size_t workSize, size_t numMembers, cl_event* event)
+	{
+		// round up to whole work groups (the kernel skips work items past
+		// the last member)
+		unsigned int numKernelMembers = (unsigned int)numMembers;
+		m_lastErrNum = clSetKernelArg(kernel, 1, sizeof(unsigned int), &numKernelMembers);
+		checkLastErr("clSetKernelArg");
+		
+		size_t globalWorkSize[1] = { ((numMembers + workSize - 1)/workSize)*workSize };
+		size_t localWorkSize[1] = { workSize };
+		m_lastErrNum = clEnqueueNDRangeKernel(
+			queue,
+			kernel,
+			1,
+			NULL,
+			globalWorkSize,
+			localWorkSize,
+			0,
+			NULL,
+			event);
+		checkLastErr("clEnqueueNDRangeKernel");
+	}
+	
+	void GeneticSolver::initShards()
+	{
+		if (m_shards.empty()) {
+			return;
+		}
+		
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			DeviceShard& shard = m_shards[i];
+			shard.bufferPool = new BufferPool(shard.context);
+			
+			// create read-only buffers to hold constant puzzle data
+			shard.puzzlePointBuffer = shard.bufferPool->acquire(
+				CL_MEM_READ_ONLY,
+				sizeof(char)*m_numPuzzlePoints,
+				&m_lastErrNum);
+			checkLastErr("clCreateBuffer");
+			
+			shard.puzzleEdgeBuffer = shard.bufferPool->acquire(
+				CL_MEM_READ_ONLY,
+				sizeof(char)*m_numPuzzleEdges,
+				&m_lastErrNum);
+			checkLastErr("clCreateBuffer");
+			
+			shard.puzzleSpaceBuffer = shard.bufferPool->acquire(
+				CL_MEM_READ_ONLY,
+				sizeof(char)*m_numPuzzleSpaces,
+				&m_lastErrNum);
+			checkLastErr("clCreateBuffer");
+			
+			// create buffers for the device's share of the population and
+			// its results (sized for the whole population since the shares
+			// are rebalanced every generation)
+			shard.populationBuffer = shard.bufferPool->acquire(
+				CL_MEM_READ_ONLY,
+				sizeof(unsigned char)*m_genomeBytes*m_populationSize,
+				&m_lastErrNum);
+			checkLastErr("clCreateBuffer");
+			
+			shard.fitnessBuffer = clCreateBuffer(
+				shard.context,
+				CL_MEM_WRITE_ONLY,
+				sizeof(int)*m_populationSize,
+				NULL,
+				&m_lastErrNum);
+			checkLastErr("clCreateBuffer");
+			
+			shard.startPointBuffer = clCreateBuffer(
+				shard.context,
+				CL_MEM_WRITE_ONLY,
+				sizeof(unsigned int)*m_populationSize,
+				NULL,
+				&m_lastErrNum);
+			checkLastErr("clCreateBuffer");
+			
+			shard.pathsBuffer = shard.bufferPool->acquire(
+				CL_MEM_WRITE_ONLY,
+				sizeof(unsigned char)*m_pathBytes*m_populationSize,
+				&m_lastErrNum);
+			checkLastErr("clCreateBuffer");
+			
+			shard.program = buildProgram(shard.context, shard.deviceID, getBuildOptions());
+		}
+		
+		// host staging memory for the results passing between the primary
+		// device and the others (the members and paths are staged in memory
+		// sized by the puzzle)
+		for (size_t i = 0; i < 2; ++i) {
+			GenerationBuffers& buffers = m_generationBuffers[i];
+			buffers.shardFitness = new int[m_populationSize];
+			buffers.shardStartPoints = new unsigned int[m_populationSize];
+		}
+		
+		balanceShards();
+	}
+	
+	void GeneticSolver::resizePuzzle(size_t puzzleWidth, size_t puzzleHeight)
+	{
+		checkPackedPathLength(Puzzle::getNumPoints(puzzleWidth, puzzleHeight));
+		
+		// nothing can still be using the old buffers
+		m_lastErrNum = clFinish(m_queue);
+		m_lastErrNum |= clFinish(m_transferQueue);
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			m_lastErrNum |= clFinish(m_shards[i].queue);
+		}
+		checkLastErr("clFinish");
+		
+		m_puzzleWidth = puzzleWidth;
+		m_puzzleHeight = puzzleHeight;
+		m_numPuzzlePoints = Puzzle::getNumPoints(puzzleWidth, puzzleHeight);
+		m_numPuzzleEdges = Puzzle::getNumEdges(puzzleWidth, puzzleHeight);
+		m_numPuzzleSpaces = Puzzle::getNumSpaces(puzzleWidth, puzzleHeight);
+		m_genomeBytes = getGenomeBytes(m_numPuzzlePoints);
+		m_pathBytes = getPackedPathBytes(m_numPuzzlePoints);
+		
+		// swap the buffers sized by the puzzle (a size in the same bucket
+		// gets the same buffer back)
+		reacquireBuffer(*m_bufferPool, m_puzzlePointBuffer, CL_MEM_READ_ONLY, sizeof(char)*m_numPuzzlePoints);
+		reacquireBuffer(*m_bufferPool, m_puzzleEdgeBuffer, CL_MEM_READ_ONLY, sizeof(char)*m_numPuzzleEdges);
+		reacquireBuffer(*m_bufferPool, m_puzzleSpaceBuffer, CL_MEM_READ_ONLY, sizeof(char)*m_numPuzzleSpaces);
+		reacquireBuffer(*m_bufferPool, m_populationBuffer, CL_MEM_READ_WRITE, sizeof(unsigned char)*m_genomeBytes*m_populationSize);
+		reacquireBuffer(*m_bufferPool, m_nextPopulationBuffer, CL_MEM_READ_WRITE, sizeof(unsigned char)*m_genomeBytes*m_populationSize);
+		for (size_t i = 0; i < 2; ++i) {
+			reacquireBuffer(*m_bufferPool, m_generationBuffers[i].paths, CL_MEM_WRITE_ONLY, sizeof(unsigned char)*m_pathBytes*m_populationSize);
+		}
+		releaseIslandBuffers();
+		createIslandBuffers();
+		
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			DeviceShard& shard = m_shards[i];
+			reacquireBuffer(*shard.bufferPool, shard.puzzlePointBuffer, CL_MEM_READ_ONLY, sizeof(char)*m_numPuzzlePoints);
+			reacquireBuffer(*shard.bufferPool, shard.puzzleEdgeBuffer, CL_MEM_READ_ONLY, sizeof(char)*m_numPuzzleEdges);
+			reacquireBuffer(*shard.bufferPool, shard.puzzleSpaceBuffer, CL_MEM_READ_ONLY, sizeof(char)*m_numPuzzleSpaces);
+			reacquireBuffer(*shard.bufferPool, shard.populationBuffer, CL_MEM_READ_ONLY, sizeof(unsigned char)*m_genomeBytes*m_populationSize);
+			reacquireBuffer(*shard.bufferPool, shard.pathsBuffer, CL_MEM_WRITE_ONLY, sizeof(unsigned char)*m_pathBytes*m_populationSize);
+		}
+		
+		reserveHostMemory(m_numPuzzlePoints);
+		
+		// update the kernel arguments holding the puzzle size or the
+		// swapped buffers (the evaluation kernels are recreated, since
+		// specialized variants and work group sizes depend on the size)
+		m_lastErrNum = clSetKernelArg(m_generateKernel, 1, sizeof(unsigned int), &m_numPuzzlePoints);
+		m_lastErrNum |= clSetKernelArg(m_reproduceKernel, 3, sizeof(unsigned int), &m_numPuzzlePoints);
+		m_lastErrNum |= clSetKernelArg(m_collectKernel, 3, sizeof(unsigned int), &m_numPuzzlePoints);
+		m_lastErrNum |= clSetKernelArg(m_receiveKernel, 4, sizeof(unsigned int), &m_numPuzzlePoints);
+		checkLastErr("clSetKernelArg");
+		
+		setIslandKernelArgs();
+		createEvaluateKernels();
+	}
+	
+	void GeneticSolver::reacquireBuffer(BufferPool& pool, cl_mem& buffer, cl_mem_flags flags, size_t size)
+	{
+		pool.release(buffer);
+		buffer = pool.acquire(flags, size, &m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+	}
+	
+	void GeneticSolver::reserveHostMemory(size_t numPoints)
+	{
+		if (numPoints <= m_hostPointCapacity) {
+			return;
+		}
+		
+		// grow to the next bucket, so a run of slightly larger puzzles only
+		// reallocates once
+		m_hostPointCapacity = BufferPool::getBucketSize(numPoints);
+		
+		// (the displayed path is terminated after the last move)
+		delete [] m_memberPath;
+		m_memberPath = new char[m_hostPointCapacity + 1];
+		
+		// staging memory for the members and paths passing between the
+		// primary device and the others
+		if (!m_shards.empty()) {
+			delete [] m_shardPopulation;
+			m_shardPopulation = new unsigned char[getGenomeBytes(m_hostPointCapacity)*m_populationSize];
+			for (size_t i = 0; i < 2; ++i) {
+				GenerationBuffers& buffers = m_generationBuffers[i];
+				delete [] buffers.shardPaths;
+				buffers.shardPaths = new unsigned char[getPackedPathBytes(m_hostPointCapacity)*m_populationSize];
+			}
+		}
+	}
+	
+	void GeneticSolver::balanceShards()
+	{
+		// use the estimated throughputs until every device has been measured
+		// (the estimates are not comparable to measurements)
+		bool measured = m_primaryShare.measured;
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			measured = measured && m_shards[i].share.measured;
+		}
+		
+		std::vector<DeviceShare*> shares(1, &m_primaryShare);
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			shares.push_back(&m_shards[i].share);
+		}
+		
+		std::vector<double> throughputs(shares.size());
+		double totalThroughput = 0.0;
+		for (size_t i = 0; i < shares.size(); ++i) {
+			throughputs[i] = measured ? shares[i]->measuredThroughput : shares[i]->estimatedThroughput;
+			totalThroughput += throughputs[i];
+		}
+		
+		// every device keeps at least one work group (so its throughput
+		// keeps being measured), and the other work groups are split in
+		// proportion to throughput (the last device also takes any members
+		// past the last full work group)
+		size_t spareGroups = m_populationSize/LOCAL_WORK_SIZE - shares.size();
+		double cumulativeThroughput = 0.0;
+		size_t firstMember = 0;
+		for (size_t i = 0; i < shares.size(); ++i) {
+			cumulativeThroughput += throughputs[i];
+			size_t lastMember = m_populationSize;
+			if (i + 1 < shares.size()) {
+				size_t numGroups = i + 1 + (size_t)(spareGroups*cumulativeThroughput/totalThroughput + 0.5);
+				lastMember = std::min(numGroups, i + 1 + spareGroups)*LOCAL_WORK_SIZE;
+			}
+			
+			shares[i]->firstMember = firstMember;
+			shares[i]->numMembers = lastMember - firstMember;
+			firstMember = lastMember;
+		}
+	}
+	
+	cl_kernel GeneticSolver::createSelectionKernel(const char* name, cl_uint firstSharedArg)
+	{
+		cl_kernel kernel = clCreateKernel(
+			m_program,
+			name,
+			&m_lastErrNum);
+		checkLastErr("clCreateKernel");
+		
+		// shared arguments follow the method's own inputs (the generation is
+		// set before each run)
+		cl_ulong crossoverThreshold = getRandomThreshold(m_crossoverRate);
+		m_lastErrNum = clSetKernelArg(kernel, firstSharedArg, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(kernel, firstSharedArg + 2, sizeof(cl_ulong), &crossoverThreshold);
+		m_lastErrNum |= clSetKernelArg(kernel, firstSharedArg + 3, sizeof(unsigned int), &m_seed);
+		m_lastErrNum |= clSetKernelArg(kernel, firstSharedArg + 5, sizeof(cl_mem), &m_mateBuffer);
+		checkLastErr("clSetKernelArg");
+		
+		return kernel;
+	}
+	
+	void GeneticSolver::setIslandKernelArgs()
+	{
+		// selection
+		m_lastErrNum = clSetKernelArg(m_aliasKernel, 2, sizeof(unsigned int), &m_numIslands);
+		m_lastErrNum |= clSetKernelArg(m_aliasKernel, 8, sizeof(cl_mem), &m_aliasTotalBuffer);
+		m_lastErrNum |= clSetKernelArg(m_selectRouletteKernel, 2, sizeof(unsigned int), &m_numIslands);
+		m_lastErrNum |= clSetKernelArg(m_selectAliasKernel, 2, sizeof(cl_mem), &m_aliasTotalBuffer);
+		m_lastErrNum |= clSetKernelArg(m_selectAliasKernel, 4, sizeof(unsigned int), &m_numIslands);
+		m_lastErrNum |= clSetKernelArg(m_selectTournamentKernel, 3, sizeof(unsigned int), &m_numIslands);
+		
+		// migration
+		m_lastErrNum |= clSetKernelArg(m_collectKernel, 4, sizeof(unsigned int), &m_numIslands);
+		m_lastErrNum |= clSetKernelArg(m_collectKernel, 5, sizeof(unsigned int), &m_numMigrants);
+		m_lastErrNum |= clSetKernelArg(m_collectKernel, 6, sizeof(cl_mem), &m_emigrantBuffer);
+		m_lastErrNum |= clSetKernelArg(m_collectKernel, 7, sizeof(cl_mem), &m_emigrantFitnessBuffer);
+		m_lastErrNum |= clSetKernelArg(m_collectKernel, 8, sizeof(cl_mem), &m_replacedBuffer);
+		m_lastErrNum |= clSetKernelArg(m_receiveKernel, 0, sizeof(cl_mem), &m_emigrantBuffer);
+		m_lastErrNum |= clSetKernelArg(m_receiveKernel, 1, sizeof(cl_mem), &m_emigrantFitnessBuffer);
+		m_lastErrNum |= clSetKernelArg(m_receiveKernel, 2, sizeof(cl_mem), &m_replacedBuffer);
+		m_lastErrNum |= clSetKernelArg(m_receiveKernel, 5, sizeof(unsigned int), &m_numIslands);
+		m_lastErrNum |= clSetKernelArg(m_receiveKernel, 6, sizeof(unsigned int), &m_numMigrants);
+		checkLastErr("clSetKernelArg");
+	}
+	
+	size_t GeneticSolver::getSingleGroupWorkSize(cl_kernel kernel)
+	{
+		size_t workSize;
+		m_lastErrNum = clGetKernelWorkGroupInfo(
+			kernel,
+			m_deviceID,
+			CL_KERNEL_WORK_GROUP_SIZE,
+			sizeof(size_t),
+			&workSize,
+			NULL);
+		checkLastErr("clGetKernelWorkGroupInfo");
+		
+		return workSize < SINGLE_GROUP_WORK_SIZE ? workSize : SINGLE_GROUP_WORK_SIZE;
+	}
+	
+	void GeneticSolver::transferPuzzleData(const Puzzle& puzzle)
+	{
+		writePuzzleData(m_queue, m_puzzlePointBuffer, m_puzzleEdgeBuffer, m_puzzleSpaceBuffer, puzzle);
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			DeviceShard& shard = m_shards[i];
+			writePuzzleData(shard.queue, shard.puzzlePointBuffer, shard.puzzleEdgeBuffer, shard.puzzleSpaceBuffer, puzzle);
+		}
+	}
+	
+	void GeneticSolver::writePuzzleData(cl_command_queue queue, cl_mem puzzlePoints, cl_mem puzzleEdges, cl_mem puzzleSpaces, const Puzzle& puzzle)
+	{
+		m_lastErrNum = clEnqueueWriteBuffer(
+			queue,
+			puzzlePoints,
+			CL_FALSE,
+			0,
+			sizeof(char)*m_numPuzzlePoints,
+			(void*)puzzle.getPointData(),
+			0,
+			NULL,
+			NULL);
+		checkLastErr("clEnqueueWriteBuffer");
+		
+		m_lastErrNum = clEnqueueWriteBuffer(
+			queue,
+			puzzleEdges,
+			CL_FALSE,
+			0,
+			sizeof(char)*m_numPuzzleEdges,
+			(void*)puzzle.getEdgeData(),
+			0,
+			NULL,
+			NULL);
+		checkLastErr("clEnqueueWriteBuffer");
+		
+		m_lastErrNum = clEnqueueWriteBuffer(
+			queue,
+			puzzleSpaces,
+			CL_FALSE,
+			0,
+			sizeof(char)*m_numPuzzleSpaces,
+			(void*)puzzle.getSpaceData(),
+			0,
+			NULL,
+			NULL);
+		checkLastErr("clEnqueueWriteBuffer");
+	}
+	
+	void GeneticSolver::transferBatchPuzzleData(const std::vector<const Puzzle*>& puzzles, std::vector<BatchResult>& results)
+	{
+		size_t numPuzzles = puzzles.size();
+		
+		// give back any buffers still held by an earlier batch
+		releaseBatchBuffers();
+		
+		// concatenate the puzzle data, recording where each puzzle starts
+		std::vector<char> points;
+		std::vector<char> edges;
+		std::vector<char> spaces;
+		std::vector<BatchPuzzle> batchPuzzles(numPuzzles);
+		results.resize(numPuzzles);
+		for (size_t i = 0; i < numPuzzles; ++i) {
+			const Puzzle& puzzle = *puzzles[i];
+			BatchPuzzle& batchPuzzle = batchPuzzles[i];
+			batchPuzzle.pointOffset = (cl_uint)points.size();
+			batchPuzzle.edgeOffset = (cl_uint)edges.size();
+			batchPuzzle.spaceOffset = (cl_uint)spaces.size();
+			batchPuzzle.numPoints = (cl_uint)puzzle.getNumPoints();
+			batchPuzzle.numEdges = (cl_uint)puzzle.getNumEdges();
+			batchPuzzle.numSpaces = (cl_uint)puzzle.getNumSpaces();
+			batchPuzzle.width = (cl_uint)puzzle.getWidth();
+			batchPuzzle.height = (cl_uint)puzzle.getHeight();
+			batchPuzzle.maxFitness = calcMaxFitness(puzzle);
+			points.insert(points.end(), puzzle.getPointData(), puzzle.getPointData() + puzzle.getNumPoints());
+			edges.insert(edges.end(), puzzle.getEdgeData(), puzzle.getEdgeData() + puzzle.getNumEdges());
+			spaces.insert(spaces.end(), puzzle.getSpaceData(), puzzle.getSpaceData() + puzzle.getNumSpaces());
+			
+			BatchResult& result = results[i];
+			result.solved = false;
+			result.numIterations = 0;
+			result.maxFitness = 0;
+			result.maxPuzzleFitness = batchPuzzle.maxFitness;
+		}
+		
+		// the puzzle buffers are all in constant memory
+		cl_ulong constantMemSize;
+		m_lastErrNum = clGetDeviceInfo(
+			m_deviceID,
+			CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE,
+			sizeof(cl_ulong),
+			&constantMemSize,
+			NULL);
+		checkLastErr("clGetDeviceInfo");
+		
+		size_t batchBytes = points.size() + edges.size() + spaces.size() + sizeof(BatchPuzzle)*numPuzzles;
+		if (batchBytes > constantMemSize) {
+			throw std::runtime_error("Batch puzzles don't fit in constant memory");
+		}
+		
+		// batch buffers come from the pool, so batches of similar size reuse
+		// them
+		m_batchPointBuffer = m_bufferPool->acquire(
+			CL_MEM_READ_ONLY,
+			sizeof(char)*points.size(),
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		m_batchEdgeBuffer = m_bufferPool->acquire(
+			CL_MEM_READ_ONLY,
+			sizeof(char)*edges.size(),
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		m_batchSpaceBuffer = m_bufferPool->acquire(
+			CL_MEM_READ_ONLY,
+			sizeof(char)*spaces.size(),
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		m_batchPuzzleBuffer = m_bufferPool->acquire(
+			CL_MEM_READ_ONLY,
+			sizeof(BatchPuzzle)*numPuzzles,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		m_solvedPuzzleBuffer = m_bufferPool->acquire(
+			CL_MEM_READ_WRITE,
+			sizeof(cl_int)*numPuzzles,
+			&m_lastErrNum);
+		checkLastErr("clCreateBuffer");
+		
+		for (size_t i = 0; i < 2; ++i) {
+			GenerationBuffers& buffers = m_generationBuffers[i];
+			buffers.puzzleStats = m_bufferPool->acquire(
+				CL_MEM_READ_WRITE,
+				sizeof(FitnessStats)*numPuzzles,
+				&m_lastErrNum);
+			checkLastErr("clCreateBuffer");
+			buffers.hostPuzzleStats = new FitnessStats[numPuzzles];
+		}
+		
+		// write the puzzle data and clear the solved flags (and wait, since
+		// the host copies are temporary)
+		std::vector<cl_int> solvedPuzzles(numPuzzles, 0);
+		cl_mem buffers[] = {
+			m_batchPointBuffer,
+			m_batchEdgeBuffer,
+			m_batchSpaceBuffer,
+			m_batchPuzzleBuffer,
+			m_solvedPuzzleBuffer
+		};
+		const void* data[] = {
+			points.data(),
+			edges.data(),
+			spaces.data(),
+			batchPuzzles.data(),
+			solvedPuzzles.data()
+		};
+		size_t sizes[] = {
+			sizeof(char)*points.size(),
+			sizeof(char)*edges.size(),
+			sizeof(char)*spaces.size(),
+			sizeof(BatchPuzzle)*numPuzzles,
+			sizeof(cl_int)*numPuzzles
+		};
+		for (size_t i = 0; i < sizeof(buffers)/sizeof(cl_mem); ++i) {
+			m_lastErrNum = clEnqueueWriteBuffer(
+				m_queue,
+				buffers[i],
+				CL_FALSE,
+				0,
+				sizes[i],
+				data[i],
+				0,
+				NULL,
+				NULL);
+			checkLastErr("clEnqueueWriteBuffer");
+		}
+		m_lastErrNum = clFinish(m_queue);
+		checkLastErr("clFinish");
+		
+		// set the batch kernel arguments (the population and results are set
+		// before each run, and the local scratch space is sized for the
+		// largest puzzle)
+		unsigned int numKernelPuzzles = (unsigned int)numPuzzles;
+		m_lastErrNum = clSetKernelArg(m_batchEvaluateKernel, 2, sizeof(unsigned int), &m_populationSize);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 3, sizeof(unsigned int), &m_numPuzzlePoints);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 4, sizeof(unsigned int), &m_numPuzzleEdges);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 5, sizeof(unsigned int), &m_numPuzzleSpaces);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 6, sizeof(cl_mem), &m_batchPointBuffer);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 7, sizeof(cl_mem), &m_batchEdgeBuffer);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 8, sizeof(cl_mem), &m_batchSpaceBuffer);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 9, sizeof(cl_mem), &m_batchPuzzleBuffer);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 10, sizeof(unsigned int), &numKernelPuzzles);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 11, sizeof(cl_mem), &m_solvedPuzzleBuffer);
+		m_lastErrNum |= clSetKernelArg(m_batchReduceKernel, 2, sizeof(cl_mem), &m_batchPuzzleBuffer);
+		m_lastErrNum |= clSetKernelArg(m_batchReduceKernel, 3, sizeof(unsigned int), &numKernelPuzzles);
+		m_lastErrNum |= clSetKernelArg(m_batchReduceKernel, 5, sizeof(cl_mem), &m_solvedPuzzleBuffer);
+		checkLastErr("clSetKernelArg");
+		
+		// pick the batch kernel's work group size for the largest puzzle
+		// dimensions by evaluating the initial population (it is generated
+		// again when the solve starts, as in tuneWorkSizes)
+		runGenerationKernel();
+		
+		GenerationBuffers& tuningBuffers = m_generationBuffers[0];
+		m_lastErrNum = clSetKernelArg(m_batchEvaluateKernel, 0, sizeof(cl_mem), &m_populationBuffer);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 16, sizeof(cl_mem), &tuningBuffers.fitness);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 17, sizeof(cl_mem), &tuningBuffers.startPoints);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 18, sizeof(cl_mem), &tuningBuffers.paths);
+		checkLastErr("clSetKernelArg");
+		
+		m_batchEvaluateWorkSize = tuneEvaluateWorkSize(m_deviceID, m_queue, m_batchEvaluateKernel, true);
+	}
+	
+	void GeneticSolver::releaseBatchBuffers()
+	{
+		m_bufferPool->release(m_batchPointBuffer);
+		m_bufferPool->release(m_batchEdgeBuffer);
+		m_bufferPool->release(m_batchSpaceBuffer);
+		m_bufferPool->release(m_batchPuzzleBuffer);
+		m_bufferPool->release(m_solvedPuzzleBuffer);
+		m_batchPointBuffer = 0;
+		m_batchEdgeBuffer = 0;
+		m_batchSpaceBuffer = 0;
+		m_batchPuzzleBuffer = 0;
+		m_solvedPuzzleBuffer = 0;
+		for (size_t i = 0; i < 2; ++i) {
+			GenerationBuffers& buffers = m_generationBuffers[i];
+			m_bufferPool->release(buffers.puzzleStats);
+			delete [] buffers.hostPuzzleStats;
+			buffers.puzzleStats = 0;
+			buffers.hostPuzzleStats = NULL;
+		}
+	}
+	
+	void GeneticSolver::runGenerationKernel()
+	{
+		// (the population buffers swap every generation, so the current one
+		// is set before each run)
+		m_lastErrNum = clSetKernelArg(m_generateKernel, 3, sizeof(cl_mem), &m_populationBuffer);
+		checkLastErr("clSetKernelArg");
+		
+		// each work item generates one block of population bytes
+		size_t numBlocks = (m_populationSize*m_genomeBytes + PHILOX_BLOCK_BYTES - 1)/PHILOX_BLOCK_BYTES;
+		size_t globalWorkSize[1] = { ((numBlocks + LOCAL_WORK_SIZE - 1)/LOCAL_WORK_SIZE)*LOCAL_WORK_SIZE };
+		size_t localWorkSize[1] = { LOCAL_WORK_SIZE };
+		m_lastErrNum = clEnqueueNDRangeKernel(
+			m_queue,
+			m_generateKernel,
+			1,
+			NULL,
+			globalWorkSize,
+			localWorkSize,
+			0,
+			NULL,
+			NULL);
+		checkLastErr("clEnqueueNDRangeKernel");
+	}
+	
+	void GeneticSolver::runReproductionKernels(GenerationBuffers& buffers)
+	{
+		// islands exchange their fittest members every migration interval
+		if (isMigrationGeneration()) {
+			runMigrationKernels(buffers);
+		}
+		
+		// pick a mate for every member
+		runSelectionKernels(buffers);
+		
+		// crossover/mutation into the next population buffer
+		unsigned int generation = (unsigned int)m_numIterations;
+		m_lastErrNum = clSetKernelArg(m_reproduceKernel, 0, sizeof(cl_mem), &m_populationBuffer);
+		m_lastErrNum |= clSetKernelArg(m_reproduceKernel, 6, sizeof(unsigned int), &generation);
+		m_lastErrNum |= clSetKernelArg(m_reproduceKernel, 7, sizeof(cl_mem), &m_nextPopulationBuffer);
+		checkLastErr("clSetKernelArg");
+		
+		size_t globalWorkSize[1] = { ((m_populationSize + LOCAL_WORK_SIZE - 1)/LOCAL_WORK_SIZE)*LOCAL_WORK_SIZE };
+		size_t localWorkSize[1] = { LOCAL_WORK_SIZE };
+		m_lastErrNum = clEnqueueNDRangeKernel(
+			m_queue,
+			m_reproduceKernel,
+			1,
+			NULL,
+			globalWorkSize,
+			localWorkSize,
+			0,
+			NULL,
+			NULL);
+		checkLastErr("clEnqueueNDRangeKernel");
 		
-		// set sizes of local memory scratch space arrays for each work group
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 11, sizeof(bool)*m_numPuzzlePoints*LOCAL_WORK_SIZE, NULL);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 12, sizeof(bool)*m_numPuzzleEdges*LOCAL_WORK_SIZE, NULL);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 13, sizeof(char)*m_numPuzzleSpaces*LOCAL_WORK_SIZE, NULL);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 14, sizeof(bool)*m_numPuzzleSpaces*LOCAL_WORK_SIZE, NULL);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 15, sizeof(bool)*m_numPuzzleSpaces*LOCAL_WORK_SIZE, NULL);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 16, sizeof(unsigned char)*m_numPuzzleSpaces*LOCAL_WORK_SIZE, NULL);
-		
-		// set output arguments
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 17, sizeof(cl_mem), &m_fitnessBuffer);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 18, sizeof(cl_mem), &m_startPointBuffer);
-		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 19, sizeof(cl_mem), &m_pathsBuffer);
+		// the next population becomes the current population
+		cl_mem population = m_populationBuffer;
+		m_populationBuffer = m_nextPopulationBuffer;
+		m_nextPopulationBuffer = population;
 		
+		m_lastErrNum = clSetKernelArg(m_evaluateKernel, 0, sizeof(cl_mem), &m_populationBuffer);
 		checkLastErr("clSetKernelArg");
 	}
 	
-	void GeneticSolver::transferPuzzleData(const Puzzle& puzzle)
+	void GeneticSolver::runSelectionKernels(GenerationBuffers& buffers)
 	{
-		m_lastErrNum = clEnqueueWriteBuffer(
+		// the previous selection on these buffers finished two generations
+		// ago
+		recordSelectionTime(buffers);
+		
+		// build the lookup structure of the selection method (if it has one)
+		cl_kernel selectKernel;
+		cl_uint generationArg;
+		switch (m_selectionMethod) {
+			case SelectionMethod::ALIAS:
+			{
+				// one work group per island (only the pairing of underfull
+				// and full columns in Vose's method is sequential)
+				m_lastErrNum = clSetKernelArg(m_aliasKernel, 0, sizeof(cl_mem), &buffers.fitness);
+				m_lastErrNum |= clSetKernelArg(m_aliasKernel, 3, sizeof(cl_mem), &buffers.fitnessStats);
+				checkLastErr("clSetKernelArg");
+				
+				size_t aliasWorkSize[1] = { m_numIslands*m_aliasWorkSize };
+				size_t aliasLocalWorkSize[1] = { m_aliasWorkSize };
+				m_lastErrNum = clEnqueueNDRangeKernel(
+					m_queue,
+					m_aliasKernel,
+					1,
+					NULL,
+					aliasWorkSize,
+					aliasLocalWorkSize,
+					0,
+					NULL,
+					&buffers.selectionEvents[0]);
+				checkLastErr("clEnqueueNDRangeKernel");
+				
+				selectKernel = m_selectAliasKernel;
+				generationArg = 7;
+				break;
+			}
+			case SelectionMethod::TOURNAMENT:
+				// candidates are compared directly (no lookup structure)
+				m_lastErrNum = clSetKernelArg(m_selectTournamentKernel, 0, sizeof(cl_mem), &buffers.fitness);
+				checkLastErr("clSetKernelArg");
+				
+				selectKernel = m_selectTournamentKernel;
+				generationArg = 6;
+				break;
+			default:
+			{
+				// prefix sum of normalized fitness (single work group, the
+				// minimum fitness is read from the statistics on the device)
+				m_lastErrNum = clSetKernelArg(m_scanKernel, 0, sizeof(cl_mem), &buffers.fitness);
+				m_lastErrNum |= clSetKernelArg(m_scanKernel, 2, sizeof(cl_mem), &buffers.fitnessStats);
+				checkLastErr("clSetKernelArg");
+				
+				size_t scanWorkSize[1] = { m_scanWorkSize };
+				m_lastErrNum = clEnqueueNDRangeKernel(
+					m_queue,
+					m_scanKernel,
+					1,
+					NULL,
+					scanWorkSize,
+					scanWorkSize,
+					0,
+					NULL,
+					&buffers.selectionEvents[0]);
+				checkLastErr("clEnqueueNDRangeKernel");
+				
+				selectKernel = m_selectRouletteKernel;
+				generationArg = 5;
+				break;
+			}
+		}
+		
+		// select mates
+		unsigned int generation = (unsigned int)m_numIterations;
+		m_lastErrNum = clSetKernelArg(selectKernel, generationArg, sizeof(unsigned int), &generation);
+		checkLastErr("clSetKernelArg");
+		
+		size_t globalWorkSize[1] = { ((m_populationSize + LOCAL_WORK_SIZE - 1)/LOCAL_WORK_SIZE)*LOCAL_WORK_SIZE };
+		size_t localWorkSize[1] = { LOCAL_WORK_SIZE };
+		m_lastErrNum = clEnqueueNDRangeKernel(
 			m_queue,
-			m_puzzlePointBuffer,
-			CL_FALSE,
-			0,
-			sizeof(char)*m_numPuzzlePoints,
-			(void*)puzzle.getPointData(),
+			selectKernel,
+			1,
+			NULL,
+			globalWorkSize,
+			localWorkSize,
 			0,
 			NULL,
-			NULL);
-		checkLastErr("clEnqueueWriteBuffer");
+			&buffers.selectionEvents[1]);
+		checkLastErr("clEnqueueNDRangeKernel");
+	}
+	
+	bool GeneticSolver::isMigrationGeneration() const
+	{
+		return m_islandExchange != NULL && m_numMigrants > 0 && m_migrationInterval > 0
+		       && m_numIterations > 0 && m_numIterations%m_migrationInterval == 0;
+	}
+	
+	void GeneticSolver::runMigrationKernels(const GenerationBuffers& buffers)
+	{
+		// copy out the island's emigrants and find the weakest members they
+		// replace (one work item, since finding them is sequential)
+		m_lastErrNum = clSetKernelArg(m_collectKernel, 0, sizeof(cl_mem), &m_populationBuffer);
+		m_lastErrNum |= clSetKernelArg(m_collectKernel, 1, sizeof(cl_mem), &buffers.fitness);
+		checkLastErr("clSetKernelArg");
 		
-		m_lastErrNum = clEnqueueWriteBuffer(
+		size_t collectWorkSize[1] = { m_numIslands };
+		size_t collectLocalWorkSize[1] = { 1 };
+		m_lastErrNum = clEnqueueNDRangeKernel(
 			m_queue,
-			m_puzzleEdgeBuffer,
-			CL_FALSE,
-			0,
-			sizeof(char)*m_numPuzzleEdges,
-			(void*)puzzle.getEdgeData(),
+			m_collectKernel,
+			1,
+			NULL,
+			collectWorkSize,
+			collectLocalWorkSize,
 			0,
 			NULL,
 			NULL);
+		checkLastErr("clEnqueueNDRangeKernel");
+		
+		// trade the emigrants for another island's through host memory (once
+		// every island has reached the migration)
+		std::vector<unsigned char> migrantGenes(m_numMigrants*m_genomeBytes);
+		std::vector<int> migrantFitness(m_numMigrants);
+		m_lastErrNum = clEnqueueReadBuffer(m_queue, m_emigrantBuffer, CL_FALSE, 0, sizeof(unsigned char)*migrantGenes.size(),
+		                                   (void*)migrantGenes.data(), 0, NULL, NULL);
+		m_lastErrNum |= clEnqueueReadBuffer(m_queue, m_emigrantFitnessBuffer, CL_TRUE, 0, sizeof(int)*migrantFitness.size(),
+		                                    (void*)migrantFitness.data(), 0, NULL, NULL);
+		checkLastErr("clEnqueueReadBuffer");
+		
+		if (!m_islandExchange->migrate(m_island, m_numIterations, migrantGenes.data(), migrantFitness.data())) {
+			return;
+		}
+		
+		m_lastErrNum = clEnqueueWriteBuffer(m_queue, m_emigrantBuffer, CL_FALSE, 0, sizeof(unsigned char)*migrantGenes.size(),
+		                                    (void*)migrantGenes.data(), 0, NULL, NULL);
+		m_lastErrNum |= clEnqueueWriteBuffer(m_queue, m_emigrantFitnessBuffer, CL_TRUE, 0, sizeof(int)*migrantFitness.size(),
+		                                     (void*)migrantFitness.data(), 0, NULL, NULL);
 		checkLastErr("clEnqueueWriteBuffer");
 		
-		m_lastErrNum = clEnqueueWriteBuffer(
+		// replace the weakest members with the immigrants, now in the
+		// island's own emigrant slots (migrants keep their fitness, and the
+		// minimum fitness covers them, so selection sees them in this
+		// generation)
+		cl_uint shift = 0;
+		m_lastErrNum = clSetKernelArg(m_receiveKernel, 7, sizeof(cl_uint), &shift);
+		m_lastErrNum |= clSetKernelArg(m_receiveKernel, 8, sizeof(cl_mem), &m_populationBuffer);
+		m_lastErrNum |= clSetKernelArg(m_receiveKernel, 9, sizeof(cl_mem), &buffers.fitness);
+		m_lastErrNum |= clSetKernelArg(m_receiveKernel, 10, sizeof(cl_mem), &buffers.fitnessStats);
+		checkLastErr("clSetKernelArg");
+		
+		size_t numTotalMigrants = m_numIslands*m_numMigrants;
+		size_t globalWorkSize[1] = { ((numTotalMigrants + LOCAL_WORK_SIZE - 1)/LOCAL_WORK_SIZE)*LOCAL_WORK_SIZE };
+		size_t localWorkSize[1] = { LOCAL_WORK_SIZE };
+		m_lastErrNum = clEnqueueNDRangeKernel(
 			m_queue,
-			m_puzzleSpaceBuffer,
-			CL_FALSE,
-			0,
-			sizeof(char)*m_numPuzzleSpaces,
-			(void*)puzzle.getSpaceData(),
+			m_receiveKernel,
+			1,
+			NULL,
+			globalWorkSize,
+			localWorkSize,
 			0,
 			NULL,
 			NULL);
-		checkLastErr("clEnqueueWriteBuffer");
+		checkLastErr("clEnqueueNDRangeKernel");
 	}
 	
-	void GeneticSolver::runEvaluationKernel(const unsigned char* population, int* fitness, unsigned int* startPoints, char* paths)
+	void GeneticSolver::recordSelectionTime(GenerationBuffers& buffers)
 	{
-		// copy current population to device
-		m_lastErrNum = clEnqueueWriteBuffer(
-			m_queue,
-			m_populationBuffer,
+		if (buffers.selectionEvents[1] != 0) {
+			// time from the start of the first selection command (the
+			// selection kernel itself if there is no lookup structure) to the
+			// end of the last one
+			cl_event firstEvent = buffers.selectionEvents[0] != 0 ? buffers.selectionEvents[0] : buffers.selectionEvents[1];
+			m_lastErrNum = clWaitForEvents(1, &buffers.selectionEvents[1]);
+			checkLastErr("clWaitForEvents");
+			
+			cl_ulong startTime;
+			cl_ulong endTime;
+			m_lastErrNum = clGetEventProfilingInfo(firstEvent, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &startTime, NULL);
+			m_lastErrNum |= clGetEventProfilingInfo(buffers.selectionEvents[1], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &endTime, NULL);
+			checkLastErr("clGetEventProfilingInfo");
+			
+			// profiling times are in ns
+			m_selectionTime += (endTime - startTime)/1000000.0f;
+			
+			for (size_t i = 0; i < 2; ++i) {
+				if (buffers.selectionEvents[i] != 0) {
+					clReleaseEvent(buffers.selectionEvents[i]);
+					buffers.selectionEvents[i] = 0;
+				}
+			}
+		}
+	}
+	
+	void GeneticSolver::readMember(const GenerationBuffers& buffers, size_t member, char* memberPath, unsigned int& startPoint)
+	{
+		m_lastErrNum = clEnqueueReadBuffer(
+			m_transferQueue,
+			buffers.startPoints,
 			CL_FALSE,
-			0,
-			sizeof(unsigned char)*m_populationSize*m_numPuzzlePoints,
-			(void*)population,
+			sizeof(unsigned int)*member,
+			sizeof(unsigned int),
+			(void*)&startPoint,
 			0,
 			NULL,
 			NULL);
-		checkLastErr("clEnqueueWriteBuffer");
+		checkLastErr("clEnqueueReadBuffer");
 		
-		// run kernel
-		size_t globalWorkSize[1] = { m_populationSize };
-		size_t localWorkSize[1] = { LOCAL_WORK_SIZE };
+		std::vector<unsigned char> packedPath(m_pathBytes);
+		if (m_populationLayout == PopulationLayout::INTERLEAVED) {
+			// gather the member's column of path bytes
+			size_t bufferOrigin[3] = { member, 0, 0 };
+			size_t hostOrigin[3] = { 0, 0, 0 };
+			size_t region[3] = { 1, m_pathBytes, 1 };
+			m_lastErrNum = clEnqueueReadBufferRect(
+				m_transferQueue,
+				buffers.paths,
+				CL_TRUE,
+				bufferOrigin,
+				hostOrigin,
+				region,
+				sizeof(unsigned char)*m_populationSize,
+				0,
+				sizeof(unsigned char),
+				0,
+				(void*)packedPath.data(),
+				0,
+				NULL,
+				NULL);
+			checkLastErr("clEnqueueReadBufferRect");
+		}
+		else {
+			m_lastErrNum = clEnqueueReadBuffer(
+				m_transferQueue,
+				buffers.paths,
+				CL_TRUE,
+				sizeof(unsigned char)*member*m_pathBytes,
+				sizeof(unsigned char)*m_pathBytes,
+				(void*)packedPath.data(),
+				0,
+				NULL,
+				NULL);
+			checkLastErr("clEnqueueReadBuffer");
+		}
+		
+		unpackPath(packedPath.data(), m_numPuzzlePoints, memberPath);
+	}
+	
+	void GeneticSolver::readMembers(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t bufferMember, size_t hostMember, size_t numMembers, size_t memberBytes, void* data, cl_event* event)
+	{
+		if (m_populationLayout == PopulationLayout::INTERLEAVED) {
+			// each byte of a member is a row of the whole population
+			size_t bufferOrigin[3] = { bufferMember, 0, 0 };
+			size_t hostOrigin[3] = { hostMember, 0, 0 };
+			size_t region[3] = { numMembers, memberBytes, 1 };
+			m_lastErrNum = clEnqueueReadBufferRect(
+				queue,
+				buffer,
+				blocking,
+				bufferOrigin,
+				hostOrigin,
+				region,
+				sizeof(char)*m_populationSize,
+				0,
+				sizeof(char)*m_populationSize,
+				0,
+				data,
+				0,
+				NULL,
+				event);
+			checkLastErr("clEnqueueReadBufferRect");
+		}
+		else {
+			m_lastErrNum = clEnqueueReadBuffer(
+				queue,
+				buffer,
+				blocking,
+				sizeof(char)*bufferMember*memberBytes,
+				sizeof(char)*numMembers*memberBytes,
+				(void*)((char*)data + hostMember*memberBytes),
+				0,
+				NULL,
+				event);
+			checkLastErr("clEnqueueReadBuffer");
+		}
+	}
+	
+	void GeneticSolver::writeMembers(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t bufferMember, size_t hostMember, size_t numMembers, size_t memberBytes, const void* data, cl_event* event)
+	{
+		if (m_populationLayout == PopulationLayout::INTERLEAVED) {
+			// each byte of a member is a row of the whole population
+			size_t bufferOrigin[3] = { bufferMember, 0, 0 };
+			size_t hostOrigin[3] = { hostMember, 0, 0 };
+			size_t region[3] = { numMembers, memberBytes, 1 };
+			m_lastErrNum = clEnqueueWriteBufferRect(
+				queue,
+				buffer,
+				blocking,
+				bufferOrigin,
+				hostOrigin,
+				region,
+				sizeof(char)*m_populationSize,
+				0,
+				sizeof(char)*m_populationSize,
+				0,
+				data,
+				0,
+				NULL,
+				event);
+			checkLastErr("clEnqueueWriteBufferRect");
+		}
+		else {
+			m_lastErrNum = clEnqueueWriteBuffer(
+				queue,
+				buffer,
+				blocking,
+				sizeof(char)*bufferMember*memberBytes,
+				sizeof(char)*numMembers*memberBytes,
+				(const void*)((const char*)data + hostMember*memberBytes),
+				0,
+				NULL,
+				event);
+			checkLastErr("clEnqueueWriteBuffer");
+		}
+	}
+	
+	void GeneticSolver::enqueueEvaluation(GenerationBuffers& buffers, int maxPuzzleFitness)
+	{
+		// with more than one device, read back the members evaluated by the
+		// other devices once the population is ready (the primary device
+		// evaluates the first share, and the other shares follow it)
+		if (!m_shards.empty()) {
+			balanceShards();
+			
+			size_t firstMember = m_primaryShare.numMembers;
+			readMembers(m_queue, m_populationBuffer, CL_FALSE, firstMember, firstMember, m_populationSize - firstMember, m_genomeBytes, m_shardPopulation, &buffers.populationEvent);
+		}
+		
+		// evaluate the primary device's share of the current population into
+		// this generation's buffers (timed to balance the shares if there
+		// are other devices)
+		size_t numMembers = m_primaryShare.numMembers;
+		m_lastErrNum = clSetKernelArg(m_evaluateKernel, 16, sizeof(cl_mem), &buffers.fitness);
+		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 17, sizeof(cl_mem), &buffers.startPoints);
+		m_lastErrNum |= clSetKernelArg(m_evaluateKernel, 18, sizeof(cl_mem), &buffers.paths);
+		checkLastErr("clSetKernelArg");
+		
+		runEvaluateKernel(m_queue, m_evaluateKernel, m_evaluateWorkSize, numMembers, m_shards.empty() ? NULL : &buffers.evaluateEvent);
+		
+		if (!m_shards.empty()) {
+			buffers.evaluatedMembers = numMembers;
+			
+			// start the primary device (the other devices' shares and the
+			// reduction are queued by finishEvaluation)
+			m_lastErrNum = clFlush(m_queue);
+			checkLastErr("clFlush");
+		}
+		else {
+			enqueueReduction(buffers, maxPuzzleFitness);
+		}
+	}
+	
+	void GeneticSolver::finishEvaluation(GenerationBuffers& buffers, int maxPuzzleFitness)
+	{
+		if (buffers.populationEvent != 0) {
+			runShardEvaluation(buffers, buffers.populationEvent);
+			clReleaseEvent(buffers.populationEvent);
+			buffers.populationEvent = 0;
+			
+			enqueueReduction(buffers, maxPuzzleFitness);
+		}
+	}
+	
+	void GeneticSolver::enqueueReduction(GenerationBuffers& buffers, int maxPuzzleFitness)
+	{
+		// reduce fitness values to the population statistics (single work
+		// group)
+		m_lastErrNum = clSetKernelArg(m_reduceKernel, 0, sizeof(cl_mem), &buffers.fitness);
+		m_lastErrNum |= clSetKernelArg(m_reduceKernel, 2, sizeof(int), &maxPuzzleFitness);
+		m_lastErrNum |= clSetKernelArg(m_reduceKernel, 4, sizeof(cl_mem), &buffers.fitnessStats);
+		checkLastErr("clSetKernelArg");
+		
+		cl_event reduceEvent;
+		size_t reduceWorkSize[1] = { m_reduceWorkSize };
 		m_lastErrNum = clEnqueueNDRangeKernel(
 			m_queue,
-			m_evaluateKernel,
+			m_reduceKernel,
 			1,
 			NULL,
-			globalWorkSize,
-			localWorkSize,
+			reduceWorkSize,
+			reduceWorkSize,
 			0,
 			NULL,
-			NULL);
+			&reduceEvent);
 		checkLastErr("clEnqueueNDRangeKernel");
 		
-		// copy fitness and path results back to host
+		// copy statistics back to host on the transfer queue once they are
+		// ready (fitness values, start points and paths stay on the device)
 		m_lastErrNum = clEnqueueReadBuffer(
-			m_queue,
-			m_fitnessBuffer,
+			m_transferQueue,
+			buffers.fitnessStats,
 			CL_FALSE,
 			0,
-			sizeof(int)*m_populationSize,
-			(void*)fitness,
+			sizeof(FitnessStats),
+			(void*)&buffers.stats,
+			1,
+			&reduceEvent,
+			&buffers.statsEvent);
+		clReleaseEvent(reduceEvent);
+		checkLastErr("clEnqueueReadBuffer");
+		
+		// submit work without waiting for it
+		m_lastErrNum = clFlush(m_queue);
+		m_lastErrNum |= clFlush(m_transferQueue);
+		checkLastErr("clFlush");
+	}
+	
+	void GeneticSolver::enqueueBatchEvaluation(GenerationBuffers& buffers, size_t numPuzzles)
+	{
+		// evaluate every member of every puzzle with one launch (on the
+		// primary device only)
+		m_lastErrNum = clSetKernelArg(m_batchEvaluateKernel, 0, sizeof(cl_mem), &m_populationBuffer);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 16, sizeof(cl_mem), &buffers.fitness);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 17, sizeof(cl_mem), &buffers.startPoints);
+		m_lastErrNum |= clSetKernelArg(m_batchEvaluateKernel, 18, sizeof(cl_mem), &buffers.paths);
+		checkLastErr("clSetKernelArg");
+		
+		runEvaluateKernel(m_queue, m_batchEvaluateKernel, m_batchEvaluateWorkSize, m_populationSize, NULL);
+		
+		// reduce fitness values to each puzzle's statistics and the whole
+		// population's statistics used by selection (single work group)
+		m_lastErrNum = clSetKernelArg(m_batchReduceKernel, 0, sizeof(cl_mem), &buffers.fitness);
+		m_lastErrNum |= clSetKernelArg(m_batchReduceKernel, 6, sizeof(cl_mem), &buffers.fitnessStats);
+		m_lastErrNum |= clSetKernelArg(m_batchReduceKernel, 7, sizeof(cl_mem), &buffers.puzzleStats);
+		checkLastErr("clSetKernelArg");
+		
+		cl_event reduceEvent;
+		size_t reduceWorkSize[1] = { m_batchReduceWorkSize };
+		m_lastErrNum = clEnqueueNDRangeKernel(
+			m_queue,
+			m_batchReduceKernel,
+			1,
+			NULL,
+			reduceWorkSize,
+			reduceWorkSize,
 			0,
 			NULL,
-			NULL);
-		checkLastErr("clEnqueueReadBuffer");
+			&reduceEvent);
+		checkLastErr("clEnqueueNDRangeKernel");
 		
+		// copy each puzzle's statistics back to host on the transfer queue
+		// once they are ready
 		m_lastErrNum = clEnqueueReadBuffer(
-			m_queue,
-			m_startPointBuffer,
+			m_transferQueue,
+			buffers.puzzleStats,
 			CL_FALSE,
 			0,
-			sizeof(unsigned int)*m_populationSize,
-			(void*)startPoints,
+			sizeof(FitnessStats)*numPuzzles,
+			(void*)buffers.hostPuzzleStats,
+			1,
+			&reduceEvent,
+			&buffers.statsEvent);
+		clReleaseEvent(reduceEvent);
+		checkLastErr("clEnqueueReadBuffer");
+		
+		// submit work without waiting for it
+		m_lastErrNum = clFlush(m_queue);
+		m_lastErrNum |= clFlush(m_transferQueue);
+		checkLastErr("clFlush");
+	}
+	
+	void GeneticSolver::waitForStats(GenerationBuffers& buffers)
+	{
+		if (buffers.statsEvent != 0) {
+			m_lastErrNum = clWaitForEvents(1, &buffers.statsEvent);
+			clReleaseEvent(buffers.statsEvent);
+			buffers.statsEvent = 0;
+			checkLastErr("clWaitForEvents");
+		}
+		
+		// the primary device's evaluation is finished along with the
+		// statistics
+		if (buffers.evaluateEvent != 0) {
+			recordDeviceThroughput(m_primaryShare, buffers.evaluatedMembers, buffers.evaluateEvent, buffers.evaluateEvent);
+			clReleaseEvent(buffers.evaluateEvent);
+			buffers.evaluateEvent = 0;
+		}
+	}
+	
+	void GeneticSolver::runShardEvaluation(GenerationBuffers& buffers, cl_event populationEvent)
+	{
+		// wait for the members to reach the host
+		m_lastErrNum = clWaitForEvents(1, &populationEvent);
+		checkLastErr("clWaitForEvents");
+		
+		// send each share to its device and read back the results (every
+		// device works at the same time)
+		std::vector<cl_event> events(2*m_shards.size());
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			DeviceShard& shard = m_shards[i];
+			size_t firstMember = shard.share.firstMember;
+			size_t numMembers = shard.share.numMembers;
+			
+			writeMembers(shard.queue, shard.populationBuffer, CL_FALSE, 0, firstMember, numMembers, m_genomeBytes, m_shardPopulation, &events[2*i]);
+			
+			runEvaluateKernel(shard.queue, shard.evaluateKernel, shard.evaluateWorkSize, numMembers, NULL);
+			
+			m_lastErrNum = clEnqueueReadBuffer(
+				shard.queue,
+				shard.fitnessBuffer,
+				CL_FALSE,
+				0,
+				sizeof(int)*numMembers,
+				(void*)(buffers.shardFitness + firstMember),
+				0,
+				NULL,
+				NULL);
+			checkLastErr("clEnqueueReadBuffer");
+			
+			m_lastErrNum = clEnqueueReadBuffer(
+				shard.queue,
+				shard.startPointBuffer,
+				CL_FALSE,
+				0,
+				sizeof(unsigned int)*numMembers,
+				(void*)(buffers.shardStartPoints + firstMember),
+				0,
+				NULL,
+				NULL);
+			checkLastErr("clEnqueueReadBuffer");
+			
+			readMembers(shard.queue, shard.pathsBuffer, CL_FALSE, 0, firstMember, numMembers, m_pathBytes, buffers.shardPaths, &events[2*i + 1]);
+			
+			m_lastErrNum = clFlush(shard.queue);
+			checkLastErr("clFlush");
+		}
+		
+		// wait for every device, timing the whole round trip (including the
+		// transfers) so the shares account for the staging cost
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			recordDeviceThroughput(m_shards[i].share, m_shards[i].share.numMembers, events[2*i], events[2*i + 1]);
+			clReleaseEvent(events[2*i]);
+			clReleaseEvent(events[2*i + 1]);
+		}
+		
+		// merge the results into the primary device's buffers (the shares
+		// are contiguous, so each result is a single write, and the staging
+		// memory belongs to this generation so the writes don't need to be
+		// waited on)
+		size_t firstMember = m_primaryShare.numMembers;
+		size_t numMembers = m_populationSize - firstMember;
+		m_lastErrNum = clEnqueueWriteBuffer(
+			m_queue,
+			buffers.fitness,
+			CL_FALSE,
+			sizeof(int)*firstMember,
+			sizeof(int)*numMembers,
+			(void*)(buffers.shardFitness + firstMember),
 			0,
 			NULL,
 			NULL);
-		checkLastErr("clEnqueueReadBuffer");
+		checkLastErr("clEnqueueWriteBuffer");
 		
-		m_lastErrNum = clEnqueueReadBuffer(
+		m_lastErrNum = clEnqueueWriteBuffer(
 			m_queue,
-			m_pathsBuffer,
-			CL_TRUE,
-			0,
-			sizeof(char)*m_populationSize*m_numPuzzlePoints,
-			(void*)paths,
+			buffers.startPoints,
+			CL_FALSE,
+			sizeof(unsigned int)*firstMember,
+			sizeof(unsigned int)*numMembers,
+			(void*)(buffers.shardStartPoints + firstMember),
 			0,
 			NULL,
 			NULL);
-		checkLastErr("clEnqueueReadBuffer");
+		checkLastErr("clEnqueueWriteBuffer");
+		
+		writeMembers(m_queue, buffers.paths, CL_FALSE, firstMember, firstMember, numMembers, m_pathBytes, buffers.shardPaths, NULL);
+	}
+	
+	void GeneticSolver::recordDeviceThroughput(DeviceShare& share, size_t numMembers, cl_event firstEvent, cl_event lastEvent)
+	{
+		m_lastErrNum = clWaitForEvents(1, &lastEvent);
+		checkLastErr("clWaitForEvents");
+		
+		cl_ulong startTime;
+		cl_ulong endTime;
+		m_lastErrNum = clGetEventProfilingInfo(firstEvent, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &startTime, NULL);
+		m_lastErrNum |= clGetEventProfilingInfo(lastEvent, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &endTime, NULL);
+		checkLastErr("clGetEventProfilingInfo");
+		
+		// profiling times are in ns (smooth the measurements so one slow
+		// generation doesn't swing the shares)
+		if (endTime > startTime) {
+			double throughput = numMembers/((endTime - startTime)/1000000.0);
+			share.measuredThroughput = share.measured ? 0.5*(share.measuredThroughput + throughput) : throughput;
+			share.measured = true;
+		}
 	}
 	
 	void GeneticSolver::cleanup()
 	{
-		// clean up memory buffers
-		if (m_puzzlePointBuffer != 0) {
-			clReleaseMemObject(m_puzzlePointBuffer);
+		// clean up the islands (they hold references to the context and
+		// programs)
+		releaseIslandSolvers();
+		
+		// clean up memory buffers (buffers sized by the puzzle go back to the
+		// pool, which releases them)
+		m_bufferPool->release(m_puzzlePointBuffer);
+		m_bufferPool->release(m_puzzleEdgeBuffer);
+		m_bufferPool->release(m_puzzleSpaceBuffer);
+		m_bufferPool->release(m_populationBuffer);
+		m_bufferPool->release(m_nextPopulationBuffer);
+		if (m_fitnessPrefixBuffer != 0) {
+			clReleaseMemObject(m_fitnessPrefixBuffer);
+		}
+		if (m_aliasProbabilityBuffer != 0) {
+			clReleaseMemObject(m_aliasProbabilityBuffer);
 		}
-		if (m_puzzleEdgeBuffer != 0) {
-			clReleaseMemObject(m_puzzleEdgeBuffer);
+		if (m_aliasBuffer != 0) {
+			clReleaseMemObject(m_aliasBuffer);
 		}
-		if (m_puzzleSpaceBuffer != 0) {
-			clReleaseMemObject(m_puzzleSpaceBuffer);
+		if (m_aliasWorklistBuffer != 0) {
+			clReleaseMemObject(m_aliasWorklistBuffer);
 		}
-		if (m_populationBuffer != 0) {
-			clReleaseMemObject(m_populationBuffer);
+		if (m_mateBuffer != 0) {
+			clReleaseMemObject(m_mateBuffer);
 		}
-		if (m_fitnessBuffer != 0) {
-			clReleaseMemObject(m_fitnessBuffer);
+		releaseIslandBuffers();
+		releaseBatchBuffers();
+		for (size_t i = 0; i < 2; ++i) {
+			GenerationBuffers& buffers = m_generationBuffers[i];
+			if (buffers.fitness != 0) {
+				clReleaseMemObject(buffers.fitness);
+			}
+			if (buffers.fitnessStats != 0) {
+				clReleaseMemObject(buffers.fitnessStats);
+			}
+			if (buffers.startPoints != 0) {
+				clReleaseMemObject(buffers.startPoints);
+			}
+			m_bufferPool->release(buffers.paths);
+			delete [] buffers.shardFitness;
+			delete [] buffers.shardStartPoints;
+			delete [] buffers.shardPaths;
 		}
-		if (m_pathsBuffer != 0) {
-			clReleaseMemObject(m_pathsBuffer);
+		delete [] m_shardPopulation;
+		delete [] m_memberPath;
+		delete m_bufferPool;
+		
+		// clean up the other devices' resources
+		for (size_t i = 0; i < m_shards.size(); ++i) {
+			DeviceShard& shard = m_shards[i];
+			if (shard.bufferPool != NULL) {
+				shard.bufferPool->release(shard.puzzlePointBuffer);
+				shard.bufferPool->release(shard.puzzleEdgeBuffer);
+				shard.bufferPool->release(shard.puzzleSpaceBuffer);
+				shard.bufferPool->release(shard.populationBuffer);
+				shard.bufferPool->release(shard.pathsBuffer);
+				delete shard.bufferPool;
+			}
+			cl_mem buffers[] = {
+				shard.fitnessBuffer,
+				shard.startPointBuffer
+			};
+			for (size_t j = 0; j < sizeof(buffers)/sizeof(cl_mem); ++j) {
+				if (buffers[j] != 0) {
+					clReleaseMemObject(buffers[j]);
+				}
+			}
+			if (shard.evaluateKernel != 0) {
+				clReleaseKernel(shard.evaluateKernel);
+			}
+			if (shard.program != 0) {
+				clReleaseProgram(shard.program);
+			}
+			for (auto variant = shard.specializedPrograms.begin(); variant != shard.specializedPrograms.end(); ++variant) {
+				clReleaseProgram(variant->second);
+			}
+			if (shard.queue != 0) {
+				clReleaseCommandQueue(shard.queue);
+			}
+			if (shard.context != 0) {
+				clReleaseContext(shard.context);
+			}
 		}
+		m_shards.clear();
 		
-		// clean up command queue
+		// clean up command queues
 		if (m_queue != 0) {
 			clReleaseCommandQueue(m_queue);
 		}
+		if (m_transferQueue != 0) {
+			clReleaseCommandQueue(m_transferQueue);
+		}
 		
-		// clean up kernel and program
+		// clean up kernels and program
+		if (m_generateKernel != 0) {
+			clReleaseKernel(m_generateKernel);
+		}
 		if (m_evaluateKernel != 0) {
 			clReleaseKernel(m_evaluateKernel);
 		}
+		if (m_reduceKernel != 0) {
+			clReleaseKernel(m_reduceKernel);
+		}
+		if (m_scanKernel != 0) {
+			clReleaseKernel(m_scanKernel);
+		}
+		if (m_aliasKernel != 0) {
+			clReleaseKernel(m_aliasKernel);
+		}
+		if (m_selectRouletteKernel != 0) {
+			clReleaseKernel(m_selectRouletteKernel);
+		}
+		if (m_selectAliasKernel != 0) {
+			clReleaseKernel(m_selectAliasKernel);
+		}
+		if (m_selectTournamentKernel != 0) {
+			clReleaseKernel(m_selectTournamentKernel);
+		}
+		if (m_collectKernel != 0) {
+			clReleaseKernel(m_collectKernel);
+		}
+		if (m_receiveKernel != 0) {
+			clReleaseKernel(m_receiveKernel);
+		}
+		if (m_reproduceKernel != 0) {
+			clReleaseKernel(m_reproduceKernel);
+		}
+		if (m_batchEvaluateKernel != 0) {
+			clReleaseKernel(m_batchEvaluateKernel);
+		}
+		if (m_batchReduceKernel != 0) {
+			clReleaseKernel(m_batchReduceKernel);
+		}
 		if (m_program != 0) {
 			clReleaseProgram(m_program);
 		}
+		for (auto variant = m_specializedPrograms.begin(); variant != m_specializedPrograms.end(); ++variant) {
+			clReleaseProgram(variant->second);
+		}
+		m_specializedPrograms.clear();
 		
 		// clean up context
 		if (m_context != 0) {
@@ -8,6 +8,10 @@
 #ifndef gws_GeneticSolver_h
 #define gws_GeneticSolver_h
 
+#include "BufferPool.h"
+#include "Islands.h"
+#include "ProgramCache.h"
+#include "Selection.h"
 #include "Solver.h"
 
 #ifdef __APPLE__
@@ -16,20 +20,68 @@
 	#include <CL/cl.h>
 #endif
 
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace gws
 {
 	class Path;
 	class Puzzle;
 	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief How population members and their paths are laid out in device
+	/// memory
+	/// 
+	/// Both layouts produce the same results for the same seed.
+	///////////////////////////////////////////////////////////////////////////
+	enum class PopulationLayout
+	{
+		// each member's genes (and path moves) are contiguous
+		MEMBER_MAJOR = 0,
+		
+		// the same gene of every member is contiguous, so work items on
+		// adjacent members make coalesced accesses
+		INTERLEAVED
+	};
+	
 	///////////////////////////////////////////////////////////////////////////
 	/// \class GeneticSolver
 	/// \brief Puzzle solver that executes a genetic algorithm on the GPU
+	/// 
+	/// The algorithm runs on the first OpenCL GPU found (or the first device
+	/// of any type if there is no GPU). Every other device, on any platform,
+	/// evaluates a share of each generation's population, while selection,
+	/// crossover and mutation stay on the primary device. With an island
+	/// model, every island is instead a separate solver with its own queues
+	/// and buffers, and the islands take turns on the devices.
+	/// 
+	/// One solver can solve puzzles of any size: the buffers sized by the
+	/// puzzle are swapped for pooled buffers of the new size when the puzzle
+	/// size changes, while the context, queues, programs and other buffers
+	/// are kept. Solving another puzzle of a size already seen only uploads
+	/// the puzzle data again.
 	///////////////////////////////////////////////////////////////////////////
 	class GeneticSolver : public Solver
 	{
 	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \struct BatchResult
+		/// \brief The result of one puzzle of a batch solve
+		///////////////////////////////////////////////////////////////////////
+		struct BatchResult
+		{
+			// whether the puzzle was solved, and the number of generations
+			// it took (or the number run if it wasn't solved)
+			bool solved;
+			size_t numIterations;
+			
+			// the best fitness reached and the max fitness of the puzzle
+			int maxFitness;
+			int maxPuzzleFitness;
+		};
+		
 		GeneticSolver(
 			size_t puzzleWidth,
 			size_t puzzleHeight,
@@ -37,7 +89,8 @@ namespace gws
 			size_t maxIterations,
 			float crossoverRate,
 			float mutationRate,
-			unsigned int seed);
+			unsigned int seed,
+			PopulationLayout populationLayout = PopulationLayout::MEMBER_MAJOR);
 		
 		///////////////////////////////////////////////////////////////////////
 		/// \brief Virtual destructor
@@ -53,6 +106,33 @@ namespace gws
 		///////////////////////////////////////////////////////////////////////
 		virtual bool solvePuzzle(const Puzzle& puzzle, Path& path);
 		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Solve a batch of puzzles at once
+		/// 
+		/// The population is split evenly between the puzzles, and each
+		/// puzzle's members evolve as an island without migration (the
+		/// configured island model is restored afterward). The puzzles are
+		/// concatenated into constant buffers, so each generation scores
+		/// every member of every puzzle with one evaluation launch and one
+		/// reduction launch. Members of solved puzzles are skipped by later
+		/// evaluations, and the solve stops once every puzzle is solved or
+		/// the max iterations are reached.
+		/// 
+		/// Batches are evaluated by the primary device with the generic
+		/// program (without other devices or specialized variants), and the
+		/// genomes are sized for the largest puzzle. The batch evaluation
+		/// kernel's work group size is tuned for the largest puzzle's width
+		/// and height.
+		/// 
+		/// \param [in] puzzles the puzzles
+		/// \param [out] paths the solution path of each solved puzzle (one
+		/// per puzzle)
+		/// \param [out] results the result of each puzzle
+		/// 
+		/// \returns the number of puzzles solved
+		///////////////////////////////////////////////////////////////////////
+		size_t solvePuzzles(const std::vector<const Puzzle*>& puzzles, const std::vector<Path*>& paths, std::vector<BatchResult>& results);
+		
 		///////////////////////////////////////////////////////////////////////
 		/// \brief Get the number of iterations used to solve the puzzle
 		/// 
@@ -60,38 +140,338 @@ namespace gws
 		///////////////////////////////////////////////////////////////////////
 		size_t getNumIterations() const;
 		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Set the method used to select crossover mates (roulette by
+		/// default)
+		/// 
+		/// \param [in] method the selection method
+		///////////////////////////////////////////////////////////////////////
+		void setSelectionMethod(SelectionMethod method);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Set the number of candidates drawn for tournament selection
+		/// 
+		/// \param [in] tournamentSize the number of candidates (at least 1)
+		///////////////////////////////////////////////////////////////////////
+		void setTournamentSize(size_t tournamentSize);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Split the population into islands that evolve separately
+		/// and periodically exchange their fittest members (one island by
+		/// default)
+		/// 
+		/// Each island gets an equal share of the population and its own seed
+		/// (see getIslandSeed()), and is solved by a separate solver with its
+		/// own buffers and queues on the primary device or one of the others
+		/// (in turn). Every island runs its own generation loop on its own
+		/// thread, and migrants are staged through host memory in an
+		/// IslandExchange. The solve ends with the solution found in the
+		/// earliest generation, so results don't depend on thread timing.
+		/// 
+		/// \param [in] numIslands the number of islands
+		/// \param [in] migrationInterval the number of generations between
+		/// migrations (0 for no migration)
+		/// \param [in] numMigrants the number of members each island sends
+		/// per migration (limited to half of an island)
+		/// \param [in] topology the migration topology
+		///////////////////////////////////////////////////////////////////////
+		void setIslandModel(size_t numIslands, size_t migrationInterval, size_t numMigrants, MigrationTopology topology);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the time spent running generations in the last solve
+		/// 
+		/// \returns the total generation time (in ms)
+		///////////////////////////////////////////////////////////////////////
+		float getGenerationTime() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the device time spent selecting crossover mates in the
+		/// last solve (including building the prefix sums or alias table)
+		/// 
+		/// \returns the total selection time (in ms)
+		///////////////////////////////////////////////////////////////////////
+		float getSelectionTime() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of OpenCL devices evaluating the population
+		/// 
+		/// \returns the number of devices (including the primary device)
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumDevices() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the work group size of the fitness evaluation kernel on
+		/// the primary device (of the first island with an island model)
+		/// 
+		/// The size is tuned for the device, puzzle dimensions and
+		/// population size on the first solve.
+		/// 
+		/// \returns the number of work items per work group
+		///////////////////////////////////////////////////////////////////////
+		size_t getEvaluateWorkSize() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Evaluate fitness with program variants compiled for this
+		/// solver's puzzle dimensions (off by default)
+		/// 
+		/// The puzzle width, height and element counts become compile-time
+		/// constants of the evaluation kernel, so the compiler can unroll and
+		/// strength-reduce its loops and index arithmetic. Each variant is
+		/// built once per puzzle size, and its binary is cached on disk like
+		/// the generic program. The work group sizes are tuned again on the
+		/// next solve.
+		/// 
+		/// \param [in] specialized true to use the specialized variants
+		///////////////////////////////////////////////////////////////////////
+		void setSpecializedEvaluation(bool specialized);
+		
 	private:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Initialize the solver of one island of another solver
+		/// 
+		/// The island shares its device's context and program with the other
+		/// solver, but has its own queues, buffers and kernels, and no
+		/// additional devices.
+		/// 
+		/// \param [in] parent the solver running the island model
+		/// \param [in] island the island index
+		/// \param [in] populationSize the number of members in the island
+		/// \param [in] deviceID the island's device
+		/// \param [in] context the device's context
+		/// \param [in] program the device's program
+		///////////////////////////////////////////////////////////////////////
+		GeneticSolver(const GeneticSolver& parent, size_t island, size_t populationSize, cl_device_id deviceID,
+		              cl_context context, cl_program program);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \struct FitnessStats
+		/// \brief Fitness statistics of a population (calculated on the
+		/// device, and must match the layout used by GeneticSolver.cl)
+		///////////////////////////////////////////////////////////////////////
+		struct FitnessStats
+		{
+			cl_int maxFitness;
+			cl_int minFitness;
+			cl_int totalFitness;
+			cl_uint maxMember;
+			cl_int solved;
+		};
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \struct BatchPuzzle
+		/// \brief Location and size of one puzzle of a batch in the
+		/// concatenated puzzle buffers (must match the layout used by
+		/// GeneticSolver.cl)
+		///////////////////////////////////////////////////////////////////////
+		struct BatchPuzzle
+		{
+			cl_uint pointOffset;
+			cl_uint edgeOffset;
+			cl_uint spaceOffset;
+			cl_uint numPoints;
+			cl_uint numEdges;
+			cl_uint numSpaces;
+			cl_uint width;
+			cl_uint height;
+			cl_int maxFitness;
+		};
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \struct GenerationBuffers
+		/// \brief Device buffers holding the evaluation results of one
+		/// generation
+		///////////////////////////////////////////////////////////////////////
+		struct GenerationBuffers
+		{
+			cl_mem fitness;
+			cl_mem fitnessStats;
+			cl_mem startPoints;
+			cl_mem paths;
+			
+			// host copy of the statistics and the event signaling that the
+			// copy is complete (0 if no copy is pending)
+			FitnessStats stats;
+			cl_event statsEvent;
+			
+			// statistics of each puzzle of a batch solve and their host copy
+			// (0 and NULL outside of a batch solve)
+			cl_mem puzzleStats;
+			FitnessStats* hostPuzzleStats;
+			
+			// first and last selection commands run on these results (0 if
+			// not timed yet)
+			cl_event selectionEvents[2];
+			
+			// evaluation command of the primary device's share and the number
+			// of members it evaluated (0 if not timed yet)
+			cl_event evaluateEvent;
+			size_t evaluatedMembers;
+			
+			// read of the members evaluated by the other devices (0 if their
+			// evaluation isn't pending)
+			cl_event populationEvent;
+			
+			// host copies of the results evaluated by the other devices,
+			// staged until they are written to the primary device (NULL if
+			// there is only one device)
+			int* shardFitness;
+			unsigned int* shardStartPoints;
+			unsigned char* shardPaths;
+		};
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \struct DeviceShare
+		/// \brief The range of the population a device evaluates and the
+		/// throughput used to size it
+		///////////////////////////////////////////////////////////////////////
+		struct DeviceShare
+		{
+			size_t firstMember;
+			size_t numMembers;
+			
+			// relative throughput estimated from the device's compute units
+			// and clock, and the measured throughput (members evaluated per
+			// ms, smoothed over generations)
+			double estimatedThroughput;
+			double measuredThroughput;
+			bool measured;
+		};
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \struct DeviceShard
+		/// \brief An additional device evaluating part of the population
+		/// 
+		/// Each device has its own context, so the members it evaluates are
+		/// staged through host memory.
+		///////////////////////////////////////////////////////////////////////
+		struct DeviceShard
+		{
+			cl_device_id deviceID;
+			cl_context context;
+			cl_command_queue queue;
+			BufferPool* bufferPool;
+			cl_program program;
+			std::map<std::pair<size_t, size_t>, cl_program> specializedPrograms;
+			cl_kernel evaluateKernel;
+			
+			cl_mem puzzlePointBuffer;
+			cl_mem puzzleEdgeBuffer;
+			cl_mem puzzleSpaceBuffer;
+			
+			cl_mem populationBuffer;
+			cl_mem fitnessBuffer;
+			cl_mem startPointBuffer;
+			cl_mem pathsBuffer;
+			
+			size_t evaluateWorkSize;
+			DeviceShare share;
+		};
+		
 		size_t m_puzzleWidth;
 		size_t m_puzzleHeight;
 		size_t m_numPuzzlePoints;
 		size_t m_numPuzzleEdges;
 		size_t m_numPuzzleSpaces;
 		
+		// bytes per member of the packed population and paths (see Genome.h)
+		size_t m_genomeBytes;
+		size_t m_pathBytes;
+		
 		size_t m_populationSize;
 		size_t m_maxIterations;
 		float m_crossoverRate;
 		float m_mutationRate;
 		unsigned int m_seed;
+		PopulationLayout m_populationLayout;
+		SelectionMethod m_selectionMethod;
+		size_t m_tournamentSize;
+		size_t m_numIslands;
+		size_t m_migrationInterval;
+		size_t m_numMigrants;
+		MigrationTopology m_migrationTopology;
+		
+		// solvers of the islands (created on the first solve with an island
+		// model), and the exchange shared with the other islands and this
+		// solver's island index (only set for the islands of a solve)
+		std::vector<GeneticSolver*> m_islandSolvers;
+		IslandExchange* m_islandExchange;
+		size_t m_island;
 		
 		size_t m_numIterations;
+		float m_generationTime;
+		float m_selectionTime;
+		bool m_specializedEvaluation;
 		
 		cl_int m_lastErrNum;
 		
 		cl_device_id m_deviceID;
 		cl_context m_context;
 		cl_command_queue m_queue;
+		cl_command_queue m_transferQueue;
+		BufferPool* m_bufferPool;
 		
+		// the primary device runs every stage of the algorithm, and any other
+		// devices only evaluate a share of the population
+		DeviceShare m_primaryShare;
+		std::vector<DeviceShard> m_shards;
+		unsigned char* m_shardPopulation;
+		
+		// host memory sized by the puzzle holds puzzles of up to this many
+		// points (it only grows)
+		char* m_memberPath;
+		size_t m_hostPointCapacity;
+		
+		ProgramCache m_programCache;
 		cl_program m_program;
+		std::map<std::pair<size_t, size_t>, cl_program> m_specializedPrograms;
+		cl_kernel m_generateKernel;
 		cl_kernel m_evaluateKernel;
+		cl_kernel m_reduceKernel;
+		cl_kernel m_scanKernel;
+		cl_kernel m_aliasKernel;
+		cl_kernel m_selectRouletteKernel;
+		cl_kernel m_selectAliasKernel;
+		cl_kernel m_selectTournamentKernel;
+		cl_kernel m_collectKernel;
+		cl_kernel m_receiveKernel;
+		cl_kernel m_reproduceKernel;
+		cl_kernel m_batchEvaluateKernel;
+		cl_kernel m_batchReduceKernel;
+		size_t m_reduceWorkSize;
+		size_t m_batchReduceWorkSize;
+		size_t m_batchEvaluateWorkSize;
+		size_t m_scanWorkSize;
+		size_t m_aliasWorkSize;
+		size_t m_evaluateWorkSize;
+		bool m_workSizesTuned;
 		
 		cl_mem m_puzzlePointBuffer;
 		cl_mem m_puzzleEdgeBuffer;
 		cl_mem m_puzzleSpaceBuffer;
 		
 		cl_mem m_populationBuffer;
-		cl_mem m_fitnessBuffer;
-		cl_mem m_startPointBuffer;
-		cl_mem m_pathsBuffer;
+		cl_mem m_nextPopulationBuffer;
+		cl_mem m_fitnessPrefixBuffer;
+		cl_mem m_aliasProbabilityBuffer;
+		cl_mem m_aliasBuffer;
+		cl_mem m_aliasWorklistBuffer;
+		cl_mem m_aliasTotalBuffer;
+		cl_mem m_emigrantBuffer;
+		cl_mem m_emigrantFitnessBuffer;
+		cl_mem m_replacedBuffer;
+		cl_mem m_mateBuffer;
+		
+		// concatenated puzzle data, puzzle locations and solved flags of a
+		// batch solve (0 outside of a batch solve)
+		cl_mem m_batchPointBuffer;
+		cl_mem m_batchEdgeBuffer;
+		cl_mem m_batchSpaceBuffer;
+		cl_mem m_batchPuzzleBuffer;
+		cl_mem m_solvedPuzzleBuffer;
+		
+		// two generations can be in flight: the device evaluates one while
+		// the host handles the results of the other
+		GenerationBuffers m_generationBuffers[2];
 		
 		///////////////////////////////////////////////////////////////////////
 		/// \brief Get the maximum possible fitness score for a puzzle
@@ -103,32 +483,410 @@ namespace gws
 		int calcMaxFitness(const Puzzle& puzzle) const;
 		
 		///////////////////////////////////////////////////////////////////////
-		/// \brief Fill a path with the solution output from a given member
-		/// of the population
+		/// \brief Fill a path with the solution output from a member of the
+		/// population
 		/// 
-		/// \param [in] paths the output path data for the population
-		/// \param [in] startPoints the selected start points
-		/// \param [in] member the population member index
-		/// \param [in] maxLength the max length of each member's path
+		/// \param [in] memberPath the output path data of the member
+		/// \param [in] startPoint the member's selected start point
+		/// \param [in] maxLength the max length of the member's path
 		/// \param [out] path the output path
 		///////////////////////////////////////////////////////////////////////
-		void fillPath(const char* paths, const unsigned int* startPoints, size_t member, size_t maxLength, Path& path) const;
+		void fillPath(const char* memberPath, unsigned int startPoint, size_t maxLength, Path& path) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Prepare the device for a puzzle (resizing the solver,
+		/// transferring the puzzle data and tuning the work group sizes as
+		/// needed)
+		/// 
+		/// \param [in] puzzle the puzzle
+		///////////////////////////////////////////////////////////////////////
+		void preparePuzzle(const Puzzle& puzzle);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Generate the population and run generations until a
+		/// solution is found (or the islands stop)
+		/// 
+		/// \param [in] maxPuzzleFitness the max fitness of the puzzle
+		/// \param [out] path the solution path
+		/// 
+		/// \returns true if a solution was found, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool evolvePopulation(int maxPuzzleFitness, Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Solve a puzzle with the island solvers, each running on its
+		/// own thread
+		/// 
+		/// \param [in] puzzle the puzzle to solve
+		/// \param [out] path the solution found by the winning island
+		/// 
+		/// \returns true if any island found a solution, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool solveIslands(const Puzzle& puzzle, Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Create a solver for every island of the island model
+		///////////////////////////////////////////////////////////////////////
+		void createIslandSolvers();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Release the solvers of the islands
+		///////////////////////////////////////////////////////////////////////
+		void releaseIslandSolvers();
 		
 		///////////////////////////////////////////////////////////////////////
 		/// \brief Initialize OpenCL device, context, and command queue
 		///////////////////////////////////////////////////////////////////////
 		void initDeviceContextAndQueue();
 		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Create the command queues of the primary device
+		///////////////////////////////////////////////////////////////////////
+		void initQueues();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Create an OpenCL context holding a single device
+		/// 
+		/// \param [in] platformID the device's platform
+		/// \param [in] deviceID the device
+		/// 
+		/// \returns the context
+		///////////////////////////////////////////////////////////////////////
+		cl_context createContext(cl_platform_id platformID, cl_device_id deviceID);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the device type of an OpenCL device
+		/// 
+		/// \param [in] deviceID the device
+		/// 
+		/// \returns the device type
+		///////////////////////////////////////////////////////////////////////
+		cl_device_type getDeviceType(cl_device_id deviceID);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Estimate the throughput of a device before it has been
+		/// measured
+		/// 
+		/// \param [in] deviceID the device
+		/// 
+		/// \returns the relative throughput (compute units times clock
+		/// frequency, or just compute units if the clock is unknown)
+		///////////////////////////////////////////////////////////////////////
+		double estimateDeviceThroughput(cl_device_id deviceID);
+		
 		///////////////////////////////////////////////////////////////////////
 		/// \brief Initialize OpenCL memory buffers required by the solver
 		///////////////////////////////////////////////////////////////////////
 		void initBuffers();
 		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Create the device buffers for one generation in flight
+		/// 
+		/// \param [out] buffers the buffers
+		///////////////////////////////////////////////////////////////////////
+		void createGenerationBuffers(GenerationBuffers& buffers);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Create the device buffers sized by the island model
+		///////////////////////////////////////////////////////////////////////
+		void createIslandBuffers();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Release the device buffers sized by the island model
+		///////////////////////////////////////////////////////////////////////
+		void releaseIslandBuffers();
+		
 		///////////////////////////////////////////////////////////////////////
 		/// \brief Compile OpenCL program and create kernel object
 		///////////////////////////////////////////////////////////////////////
 		void initProgramAndKernels();
 		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Create the kernels from the program (and set their fixed
+		/// arguments)
+		///////////////////////////////////////////////////////////////////////
+		void initKernels();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Build the OpenCL program for a device from the embedded
+		/// kernel source (or from a cached binary of an earlier build)
+		/// 
+		/// \param [in] context the device's context
+		/// \param [in] deviceID the device
+		/// \param [in] options the build options
+		/// 
+		/// \returns the program
+		///////////////////////////////////////////////////////////////////////
+		cl_program buildProgram(cl_context context, cl_device_id deviceID, const std::string& options);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Build a program from a cached binary
+		/// 
+		/// \param [in] context the device's context
+		/// \param [in] deviceID the device
+		/// \param [in] binary the program binary
+		/// \param [in] options the build options
+		/// 
+		/// \returns the program (0 if the binary is rejected)
+		///////////////////////////////////////////////////////////////////////
+		cl_program buildProgramFromBinary(cl_context context, cl_device_id deviceID, const std::vector<unsigned char>& binary, const char* options);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the binary of a built program
+		/// 
+		/// \param [in] program the program (built for a single device)
+		/// \param [out] binary the program binary
+		///////////////////////////////////////////////////////////////////////
+		void getProgramBinary(cl_program program, std::vector<unsigned char>& binary);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get a string property of an OpenCL device
+		/// 
+		/// \param [in] deviceID the device
+		/// \param [in] param the property
+		/// 
+		/// \returns the property value
+		///////////////////////////////////////////////////////////////////////
+		std::string getDeviceInfoString(cl_device_id deviceID, cl_device_info param);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Set the input arguments of a fitness evaluation kernel
+		/// 
+		/// \param [in] kernel the kernel
+		/// \param [in] population the population buffer
+		/// \param [in] puzzlePoints the puzzle point buffer
+		/// \param [in] puzzleEdges the puzzle edge buffer
+		/// \param [in] puzzleSpaces the puzzle space buffer
+		///////////////////////////////////////////////////////////////////////
+		void setEvaluateKernelArgs(cl_kernel kernel, cl_mem population, cl_mem puzzlePoints, cl_mem puzzleEdges, cl_mem puzzleSpaces);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the local memory scratch space needed by one work item
+		/// of the fitness evaluation kernel
+		/// 
+		/// \returns the scratch space (in bytes)
+		///////////////////////////////////////////////////////////////////////
+		size_t getEvaluateScratchSize() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the largest work group size a device supports for the
+		/// fitness evaluation kernel
+		/// 
+		/// \param [in] deviceID the device
+		/// \param [in] kernel the device's evaluation kernel
+		/// 
+		/// \returns the largest work group size allowed by both the kernel
+		/// and the device's local memory
+		/// 
+		/// \throws std::runtime_error if even one work item's scratch space
+		/// doesn't fit in local memory
+		///////////////////////////////////////////////////////////////////////
+		size_t getMaxEvaluateWorkSize(cl_device_id deviceID, cl_kernel kernel);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Size the local memory scratch space arguments of a fitness
+		/// evaluation kernel for a work group size
+		/// 
+		/// \param [in] kernel the kernel
+		/// \param [in] workSize the work group size
+		///////////////////////////////////////////////////////////////////////
+		void setEvaluateWorkSize(cl_kernel kernel, size_t workSize);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the build options of every program (which select the
+		/// population layout)
+		/// 
+		/// \returns the build options
+		///////////////////////////////////////////////////////////////////////
+		std::string getBuildOptions() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the build options that specialize the evaluation
+		/// kernel for this solver's puzzle dimensions
+		/// 
+		/// \returns the build options
+		///////////////////////////////////////////////////////////////////////
+		std::string getSpecializationOptions() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the program a device's evaluation kernel is created
+		/// from, building the specialized variant if it is needed and not
+		/// built yet
+		/// 
+		/// \param [in] context the device's context
+		/// \param [in] deviceID the device
+		/// \param [in] program the device's generic program
+		/// \param [in,out] specializedPrograms the device's specialized
+		/// variants (by puzzle width and height)
+		/// 
+		/// \returns the program
+		///////////////////////////////////////////////////////////////////////
+		cl_program getEvaluateProgram(cl_context context, cl_device_id deviceID, cl_program program, std::map<std::pair<size_t, size_t>, cl_program>& specializedPrograms);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Create a fitness evaluation kernel with its inputs set
+		/// 
+		/// \param [in] program the program to create the kernel from
+		/// \param [in] deviceID the device
+		/// \param [in] population the population buffer
+		/// \param [in] puzzlePoints the puzzle point buffer
+		/// \param [in] puzzleEdges the puzzle edge buffer
+		/// \param [in] puzzleSpaces the puzzle space buffer
+		/// \param [out] workSize the kernel's initial work group size
+		/// 
+		/// \returns the kernel
+		///////////////////////////////////////////////////////////////////////
+		cl_kernel createEvaluateKernel(cl_program program, cl_device_id deviceID, cl_mem population, cl_mem puzzlePoints, cl_mem puzzleEdges, cl_mem puzzleSpaces, size_t& workSize);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief (Re)create the fitness evaluation kernels of every device
+		/// from the generic or specialized programs
+		///////////////////////////////////////////////////////////////////////
+		void createEvaluateKernels();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Choose the fastest evaluation work group size of every
+		/// device for the current puzzle
+		/// 
+		/// Generates the initial population to evaluate, so it must be
+		/// called after the puzzle data is transferred.
+		///////////////////////////////////////////////////////////////////////
+		void tuneWorkSizes();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Choose the fastest evaluation work group size of one device
+		/// by timing the kernel with each candidate size (or by looking up
+		/// an earlier choice for the same device, puzzle dimensions, program
+		/// variant, population layout, kernel and power-of-two population
+		/// size bucket)
+		/// 
+		/// The candidates are the powers of two below the largest size the
+		/// kernel and the device's local memory allow, up to the first one
+		/// that covers the population, plus the largest size itself if none
+		/// does. The population size doesn't need to be a multiple of the
+		/// chosen size.
+		/// 
+		/// \param [in] deviceID the device
+		/// \param [in] queue the device's command queue (with profiling
+		/// enabled)
+		/// \param [in] kernel the device's evaluation kernel (with every
+		/// buffer argument set)
+		/// \param [in] batch true if the kernel is the batch evaluation
+		/// kernel (always from the generic program)
+		/// 
+		/// \returns the chosen work group size (the kernel's scratch space
+		/// is sized for it)
+		///////////////////////////////////////////////////////////////////////
+		size_t tuneEvaluateWorkSize(cl_device_id deviceID, cl_command_queue queue, cl_kernel kernel, bool batch = false);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Queue a fitness evaluation kernel run
+		/// 
+		/// \param [in] queue the device's command queue
+		/// \param [in] kernel the device's evaluation kernel
+		/// \param [in] workSize the work group size
+		/// \param [in] numMembers the number of members to evaluate (need not
+		/// be a multiple of the work group size)
+		/// \param [out] event the kernel's event (NULL if not needed)
+		///////////////////////////////////////////////////////////////////////
+		void runEvaluateKernel(cl_command_queue queue, cl_kernel kernel, size_t workSize, size_t numMembers, cl_event* event);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Create the buffers, program and evaluation kernel of every
+		/// additional device
+		///////////////////////////////////////////////////////////////////////
+		void initShards();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Resize everything that depends on the puzzle size (buffers,
+		/// kernel arguments, evaluation kernels and host memory)
+		/// 
+		/// \param [in] puzzleWidth the new puzzle width
+		/// \param [in] puzzleHeight the new puzzle height
+		///////////////////////////////////////////////////////////////////////
+		void resizePuzzle(size_t puzzleWidth, size_t puzzleHeight);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Swap a buffer for a pooled buffer of a new size
+		/// 
+		/// \param [in,out] pool the pool of the buffer's context
+		/// \param [in,out] buffer the buffer
+		/// \param [in] flags the buffer's access flags
+		/// \param [in] size the new number of bytes
+		///////////////////////////////////////////////////////////////////////
+		void reacquireBuffer(BufferPool& pool, cl_mem& buffer, cl_mem_flags flags, size_t size);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Make sure the host memory sized by the puzzle (the
+		/// displayed path and the staging memory of the other devices) holds
+		/// a puzzle size
+		/// 
+		/// \param [in] numPoints the number of puzzle points
+		///////////////////////////////////////////////////////////////////////
+		void reserveHostMemory(size_t numPoints);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Split the population between the devices in proportion to
+		/// their throughput
+		/// 
+		/// The shares start from each device's estimated throughput and are
+		/// rebalanced every generation from the measured throughput
+		/// (including the transfers through host memory). The other devices'
+		/// shares of a generation are merged back only after the host has
+		/// handled the previous generation's results, so waiting on them
+		/// never delays checking for a solution.
+		///////////////////////////////////////////////////////////////////////
+		void balanceShards();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Evaluate the additional devices' shares of the current
+		/// population and queue writing the results to the primary device
+		/// 
+		/// \param [in,out] buffers the buffers receiving the results
+		/// \param [in] populationEvent the read of the members evaluated by
+		/// the additional devices
+		///////////////////////////////////////////////////////////////////////
+		void runShardEvaluation(GenerationBuffers& buffers, cl_event populationEvent);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Update the throughput of a device from the time it took to
+		/// evaluate its share
+		/// 
+		/// \param [in,out] share the device's share
+		/// \param [in] numMembers the number of members evaluated
+		/// \param [in] firstEvent the first command of the evaluation
+		/// \param [in] lastEvent the last command of the evaluation
+		///////////////////////////////////////////////////////////////////////
+		void recordDeviceThroughput(DeviceShare& share, size_t numMembers, cl_event firstEvent, cl_event lastEvent);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Create a mate selection kernel and set the arguments shared
+		/// by all selection kernels
+		/// 
+		/// \param [in] name the kernel name
+		/// \param [in] firstSharedArg the index of the first shared argument
+		/// (after the method's own inputs)
+		/// 
+		/// \returns the kernel
+		///////////////////////////////////////////////////////////////////////
+		cl_kernel createSelectionKernel(const char* name, cl_uint firstSharedArg);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Set the kernel arguments that depend on the island model
+		///////////////////////////////////////////////////////////////////////
+		void setIslandKernelArgs();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the work group size for a kernel that runs as a single
+		/// work group
+		/// 
+		/// \param [in] kernel the kernel
+		/// 
+		/// \returns the largest supported work group size (up to a fixed
+		/// limit)
+		///////////////////////////////////////////////////////////////////////
+		size_t getSingleGroupWorkSize(cl_kernel kernel);
+		
 		///////////////////////////////////////////////////////////////////////
 		/// \brief Transfer puzzle data to OpenCL constant memory
 		/// 
@@ -137,14 +895,185 @@ namespace gws
 		void transferPuzzleData(const Puzzle& puzzle);
 		
 		///////////////////////////////////////////////////////////////////////
-		/// \brief Run a single iteration of the fitness evaluation kernel
+		/// \brief Queue writing puzzle data to one device's buffers
+		/// 
+		/// \param [in] queue the device's command queue
+		/// \param [in] puzzlePoints the puzzle point buffer
+		/// \param [in] puzzleEdges the puzzle edge buffer
+		/// \param [in] puzzleSpaces the puzzle space buffer
+		/// \param [in] puzzle the puzzle
+		///////////////////////////////////////////////////////////////////////
+		void writePuzzleData(cl_command_queue queue, cl_mem puzzlePoints, cl_mem puzzleEdges, cl_mem puzzleSpaces, const Puzzle& puzzle);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Transfer the concatenated data of a batch of puzzles to
+		/// OpenCL constant memory, and create the other buffers of a batch
+		/// solve
+		/// 
+		/// The solver must already be sized for the largest puzzle.
+		/// 
+		/// \param [in] puzzles the puzzles
+		/// \param [out] results the result of each puzzle (with its max
+		/// fitness filled in)
+		///////////////////////////////////////////////////////////////////////
+		void transferBatchPuzzleData(const std::vector<const Puzzle*>& puzzles, std::vector<BatchResult>& results);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Release the buffers of a batch solve back to the pool
+		///////////////////////////////////////////////////////////////////////
+		void releaseBatchBuffers();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Generate the initial population in device memory
+		///////////////////////////////////////////////////////////////////////
+		void runGenerationKernel();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Queue the fitness evaluation and reduction kernels on the
+		/// population in device memory, followed by an asynchronous read of
+		/// the fitness statistics
+		/// 
+		/// With more than one device, only the primary device's share is
+		/// queued, along with the read of the other shares' members, and the
+		/// rest waits for finishEvaluation().
+		/// 
+		/// \param [in,out] buffers the buffers receiving the results
+		/// \param [in] maxPuzzleFitness the max fitness of the puzzle
+		///////////////////////////////////////////////////////////////////////
+		void enqueueEvaluation(GenerationBuffers& buffers, int maxPuzzleFitness);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Evaluate the other devices' shares of a generation queued
+		/// by enqueueEvaluation() and queue the reduction and statistics read
+		/// (does nothing if no evaluation is pending)
+		/// 
+		/// Waits for the other devices, so it is called once the host has
+		/// handled the previous generation.
+		/// 
+		/// \param [in,out] buffers the buffers receiving the results
+		/// \param [in] maxPuzzleFitness the max fitness of the puzzle
+		///////////////////////////////////////////////////////////////////////
+		void finishEvaluation(GenerationBuffers& buffers, int maxPuzzleFitness);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Queue the reduction of a generation's fitness values,
+		/// followed by an asynchronous read of the fitness statistics
+		/// 
+		/// \param [in,out] buffers the generation's buffers
+		/// \param [in] maxPuzzleFitness the max fitness of the puzzle
+		///////////////////////////////////////////////////////////////////////
+		void enqueueReduction(GenerationBuffers& buffers, int maxPuzzleFitness);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Queue the batch fitness evaluation and reduction kernels on
+		/// the population in device memory, followed by an asynchronous read
+		/// of each puzzle's fitness statistics
+		/// 
+		/// \param [in,out] buffers the buffers receiving the results
+		/// \param [in] numPuzzles the number of puzzles in the batch
+		///////////////////////////////////////////////////////////////////////
+		void enqueueBatchEvaluation(GenerationBuffers& buffers, size_t numPuzzles);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Wait for the pending fitness statistics read of a
+		/// generation (if any)
+		/// 
+		/// \param [in,out] buffers the generation's buffers
+		///////////////////////////////////////////////////////////////////////
+		void waitForStats(GenerationBuffers& buffers);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Queue the kernels generating the next population in device
+		/// memory via selection, crossover and mutation
+		/// 
+		/// \param [in,out] buffers the evaluation results of the current
+		/// population
+		///////////////////////////////////////////////////////////////////////
+		void runReproductionKernels(GenerationBuffers& buffers);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Queue the kernels selecting a crossover mate for every
+		/// member with the configured selection method
+		/// 
+		/// \param [in,out] buffers the evaluation results of the current
+		/// population (receives the events used to time the selection)
+		///////////////////////////////////////////////////////////////////////
+		void runSelectionKernels(GenerationBuffers& buffers);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if this island exchanges members in the current
+		/// generation
+		/// 
+		/// \returns true if members migrate, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool isMigrationGeneration() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Replace the weakest members of this island with the
+		/// fittest members of another island (staged through host memory)
+		/// 
+		/// \param [in] buffers the evaluation results of the current
+		/// population
+		///////////////////////////////////////////////////////////////////////
+		void runMigrationKernels(const GenerationBuffers& buffers);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Add the device time of a finished selection to the total
+		/// (if it hasn't been added yet)
+		/// 
+		/// \param [in,out] buffers the buffers holding the selection events
+		///////////////////////////////////////////////////////////////////////
+		void recordSelectionTime(GenerationBuffers& buffers);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Read the solution path and start point of one member from
+		/// device memory
+		/// 
+		/// \param [in] buffers the buffers holding the member's results
+		/// \param [in] member the population member index
+		/// \param [out] memberPath the output path data of the member
+		/// (unpacked to one move per char)
+		/// \param [out] startPoint the member's selected start point
+		///////////////////////////////////////////////////////////////////////
+		void readMember(const GenerationBuffers& buffers, size_t member, char* memberPath, unsigned int& startPoint);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Read a range of members' population data or paths from
+		/// device memory
+		/// 
+		/// Host memory is laid out like the device buffer (holding the whole
+		/// population), so interleaved members are read with a rectangular
+		/// copy.
+		/// 
+		/// \param [in] queue the device's command queue
+		/// \param [in] buffer the population or paths buffer
+		/// \param [in] blocking whether to wait for the read to finish
+		/// \param [in] bufferMember the first member's index in the buffer
+		/// \param [in] hostMember the first member's index in host memory
+		/// \param [in] numMembers the number of members
+		/// \param [in] memberBytes the number of bytes per member (genome or
+		/// packed path bytes)
+		/// \param [out] data the host memory
+		/// \param [out] event the read's event (NULL if not needed)
+		///////////////////////////////////////////////////////////////////////
+		void readMembers(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t bufferMember, size_t hostMember, size_t numMembers, size_t memberBytes, void* data, cl_event* event);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Write a range of members' population data or paths to
+		/// device memory (see readMembers)
 		/// 
-		/// \param [in] population the population data
-		/// \param [out] fitness the calculated fitness values for each member
-		/// \param [out] startPoints the selected start points
-		/// \param [out] paths the generated solution paths
+		/// \param [in] queue the device's command queue
+		/// \param [in] buffer the population or paths buffer
+		/// \param [in] blocking whether to wait for the write to finish
+		/// \param [in] bufferMember the first member's index in the buffer
+		/// \param [in] hostMember the first member's index in host memory
+		/// \param [in] numMembers the number of members
+		/// \param [in] memberBytes the number of bytes per member (genome or
+		/// packed path bytes)
+		/// \param [in] data the host memory
+		/// \param [out] event the write's event (NULL if not needed)
 		///////////////////////////////////////////////////////////////////////
-		void runEvaluationKernel(const unsigned char* population, int* fitness, unsigned int* startPoints, char* paths);
+		void writeMembers(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t bufferMember, size_t hostMember, size_t numMembers, size_t memberBytes, const void* data, cl_event* event);
 		
 		///////////////////////////////////////////////////////////////////////
 		/// \brief Clean up all OpenCL memory and resources
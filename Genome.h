@@ -0,0 +1,127 @@
+//////////////////////////////
+// Genome.h                 //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_Genome_h
+#define gws_Genome_h
+
+#include "Path.h"
+
+#include <stddef.h>
+
+namespace gws
+{
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Number of 2-bit move genes (or path moves) packed into a byte
+	///////////////////////////////////////////////////////////////////////////
+	const size_t PACKED_MOVES_PER_BYTE = 4;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Number of values a move gene can take (a gene picks one of the
+	/// valid moves from a point, and there are never more than 4)
+	/// 
+	/// A gene picks valid move (gene % number of valid moves) in
+	/// up/down/left/right order, so with 3 valid moves the first one is
+	/// picked by 2 of the 4 values. The bias is kept deliberately: every
+	/// exactly uniform encoding tried (a spare value deferring to a later
+	/// gene, with absolute or relative move order) and the earlier byte genes
+	/// took more generations to solve data/puzzle3.txt.
+	///////////////////////////////////////////////////////////////////////////
+	const unsigned int MOVE_GENE_VALUES = 4;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Number of bytes holding the move count of a packed path
+	///////////////////////////////////////////////////////////////////////////
+	const size_t PATH_HEADER_BYTES = 2;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Get the number of bytes in one population member's genome
+	/// 
+	/// A genome is a start selector byte (the number of start points to count
+	/// from the first point) followed by one move gene per possible move,
+	/// packed PACKED_MOVES_PER_BYTE to a byte starting at the low bits. Gene
+	/// 0 is the start selector and gene i + 1 is move gene i, so crossover
+	/// and mutation treat a genome as maxLength + 1 genes. GeneticSolver.cl
+	/// contains the same functions, and both must use the same layout.
+	/// 
+	/// \param [in] maxLength the max number of moves (the number of points)
+	/// 
+	/// \returns the number of bytes
+	///////////////////////////////////////////////////////////////////////////
+	inline size_t getGenomeBytes(size_t maxLength)
+	{
+		return 1 + (maxLength + PACKED_MOVES_PER_BYTE - 1)/PACKED_MOVES_PER_BYTE;
+	}
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Get one move gene of a genome
+	/// 
+	/// \param [in] genome the genome
+	/// \param [in] move the move index
+	/// 
+	/// \returns the gene (less than MOVE_GENE_VALUES)
+	///////////////////////////////////////////////////////////////////////////
+	inline unsigned char getMoveGene(const unsigned char* genome, size_t move)
+	{
+		return (genome[1 + move/PACKED_MOVES_PER_BYTE] >> (2*(move%PACKED_MOVES_PER_BYTE))) & 3;
+	}
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Set one move gene of a genome
+	/// 
+	/// \param [in,out] genome the genome
+	/// \param [in] move the move index
+	/// \param [in] gene the gene (less than MOVE_GENE_VALUES)
+	///////////////////////////////////////////////////////////////////////////
+	inline void setMoveGene(unsigned char* genome, size_t move, unsigned char gene)
+	{
+		unsigned char& byte = genome[1 + move/PACKED_MOVES_PER_BYTE];
+		unsigned int shift = 2*(move%PACKED_MOVES_PER_BYTE);
+		byte = (unsigned char)((byte & ~(3 << shift)) | ((gene & 3) << shift));
+	}
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Get the number of bytes in one member's packed path
+	/// 
+	/// A packed path is the number of moves (little-endian, in
+	/// PATH_HEADER_BYTES bytes) followed by the moves, packed like move genes
+	/// (up = 0, down = 1, left = 2, right = 3).
+	/// 
+	/// \param [in] maxLength the max number of moves (the number of points)
+	/// 
+	/// \returns the number of bytes
+	///////////////////////////////////////////////////////////////////////////
+	inline size_t getPackedPathBytes(size_t maxLength)
+	{
+		return PATH_HEADER_BYTES + (maxLength + PACKED_MOVES_PER_BYTE - 1)/PACKED_MOVES_PER_BYTE;
+	}
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Unpack a packed path into one move per char
+	/// 
+	/// \param [in] packedPath the packed path
+	/// \param [in] maxLength the max number of moves (the number of points)
+	/// \param [out] path the moves (padded with MoveValue::NONE up to
+	/// maxLength)
+	///////////////////////////////////////////////////////////////////////////
+	inline void unpackPath(const unsigned char* packedPath, size_t maxLength, char* path)
+	{
+		const MoveValue moves[] = { MoveValue::UP, MoveValue::DOWN, MoveValue::LEFT, MoveValue::RIGHT };
+		
+		size_t numMoves = packedPath[0] | ((size_t)packedPath[1] << 8);
+		for (size_t i = 0; i < maxLength; ++i) {
+			if (i < numMoves) {
+				unsigned char bits = packedPath[PATH_HEADER_BYTES + i/PACKED_MOVES_PER_BYTE] >> (2*(i%PACKED_MOVES_PER_BYTE));
+				path[i] = (char)moves[bits & 3];
+			}
+			else {
+				path[i] = (char)MoveValue::NONE;
+			}
+		}
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,744 @@
+//////////////////////////////
+// HostGeneticSolver.cpp    //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "HostGeneticSolver.h"
+
+#include "CompiledPuzzle.h"
+#include "Genome.h"
+#include "Islands.h"
+#include "Path.h"
+#include "Philox.h"
+#include "Puzzle.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string.h>
+#include <thread>
+
+// number of candidates drawn for tournament selection unless configured
+#define DEFAULT_TOURNAMENT_SIZE 4
+
+namespace gws
+{
+	HostGeneticSolver::HostGeneticSolver(size_t populationSize, size_t maxIterations, float crossoverRate, float mutationRate, unsigned int seed, size_t numThreads)
+		: m_populationSize(populationSize),
+		  m_maxIterations(maxIterations),
+		  m_crossoverRate(crossoverRate),
+		  m_mutationRate(mutationRate),
+		  m_seed(seed),
+		  m_numThreads(numThreads),
+		  m_selectionMethod(SelectionMethod::ROULETTE),
+		  m_tournamentSize(DEFAULT_TOURNAMENT_SIZE),
+		  m_numIslands(1),
+		  m_migrationInterval(0),
+		  m_numMigrants(0),
+		  m_migrationTopology(MigrationTopology::RING),
+		  m_islandExchange(NULL),
+		  m_island(0),
+		  m_numIterations(0),
+		  m_generationTime(0.0f),
+		  m_selectionTime(0.0f)
+	{}
+	
+	HostGeneticSolver::~HostGeneticSolver() {}
+	
+	bool HostGeneticSolver::solvePuzzle(const Puzzle& puzzle, Path& path)
+	{
+		// islands evolve as separate populations on their own threads
+		if (m_numIslands > 1) {
+			return solveIslands(puzzle, path);
+		}
+		
+		// find the max fitness value of the puzzle
+		int maxPuzzleFitness = calcMaxFitness(puzzle);
+		std::cout << "Max puzzle fitness is " << maxPuzzleFitness << std::endl;
+		
+		return evolvePopulation(puzzle, maxPuzzleFitness, path);
+	}
+	
+	size_t HostGeneticSolver::getNumIterations() const
+	{
+		return m_numIterations;
+	}
+	
+	void HostGeneticSolver::setSelectionMethod(SelectionMethod method)
+	{
+		m_selectionMethod = method;
+	}
+	
+	void HostGeneticSolver::setTournamentSize(size_t tournamentSize)
+	{
+		m_tournamentSize = tournamentSize > 0 ? tournamentSize : 1;
+	}
+	
+	void HostGeneticSolver::setIslandModel(size_t numIslands, size_t migrationInterval, size_t numMigrants, MigrationTopology topology)
+	{
+		// every island needs at least two members, and migrants can replace
+		// at most half of an island
+		m_numIslands = std::max(std::min(numIslands, m_populationSize/2), (size_t)1);
+		m_migrationInterval = migrationInterval;
+		m_numMigrants = std::min(numMigrants, (m_populationSize/m_numIslands)/2);
+		m_migrationTopology = topology;
+	}
+	
+	float HostGeneticSolver::getGenerationTime() const
+	{
+		return m_generationTime;
+	}
+	
+	float HostGeneticSolver::getSelectionTime() const
+	{
+		return m_selectionTime;
+	}
+	
+	bool HostGeneticSolver::isMigrationGeneration() const
+	{
+		return m_islandExchange != NULL && m_numMigrants > 0 && m_migrationInterval > 0
+		       && m_numIterations > 0 && m_numIterations%m_migrationInterval == 0;
+	}
+	
+	bool HostGeneticSolver::solveIslands(const Puzzle& puzzle, Path& path)
+	{
+		// find the max fitness value of the puzzle
+		int maxPuzzleFitness = calcMaxFitness(puzzle);
+		std::cout << "Max puzzle fitness is " << maxPuzzleFitness << std::endl;
+		
+		// every island is a separate solver with its own population, seed and
+		// share of the worker threads (and its own path for a solution)
+		size_t numPuzzlePoints = puzzle.getNumPoints();
+		size_t numThreads = std::max(getNumThreads()/m_numIslands, (size_t)1);
+		IslandExchange exchange(m_numIslands, m_migrationInterval, m_numMigrants, getGenomeBytes(numPuzzlePoints),
+		                        m_migrationTopology, m_seed);
+		std::vector<HostGeneticSolver> islands;
+		std::vector<std::vector<char>> islandMoves(m_numIslands, std::vector<char>(numPuzzlePoints));
+		std::vector<Path> islandPaths;
+		for (size_t i = 0; i < m_numIslands; ++i) {
+			size_t first;
+			size_t last;
+			getIslandRange(m_populationSize, m_numIslands, i, first, last);
+			islands.push_back(HostGeneticSolver(last - first, m_maxIterations, m_crossoverRate, m_mutationRate,
+			                                    getIslandSeed(m_seed, i), numThreads));
+			islands[i].m_selectionMethod = m_selectionMethod;
+			islands[i].m_tournamentSize = m_tournamentSize;
+			islands[i].m_migrationInterval = m_migrationInterval;
+			islands[i].m_numMigrants = m_numMigrants;
+			islands[i].m_islandExchange = &exchange;
+			islands[i].m_island = i;
+			islandPaths.push_back(Path(islandMoves[i].data(), numPuzzlePoints));
+		}
+		
+		// each island runs its own generation loop (an island that fails stops
+		// the others)
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<std::exception_ptr> errors(m_numIslands);
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < m_numIslands; ++i) {
+			threads.push_back(std::thread([&, i]() {
+				try {
+					islands[i].evolvePopulation(puzzle, maxPuzzleFitness, islandPaths[i]);
+				}
+				catch (...) {
+					errors[i] = std::current_exception();
+					exchange.stop();
+				}
+			}));
+		}
+		for (size_t i = 0; i < threads.size(); ++i) {
+			threads[i].join();
+		}
+		
+		auto stop = std::chrono::high_resolution_clock::now();
+		m_generationTime = std::chrono::duration<float>(stop - start).count()*1000.0f;
+		for (size_t i = 0; i < errors.size(); ++i) {
+			if (errors[i]) {
+				std::rethrow_exception(errors[i]);
+			}
+		}
+		
+		m_numIterations = 0;
+		m_selectionTime = 0.0f;
+		for (size_t i = 0; i < islands.size(); ++i) {
+			m_numIterations = std::max(m_numIterations, islands[i].m_numIterations);
+			m_selectionTime += islands[i].m_selectionTime;
+		}
+		
+		// report the winning island's solution
+		size_t solvedIsland;
+		size_t solvedGeneration;
+		bool solutionFound = exchange.getSolution(solvedIsland, solvedGeneration);
+		if (solutionFound) {
+			m_numIterations = solvedGeneration + 1;
+			const Path& islandPath = islandPaths[solvedIsland];
+			path.clear();
+			path.setStartPointIndex(islandPath.getStartPointIndex());
+			for (size_t i = 0; i < islandPath.getNumMoves(); ++i) {
+				path.addMove(islandPath.getMove(i));
+			}
+		}
+		
+		return solutionFound;
+	}
+	
+	bool HostGeneticSolver::evolvePopulation(const Puzzle& puzzle, int maxPuzzleFitness, Path& path)
+	{
+		size_t numPuzzlePoints = puzzle.getNumPoints();
+		CompiledPuzzle compiled(puzzle);
+		
+		// each worker scores members with its own scratch memory
+		std::vector<EvaluationScratch> scratch(getNumThreads());
+		for (size_t i = 0; i < scratch.size(); ++i) {
+			scratch[i].visitedPoints.resize(numPuzzlePoints);
+			scratch[i].visitedEdges.resize(puzzle.getNumEdges());
+			scratch[i].spacePartitionNumbers.resize(puzzle.getNumSpaces());
+			scratch[i].whitePartitions.resize(puzzle.getNumSpaces());
+			scratch[i].blackPartitions.resize(puzzle.getNumSpaces());
+			scratch[i].searchStack.resize(puzzle.getNumSpaces());
+		}
+		
+		// collect start points for decoding the first gene of each member
+		m_startIndices.clear();
+		for (size_t i = 0; i < numPuzzlePoints; ++i) {
+			if (puzzle.getPointValue(i) == PointValue::START) {
+				m_startIndices.push_back(i);
+			}
+		}
+		
+		// randomly generate initial population (same values as GeneticSolver)
+		auto start = std::chrono::high_resolution_clock::now();
+		m_selectionTime = 0.0f;
+		size_t genomeBytes = getGenomeBytes(numPuzzlePoints);
+		size_t totalPopulationBytes = m_populationSize*genomeBytes;
+		unsigned char* population = new unsigned char[totalPopulationBytes];
+		unsigned char* nextPopulation = new unsigned char[totalPopulationBytes];
+		generatePopulation(population, totalPopulationBytes, genomeBytes, scratch.size());
+		
+		// iterate over each generation until a correct solution is found or max iterations is reached (or
+		// another island found a solution in an earlier generation)
+		bool solutionFound = false;
+		m_numIterations = 0;
+		int* fitness = new int[m_populationSize];
+		unsigned int* mates = new unsigned int[m_populationSize];
+		SelectionTables tables;
+		unsigned int* startPoints = new unsigned int[m_populationSize];
+		char* paths = new char[m_populationSize*numPuzzlePoints];
+		size_t maxMember = 0;
+		while (!solutionFound && m_numIterations < m_maxIterations
+		       && (m_islandExchange == NULL || m_islandExchange->isRunning(m_numIterations))) {
+			evaluatePopulation(puzzle, compiled, population, scratch, fitness, startPoints, paths);
+			
+			// check for correct solution (break early if solution found)
+			size_t currentMember = 0;
+			int currentFitness = 0;
+			int currentMinFitness = INT_MAX;
+			int currentMaxFitness = INT_MIN;
+			while (!solutionFound && currentMember < m_populationSize) {
+				currentFitness = fitness[currentMember];
+				if (currentFitness == maxPuzzleFitness) {
+					fillPath(paths, startPoints, currentMember, numPuzzlePoints, path);
+					solutionFound = true;
+					if (m_islandExchange != NULL) {
+						m_islandExchange->recordSolution(m_island, m_numIterations);
+					}
+				}
+				
+				// collect fitness metrics to assist with crossover phase
+				if (currentFitness < currentMinFitness) {
+					currentMinFitness = currentFitness;
+				}
+				if (currentFitness > currentMaxFitness) {
+					currentMaxFitness = currentFitness;
+					maxMember = currentMember;
+				}
+				
+				++currentMember;
+			}
+			
+			if (m_numIterations % 100 == 0) {
+				// (islands print whole lines, so lines from different islands
+				// don't interleave)
+				std::ostringstream progress;
+				if (m_islandExchange != NULL) {
+					progress << "island " << m_island << " | ";
+				}
+				progress << m_numIterations << " | current max: " << currentMaxFitness << " | start: " << startPoints[maxMember] << " | path: " << std::string(paths + maxMember*numPuzzlePoints, strnlen(paths + maxMember*numPuzzlePoints, numPuzzlePoints)) << std::endl;
+				std::cout << progress.str() << std::flush;
+			}
+			
+			// generate next population via crossover/mutation
+			if (!solutionFound) {
+				// islands exchange their fittest members every migration
+				// interval (migrants are scored already, so their fitness
+				// moves with them)
+				if (isMigrationGeneration()) {
+					migrateMembers(population, fitness, genomeBytes, currentMinFitness);
+				}
+				
+				auto selectionStart = std::chrono::high_resolution_clock::now();
+				selectMates(fitness, currentMinFitness, scratch.size(), tables, mates);
+				auto selectionStop = std::chrono::high_resolution_clock::now();
+				m_selectionTime += std::chrono::duration<float>(selectionStop - selectionStart).count()*1000.0f;
+				
+				reproducePopulation(population, mates, numPuzzlePoints, scratch.size(), nextPopulation);
+				std::swap(population, nextPopulation);
+			}
+			
+			++m_numIterations;
+		}
+		
+		auto stop = std::chrono::high_resolution_clock::now();
+		m_generationTime = std::chrono::duration<float>(stop - start).count()*1000.0f;
+		
+		delete [] population;
+		delete [] nextPopulation;
+		delete [] fitness;
+		delete [] mates;
+		delete [] startPoints;
+		delete [] paths;
+		
+		return solutionFound;
+	}
+	
+	size_t HostGeneticSolver::getNumThreads() const
+	{
+		size_t numThreads = m_numThreads;
+		if (numThreads == 0) {
+			numThreads = std::thread::hardware_concurrency();
+			if (numThreads == 0) {
+				numThreads = 1;
+			}
+		}
+		
+		return numThreads;
+	}
+	
+	int HostGeneticSolver::calcMaxFitness(const Puzzle& puzzle) const
+	{
+		// start with 1 fitness point for reaching the end
+		int maxFitness = 1;
+		
+		// count dot constraints (each dot is 1 fitness point)
+		for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
+			if (puzzle.getPointValue(i) == PointValue::DOT) {
+				++maxFitness;
+			}
+		}
+		for (size_t i = 0; i < puzzle.getNumEdges(); ++i) {
+			if (puzzle.getEdgeValue(i) == EdgeValue::DOT) {
+				++maxFitness;
+			}
+		}
+		
+		// count space constraints (each white/black space is 1 fitness point)
+		for (size_t i = 0; i < puzzle.getNumSpaces(); ++i) {
+			if (puzzle.getSpaceValue(i) == SpaceValue::WHITE || puzzle.getSpaceValue(i) == SpaceValue::BLACK) {
+				++maxFitness;
+			}
+		}
+		
+		return maxFitness;
+	}
+	
+	void HostGeneticSolver::fillPath(const char* paths, const unsigned int* startPoints, size_t member, size_t maxLength, Path& path) const
+	{
+		// clear out path
+		path.clear();
+		
+		// set start point
+		path.setStartPointIndex(startPoints[member]);
+		
+		// extract path data
+		size_t startIndex = member*maxLength;
+		size_t i = 0;
+		bool morePath = true;
+		while (i < maxLength && morePath) {
+			MoveValue value = (MoveValue)paths[startIndex + i];
+			if (value != MoveValue::NONE) {
+				path.addMove(value);
+			}
+			else {
+				morePath = false;
+			}
+			
+			++i;
+		}
+	}
+	
+	void HostGeneticSolver::evaluatePopulation(const Puzzle& puzzle, const CompiledPuzzle& compiled, const unsigned char* population,
+	                                           std::vector<EvaluationScratch>& scratch, int* fitness, unsigned int* startPoints, char* paths) const
+	{
+		size_t numPuzzlePoints = puzzle.getNumPoints();
+		size_t genomeBytes = getGenomeBytes(numPuzzlePoints);
+		
+		// every worker scores its own range of members, so the results don't
+		// depend on the number of threads
+		runWorkers(m_populationSize, scratch.size(), [&](size_t worker, size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i) {
+				fitness[i] = evaluateMember(puzzle, compiled, population + i*genomeBytes, scratch[worker],
+				                            startPoints[i], paths + i*numPuzzlePoints);
+			}
+		});
+	}
+	
+	void HostGeneticSolver::generatePopulation(unsigned char* population, size_t totalBytes, size_t genomeBytes, size_t numThreads) const
+	{
+		// each block of random bytes only depends on the seed and its index
+		// (move gene bytes are used as is)
+		size_t numBlocks = (totalBytes + PHILOX_BLOCK_BYTES - 1)/PHILOX_BLOCK_BYTES;
+		runWorkers(numBlocks, numThreads, [&](size_t, size_t first, size_t last) {
+			unsigned char bytes[PHILOX_BLOCK_BYTES];
+			for (size_t block = first; block < last; ++block) {
+				generateRandomBlock(m_seed, RandomStream::POPULATION, 0, (uint32_t)block, bytes);
+				for (size_t i = 0; i < PHILOX_BLOCK_BYTES && block*PHILOX_BLOCK_BYTES + i < totalBytes; ++i) {
+					size_t byte = block*PHILOX_BLOCK_BYTES + i;
+					population[byte] = byte%genomeBytes == 0 ? (unsigned char)(bytes[i] % UCHAR_MAX) : bytes[i];
+				}
+			}
+		});
+	}
+	
+	void HostGeneticSolver::selectMates(const int* fitness, int minFitness, size_t numThreads,
+	                                    SelectionTables& tables, unsigned int* mates) const
+	{
+		uint32_t generation = (uint32_t)m_numIterations;
+		uint64_t crossoverThreshold = getRandomThreshold(m_crossoverRate);
+		
+		// build the lookup structure of the selection method (if it has one)
+		if (m_selectionMethod == SelectionMethod::ALIAS) {
+			tables.aliasProbabilities.resize(m_populationSize);
+			tables.aliases.resize(m_populationSize);
+			tables.aliasWorklist.resize(m_populationSize);
+			tables.aliasTotal = 0;
+			for (size_t i = 0; i < m_populationSize; ++i) {
+				tables.aliasTotal += fitness[i] - minFitness + 1;
+			}
+			
+			buildAliasTable(fitness, m_populationSize, minFitness, tables.aliasTotal, tables.aliasProbabilities.data(),
+			                tables.aliases.data(), tables.aliasWorklist.data());
+		}
+		else if (m_selectionMethod == SelectionMethod::ROULETTE) {
+			tables.fitnessPrefix.resize(m_populationSize);
+			uint32_t prefix = 0;
+			for (size_t i = 0; i < m_populationSize; ++i) {
+				prefix += fitness[i] - minFitness + 1;
+				tables.fitnessPrefix[i] = prefix;
+			}
+		}
+		
+		// each member's mate only depends on the lookup structure and its own
+		// random draws (same as the selection kernels with one island)
+		runWorkers(m_populationSize, numThreads, [&](size_t, size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i) {
+				uint32_t crossoverDraws[4];
+				generateRandomWords(m_seed, RandomStream::CROSSOVER, generation, (uint32_t)i, 0, crossoverDraws);
+				size_t mate = i;
+				if (crossoverDraws[0] < crossoverThreshold) {
+					switch (m_selectionMethod) {
+						case SelectionMethod::ALIAS:
+							mate = selectAliasMember(tables.aliasProbabilities.data(), tables.aliases.data(), m_populationSize,
+							                         tables.aliasTotal, crossoverDraws[1], crossoverDraws[3]);
+							break;
+						case SelectionMethod::TOURNAMENT:
+							mate = selectTournamentMember(fitness, m_populationSize, m_tournamentSize, m_seed, generation, (uint32_t)i);
+							break;
+						default:
+							mate = selectRouletteMember(tables.fitnessPrefix.data(), 0, m_populationSize, crossoverDraws[1]);
+							break;
+					}
+				}
+				
+				mates[i] = (unsigned int)mate;
+			}
+		});
+	}
+	
+	void HostGeneticSolver::migrateMembers(unsigned char* population, int* fitness, size_t genomeBytes, int& minFitness) const
+	{
+		// the island's fittest members are traded for the fittest members of
+		// another island, which replace its weakest members (in rank order)
+		std::vector<uint32_t> emigrants(m_numMigrants);
+		std::vector<uint32_t> replaced(m_numMigrants);
+		findFittestMembers(fitness, 0, m_populationSize, m_numMigrants, emigrants.data());
+		findWeakestMembers(fitness, 0, m_populationSize, m_numMigrants, replaced.data());
+		
+		std::vector<unsigned char> migrantGenes(m_numMigrants*genomeBytes);
+		std::vector<int> migrantFitness(m_numMigrants);
+		for (size_t i = 0; i < m_numMigrants; ++i) {
+			std::copy(population + emigrants[i]*genomeBytes, population + (emigrants[i] + 1)*genomeBytes, migrantGenes.begin() + i*genomeBytes);
+			migrantFitness[i] = fitness[emigrants[i]];
+		}
+		
+		if (m_islandExchange->migrate(m_island, m_numIterations, migrantGenes.data(), migrantFitness.data())) {
+			for (size_t i = 0; i < m_numMigrants; ++i) {
+				std::copy(migrantGenes.begin() + i*genomeBytes, migrantGenes.begin() + (i + 1)*genomeBytes,
+				          population + replaced[i]*genomeBytes);
+				fitness[replaced[i]] = migrantFitness[i];
+				minFitness = std::min(minFitness, migrantFitness[i]);
+			}
+		}
+	}
+	
+	void HostGeneticSolver::reproducePopulation(const unsigned char* population, const unsigned int* mates, size_t maxLength,
+	                                            size_t numThreads, unsigned char* nextPopulation) const
+	{
+		uint32_t generation = (uint32_t)m_numIterations;
+		uint64_t mutationThreshold = getRandomThreshold(m_mutationRate);
+		size_t genomeBytes = getGenomeBytes(maxLength);
+		
+		// each member of the next population only depends on the current
+		// population and its own random draws (same as the
+		// reproducePopulation kernel)
+		runWorkers(m_populationSize, numThreads, [&](size_t, size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i) {
+				// take the mate's genes up to the crossover point (members
+				// that don't cross over are their own mate)
+				uint32_t crossoverDraws[4];
+				generateRandomWords(m_seed, RandomStream::CROSSOVER, generation, (uint32_t)i, 0, crossoverDraws);
+				size_t mate = mates[i];
+				size_t crossoverPoint = crossoverDraws[2]%(maxLength + 1);
+				
+				// gene 0 is the start selector and gene j is move gene j - 1
+				// (the unused bits of the last move byte are cleared)
+				const unsigned char* genes = population + i*genomeBytes;
+				const unsigned char* mateGenes = population + mate*genomeBytes;
+				unsigned char* nextGenes = nextPopulation + i*genomeBytes;
+				std::fill(nextGenes, nextGenes + genomeBytes, 0);
+				
+				// "mate" is more likely to have a high fitness, so use it as the starting parent
+				uint32_t mutationDraws[4];
+				for (size_t j = 0; j <= maxLength; ++j) {
+					const unsigned char* parent = j > crossoverPoint ? genes : mateGenes;
+					unsigned char gene = j == 0 ? parent[0] : getMoveGene(parent, j - 1);
+					
+					// each block of mutation draws covers two genes
+					if (j%2 == 0) {
+						generateRandomWords(m_seed, RandomStream::MUTATION, generation, (uint32_t)i, (uint32_t)(j/2), mutationDraws);
+					}
+					if (mutationDraws[2*(j%2)] < mutationThreshold) {
+						uint32_t value = mutationDraws[2*(j%2) + 1];
+						gene = (unsigned char)(j == 0 ? value % UCHAR_MAX : value % MOVE_GENE_VALUES);
+					}
+					
+					if (j == 0) {
+						nextGenes[0] = gene;
+					}
+					else {
+						setMoveGene(nextGenes, j - 1, gene);
+					}
+				}
+			}
+		});
+	}
+	
+	void HostGeneticSolver::runWorkers(size_t numItems, size_t numThreads, const WorkerFunction& worker) const
+	{
+		// split items into contiguous ranges (the calling thread acts as the
+		// first worker)
+		size_t itemsPerThread = (numItems + numThreads - 1)/numThreads;
+		auto runWorker = [&](size_t index) {
+			size_t first = index*itemsPerThread < numItems ? index*itemsPerThread : numItems;
+			size_t last = first + itemsPerThread < numItems ? first + itemsPerThread : numItems;
+			worker(index, first, last);
+		};
+		
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < numThreads; ++i) {
+			threads.push_back(std::thread(runWorker, i));
+		}
+		runWorker(0);
+		for (size_t i = 0; i < threads.size(); ++i) {
+			threads[i].join();
+		}
+	}
+	
+	int HostGeneticSolver::evaluateMember(const Puzzle& puzzle, const CompiledPuzzle& compiled, const unsigned char* genes,
+	                                      EvaluationScratch& scratch, unsigned int& startPoint, char* path) const
+	{
+		int fitnessValue = 0;
+		size_t maxLength = puzzle.getNumPoints();
+		
+		// mark all points and edges as unvisited (they can only be visited once)
+		for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
+			scratch.visitedPoints[i] = false;
+		}
+		for (size_t i = 0; i < puzzle.getNumEdges(); ++i) {
+			scratch.visitedEdges[i] = false;
+		}
+		
+		// initialize path to empty
+		for (size_t i = 0; i < maxLength; ++i) {
+			path[i] = (char)MoveValue::NONE;
+		}
+		
+		// find start point of path
+		size_t currentIndex = findStartIndex(genes[0]);
+		startPoint = (unsigned int)currentIndex;
+		
+		// follow path (each gene picks one of the valid moves from the
+		// current point, in up/down/left/right order)
+		bool canContinue = true;
+		size_t move = 0;
+		while (canContinue && move < maxLength) {
+			// mark point as visited
+			scratch.visitedPoints[currentIndex] = true;
+			
+			// check dot constraint
+			if (puzzle.getPointValue(currentIndex) == PointValue::DOT) {
+				// dots earn 1 fitness point
+				++fitnessValue;
+			}
+			
+			// only continue if we haven't reached the end of the puzzle
+			if (puzzle.getPointValue(currentIndex) != PointValue::END) {
+				// get next move (check which moves are valid)
+				const CompiledPuzzle::Neighbor* possibleMoves[4];
+				size_t choices = 0;
+				const CompiledPuzzle::Neighbor* neighbors = compiled.getNeighbors(currentIndex);
+				for (size_t i = 0; i < compiled.getNumNeighbors(currentIndex); ++i) {
+					if (!scratch.visitedPoints[neighbors[i].pointIndex]) {
+						possibleMoves[choices] = &neighbors[i];
+						++choices;
+					}
+				}
+				
+				if (choices > 0) {
+					// (with 3 choices the first is picked by 2 of the 4 gene
+					// values, see MOVE_GENE_VALUES in Genome.h)
+					const CompiledPuzzle::Neighbor* next = possibleMoves[getMoveGene(genes, move) % choices];
+					path[move] = (char)next->move;
+					
+					// mark edge as visited and check dot constraint
+					scratch.visitedEdges[next->edgeIndex] = true;
+					if (puzzle.getEdgeValue(next->edgeIndex) == EdgeValue::DOT) {
+						// dots earn 1 fitness point
+						++fitnessValue;
+					}
+					
+					currentIndex = next->pointIndex;
+				}
+				else {
+					canContinue = false;
+				}
+			}
+			else {
+				// reaching the end earns 1 fitness point
+				++fitnessValue;
+				canContinue = false;
+			}
+			
+			++move;
+		}
+		
+		// partition spaces into regions separated by the path (a space is
+		// assigned to a partition when it is pushed, so it's pushed once)
+		for (size_t i = 0; i < puzzle.getNumSpaces(); ++i) {
+			scratch.spacePartitionNumbers[i] = -1;
+		}
+		
+		int currentPartition = 0;
+		size_t stackSize = 0;
+		size_t partitionedSpaces = 0;
+		size_t spaceIndex = 0;
+		while (partitionedSpaces < puzzle.getNumSpaces()) {
+			// find starting point for search
+			while (scratch.spacePartitionNumbers[spaceIndex] >= 0) {
+				++spaceIndex;
+			}
+			
+			scratch.whitePartitions[currentPartition] = false;
+			scratch.blackPartitions[currentPartition] = false;
+			scratch.spacePartitionNumbers[spaceIndex] = currentPartition;
+			scratch.searchStack[stackSize] = spaceIndex;
+			++stackSize;
+			
+			while (stackSize > 0) {
+				// pop space from stack
+				size_t currentSpace = scratch.searchStack[stackSize - 1];
+				--stackSize;
+				
+				++partitionedSpaces;
+				switch (puzzle.getSpaceValue(currentSpace)) {
+					case SpaceValue::WHITE:
+						scratch.whitePartitions[currentPartition] = true;
+						break;
+					case SpaceValue::BLACK:
+						scratch.blackPartitions[currentPartition] = true;
+						break;
+					default:
+						break;
+				}
+				
+				// space row/col coordinates correspond to the same coordinates of the upper-left point on the space
+				size_t spaceRow = puzzle.getSpaceRow(currentSpace);
+				size_t spaceCol = puzzle.getSpaceCol(currentSpace);
+				size_t neighbors[4];
+				size_t numNeighbors = 0;
+				if (spaceRow > 0 && !scratch.visitedEdges[puzzle.getEdgeIndex(spaceRow, spaceCol, spaceRow, spaceCol + 1)]) {
+					neighbors[numNeighbors++] = puzzle.getSpaceIndex(spaceRow - 1, spaceCol);
+				}
+				if (spaceRow < puzzle.getHeight() - 2 && !scratch.visitedEdges[puzzle.getEdgeIndex(spaceRow + 1, spaceCol, spaceRow + 1, spaceCol + 1)]) {
+					neighbors[numNeighbors++] = puzzle.getSpaceIndex(spaceRow + 1, spaceCol);
+				}
+				if (spaceCol > 0 && !scratch.visitedEdges[puzzle.getEdgeIndex(spaceRow, spaceCol, spaceRow + 1, spaceCol)]) {
+					neighbors[numNeighbors++] = puzzle.getSpaceIndex(spaceRow, spaceCol - 1);
+				}
+				if (spaceCol < puzzle.getWidth() - 2 && !scratch.visitedEdges[puzzle.getEdgeIndex(spaceRow, spaceCol + 1, spaceRow + 1, spaceCol + 1)]) {
+					neighbors[numNeighbors++] = puzzle.getSpaceIndex(spaceRow, spaceCol + 1);
+				}
+				
+				for (size_t i = 0; i < numNeighbors; ++i) {
+					if (scratch.spacePartitionNumbers[neighbors[i]] == -1) {
+						scratch.spacePartitionNumbers[neighbors[i]] = currentPartition;
+						scratch.searchStack[stackSize] = neighbors[i];
+						++stackSize;
+					}
+				}
+			}
+			
+			++currentPartition;
+		}
+		
+		// each white/black space in a valid partition earns 1 fitness point
+		for (size_t i = 0; i < puzzle.getNumSpaces(); ++i) {
+			int partition = scratch.spacePartitionNumbers[i];
+			switch (puzzle.getSpaceValue(i)) {
+				case SpaceValue::WHITE:
+					if (scratch.whitePartitions[partition] && !scratch.blackPartitions[partition]) {
+						++fitnessValue;
+					}
+					break;
+				case SpaceValue::BLACK:
+					if (scratch.blackPartitions[partition] && !scratch.whitePartitions[partition]) {
+						++fitnessValue;
+					}
+					break;
+				default:
+					break;
+			}
+		}
+		
+		return fitnessValue;
+	}
+	
+	size_t HostGeneticSolver::findStartIndex(unsigned char initialValue) const
+	{
+		// the kernel counts start points from the first point (wrapping
+		// around) until it has passed as many as the first gene, which is
+		// the same as indexing the list of start points (a gene of 0 selects
+		// point 0)
+		size_t index = 0;
+		if (initialValue > 0 && !m_startIndices.empty()) {
+			index = m_startIndices[(initialValue - 1)%m_startIndices.size()];
+		}
+		
+		return index;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,347 @@
+//////////////////////////////
+// HostGeneticSolver.h      //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_HostGeneticSolver_h
+#define gws_HostGeneticSolver_h
+
+#include "Islands.h"
+#include "Selection.h"
+#include "Solver.h"
+
+#include <functional>
+#include <stddef.h>
+#include <vector>
+
+namespace gws
+{
+	class CompiledPuzzle;
+	class Path;
+	class Puzzle;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \class HostGeneticSolver
+	/// \brief Puzzle solver that executes the genetic algorithm on the host
+	/// CPU
+	/// 
+	/// The population is generated, scored and evolved exactly like the
+	/// kernels used by GeneticSolver (with the same counter-based random
+	/// values), so both solvers produce the same fitness values and results
+	/// for the same seed. Every stage is split across worker threads, each
+	/// handling a contiguous range of the population (with its own scratch
+	/// memory for evaluation). With an island model, every island is a
+	/// separate solver running its own generation loop on its own thread.
+	/// No OpenCL platform or device is needed.
+	///////////////////////////////////////////////////////////////////////////
+	class HostGeneticSolver : public Solver
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Initialize the solver
+		/// 
+		/// \param [in] populationSize the number of members per generation
+		/// \param [in] maxIterations the maximum number of generations
+		/// \param [in] crossoverRate the chance of each member crossing over
+		/// \param [in] mutationRate the chance of each gene mutating
+		/// \param [in] seed the random seed
+		/// \param [in] numThreads the number of worker threads (0 to use
+		/// the number of hardware threads)
+		///////////////////////////////////////////////////////////////////////
+		HostGeneticSolver(
+			size_t populationSize,
+			size_t maxIterations,
+			float crossoverRate,
+			float mutationRate,
+			unsigned int seed,
+			size_t numThreads = 0);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Virtual destructor
+		///////////////////////////////////////////////////////////////////////
+		virtual ~HostGeneticSolver();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \copydoc Solver::solvePuzzle()
+		///////////////////////////////////////////////////////////////////////
+		virtual bool solvePuzzle(const Puzzle& puzzle, Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of iterations used to solve the puzzle
+		/// 
+		/// \returns the number of iterations
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumIterations() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Set the method used to select crossover mates (roulette by
+		/// default)
+		/// 
+		/// \param [in] method the selection method
+		///////////////////////////////////////////////////////////////////////
+		void setSelectionMethod(SelectionMethod method);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Set the number of candidates drawn for tournament selection
+		/// 
+		/// \param [in] tournamentSize the number of candidates (at least 1)
+		///////////////////////////////////////////////////////////////////////
+		void setTournamentSize(size_t tournamentSize);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Split the population into islands that evolve separately
+		/// and periodically exchange their fittest members (one island by
+		/// default)
+		/// 
+		/// Each island gets an equal share of the population and worker
+		/// threads, and runs its own generation loop on its own thread with
+		/// its own seed (see getIslandSeed()). Migrants are traded through an
+		/// IslandExchange, and the solve ends with the solution found in the
+		/// earliest generation, so results don't depend on thread timing.
+		/// 
+		/// \param [in] numIslands the number of islands
+		/// \param [in] migrationInterval the number of generations between
+		/// migrations (0 for no migration)
+		/// \param [in] numMigrants the number of members each island sends
+		/// per migration (limited to half of an island)
+		/// \param [in] topology the migration topology
+		///////////////////////////////////////////////////////////////////////
+		void setIslandModel(size_t numIslands, size_t migrationInterval, size_t numMigrants, MigrationTopology topology);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the time spent running generations in the last solve
+		/// 
+		/// \returns the total generation time (in ms)
+		///////////////////////////////////////////////////////////////////////
+		float getGenerationTime() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the time spent selecting crossover mates in the last
+		/// solve (including building the prefix sums or alias table)
+		/// 
+		/// \returns the total selection time (in ms)
+		///////////////////////////////////////////////////////////////////////
+		float getSelectionTime() const;
+		
+	private:
+		///////////////////////////////////////////////////////////////////////
+		/// \struct EvaluationScratch
+		/// \brief Scratch memory for scoring one member at a time
+		///////////////////////////////////////////////////////////////////////
+		struct EvaluationScratch
+		{
+			std::vector<bool> visitedPoints;
+			std::vector<bool> visitedEdges;
+			std::vector<int> spacePartitionNumbers;
+			std::vector<bool> whitePartitions;
+			std::vector<bool> blackPartitions;
+			std::vector<size_t> searchStack;
+		};
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \struct SelectionTables
+		/// \brief Lookup structures of the fitness-proportional selection
+		/// methods (only those of the configured method are filled)
+		///////////////////////////////////////////////////////////////////////
+		struct SelectionTables
+		{
+			std::vector<uint32_t> fitnessPrefix;
+			std::vector<uint64_t> aliasProbabilities;
+			std::vector<uint32_t> aliases;
+			std::vector<uint32_t> aliasWorklist;
+			uint32_t aliasTotal;
+		};
+		
+		// worker function for a contiguous range [first, last) of items
+		typedef std::function<void(size_t worker, size_t first, size_t last)> WorkerFunction;
+		
+		size_t m_populationSize;
+		size_t m_maxIterations;
+		float m_crossoverRate;
+		float m_mutationRate;
+		unsigned int m_seed;
+		size_t m_numThreads;
+		SelectionMethod m_selectionMethod;
+		size_t m_tournamentSize;
+		size_t m_numIslands;
+		size_t m_migrationInterval;
+		size_t m_numMigrants;
+		MigrationTopology m_migrationTopology;
+		
+		// exchange shared with the other islands, and this solver's island
+		// index (only set for the islands of a solve)
+		IslandExchange* m_islandExchange;
+		size_t m_island;
+		
+		size_t m_numIterations;
+		float m_generationTime;
+		float m_selectionTime;
+		
+		// start points of the puzzle being solved (in point index order)
+		std::vector<size_t> m_startIndices;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Solve a puzzle with a separate solver per island, each
+		/// running on its own thread
+		/// 
+		/// \param [in] puzzle the puzzle to solve
+		/// \param [out] path the solution found by the winning island
+		/// 
+		/// \returns true if any island found a solution, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool solveIslands(const Puzzle& puzzle, Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Generate the population and run generations until a
+		/// solution is found (or the islands stop)
+		/// 
+		/// \param [in] puzzle the puzzle to solve
+		/// \param [in] maxPuzzleFitness the max fitness of the puzzle
+		/// \param [out] path the solution path
+		/// 
+		/// \returns true if a solution was found, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool evolvePopulation(const Puzzle& puzzle, int maxPuzzleFitness, Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of worker threads to run
+		/// 
+		/// \returns the configured number of threads, or the number of
+		/// hardware threads if none was configured
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumThreads() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the maximum possible fitness score for a puzzle
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// 
+		/// \returns the max fitness of the puzzle
+		///////////////////////////////////////////////////////////////////////
+		int calcMaxFitness(const Puzzle& puzzle) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Fill a path with the solution decoded from a given member
+		/// of the population
+		/// 
+		/// \param [in] paths the decoded path data for the population
+		/// \param [in] startPoints the selected start points
+		/// \param [in] member the population member index
+		/// \param [in] maxLength the max length of each member's path
+		/// \param [out] path the output path
+		///////////////////////////////////////////////////////////////////////
+		void fillPath(const char* paths, const unsigned int* startPoints, size_t member, size_t maxLength, Path& path) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Decode and score every member of the population on all
+		/// worker threads
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in] compiled the move tables of the puzzle
+		/// \param [in] population the population data
+		/// \param [in,out] scratch the scratch memory of each worker
+		/// \param [out] fitness the calculated fitness values for each member
+		/// \param [out] startPoints the selected start points
+		/// \param [out] paths the decoded solution paths
+		///////////////////////////////////////////////////////////////////////
+		void evaluatePopulation(const Puzzle& puzzle, const CompiledPuzzle& compiled, const unsigned char* population,
+		                        std::vector<EvaluationScratch>& scratch, int* fitness, unsigned int* startPoints, char* paths) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Generate a random initial population on all worker threads
+		/// 
+		/// \param [out] population the population data
+		/// \param [in] totalBytes the number of bytes in the population
+		/// \param [in] genomeBytes the number of bytes in each member's genome
+		/// \param [in] numThreads the number of worker threads
+		///////////////////////////////////////////////////////////////////////
+		void generatePopulation(unsigned char* population, size_t totalBytes, size_t genomeBytes, size_t numThreads) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Select a crossover mate for every member with the
+		/// configured selection method (same as the selection kernels)
+		/// 
+		/// \param [in] fitness the fitness values
+		/// \param [in] minFitness the minimum fitness value
+		/// \param [in] numThreads the number of worker threads
+		/// \param [in,out] tables the selection lookup structures
+		/// \param [out] mates the mate of each member (a member that doesn't
+		/// cross over is its own mate)
+		///////////////////////////////////////////////////////////////////////
+		void selectMates(const int* fitness, int minFitness, size_t numThreads,
+		                 SelectionTables& tables, unsigned int* mates) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if this island exchanges members in the current
+		/// generation
+		/// 
+		/// \returns true if members migrate, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool isMigrationGeneration() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Replace the weakest members of this island with the fittest
+		/// members of another island (same as the migration kernels)
+		/// 
+		/// \param [in,out] population the population data
+		/// \param [in,out] fitness the fitness values
+		/// \param [in] genomeBytes the number of bytes in each member's genome
+		/// \param [in,out] minFitness the minimum fitness value (lowered if an
+		/// immigrant is less fit)
+		///////////////////////////////////////////////////////////////////////
+		void migrateMembers(unsigned char* population, int* fitness, size_t genomeBytes, int& minFitness) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Generate the next population via crossover and mutation on
+		/// all worker threads
+		/// 
+		/// \param [in] population the current population data
+		/// \param [in] mates the mate of each member
+		/// \param [in] maxLength the max number of moves of each member
+		/// \param [in] numThreads the number of worker threads
+		/// \param [out] nextPopulation the next population data
+		///////////////////////////////////////////////////////////////////////
+		void reproducePopulation(const unsigned char* population, const unsigned int* mates, size_t maxLength,
+		                         size_t numThreads, unsigned char* nextPopulation) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Split a number of items into contiguous ranges and process
+		/// each range on its own thread
+		/// 
+		/// \param [in] numItems the number of items
+		/// \param [in] numThreads the number of worker threads (the calling
+		/// thread is the first worker)
+		/// \param [in] worker the function processing each range
+		///////////////////////////////////////////////////////////////////////
+		void runWorkers(size_t numItems, size_t numThreads, const WorkerFunction& worker) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Decode and score one member of the population
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in] compiled the move tables of the puzzle
+		/// \param [in] genes the member's genome (see Genome.h)
+		/// \param [in,out] scratch the scratch memory of the calling worker
+		/// \param [out] startPoint the selected start point
+		/// \param [out] path the decoded solution path (terminated by
+		/// MoveValue::NONE if shorter than the puzzle's number of points)
+		/// 
+		/// \returns the fitness of the member
+		///////////////////////////////////////////////////////////////////////
+		int evaluateMember(const Puzzle& puzzle, const CompiledPuzzle& compiled, const unsigned char* genes,
+		                   EvaluationScratch& scratch, unsigned int& startPoint, char* path) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Select the start point encoded by a member's first gene
+		/// 
+		/// \param [in] initialValue the first gene of the member
+		/// 
+		/// \returns the start point index
+		///////////////////////////////////////////////////////////////////////
+		size_t findStartIndex(unsigned char initialValue) const;
+	};
+}
+
+#endif
\ No newline at end of file
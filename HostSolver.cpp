@@ -7,91 +7,800 @@
 
 #include "HostSolver.h"
 
+#include "Bitboard.h"
+#include "BitboardPuzzle.h"
+#include "CompiledPuzzle.h"
+#include "EvaluationWorkspace.h"
 #include "Path.h"
 #include "Puzzle.h"
+#include "TranspositionTable.h"
 
+#include <atomic>
 #include <iostream>
 
+// widest bitboard (in 64-bit words) used before falling back to the
+// regular search (16 words holds puzzles of up to 32x32 points)
+#define MAX_BITBOARD_WORDS 16
+
+// reachability checks per adaptation window, the prune rate (1 in N checks)
+// a window needs for the checks to run more often, and the largest number
+// of nodes between checks
+#define REACHABILITY_WINDOW 256
+#define REACHABILITY_MIN_PRUNE_RATE 16
+#define MAX_REACHABILITY_INTERVAL 64
+
 namespace gws
 {
-	HostSolver::~HostSolver() {}
+	HostSolver::HostSolver(bool enablePruning, bool useBitboards)
+		: m_enablePruning(enablePruning), m_useBitboards(useBitboards), m_numNodes(0), m_stopFlag(nullptr), m_table(nullptr), m_useTable(false),
+		  m_callback(nullptr), m_enumerating(false), m_numSolutions(0),
+		  m_enableReachability(false), m_reachabilityInterval(1), m_reachabilityCountdown(1), m_windowChecks(0), m_windowPrunes(0),
+		  m_numReachabilityPrunes(0)
+	{}
+	
+	HostSolver::~HostSolver()
+	{
+		delete m_table;
+	}
 	
 	bool HostSolver::solvePuzzle(const Puzzle& puzzle, Path& path)
 	{
+		resetTranspositionTable(puzzle);
+		
+		if (m_useBitboards && canUseBitboards(puzzle)) {
+			return solveWithBitboards(puzzle, path, false);
+		}
+		
 		bool solutionFound = false;
+		m_numNodes = 0;
+		m_numReachabilityPrunes = 0;
 		
-		// keep track of which points have been visited
-		bool* visitFlags = new bool[puzzle.getNumPoints()];
+		SearchState state;
+		initSearchState(puzzle, state);
 		
 		// search puzzle for starting points and start exhaustive search from
 		// each one until a solution is found or there are no more starting points
-		size_t row = 0;
-		while (!solutionFound && row < puzzle.getHeight()) {
-			size_t col = 0;
-			while (!solutionFound && col < puzzle.getWidth()) {
-				if (puzzle.getPointValue(row, col) == PointValue::START) {
-					// reset path and visit flags for new search
-					path.clear();
-					path.setStartPointIndex(puzzle.getPointIndex(row, col));
-					for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
-						visitFlags[i] = false;
+		size_t index = 0;
+		while (!solutionFound && !isStopped() && index < puzzle.getNumPoints()) {
+			if (puzzle.getPointValue(index) == PointValue::START) {
+				// reset path and search state for new search
+				path.clear();
+				path.setStartPointIndex(index);
+				resetSearchState(puzzle, state);
+				
+				solutionFound = searchPuzzle(puzzle, path, index, state);
+			}
+			
+			++index;
+		}
+		
+		freeSearchState(state);
+		
+		return solutionFound;
+	}
+	
+	bool HostSolver::solvePrefix(const Puzzle& puzzle, Path& path)
+	{
+		// the table is only reset automatically if it has no keys yet
+		if (m_table != nullptr && !m_table->canHold(puzzle)) {
+			resetTranspositionTable(puzzle);
+		}
+		
+		if (m_useBitboards && canUseBitboards(puzzle)) {
+			return solveWithBitboards(puzzle, path, true);
+		}
+		
+		bool solutionFound = false;
+		m_numNodes = 0;
+		m_numReachabilityPrunes = 0;
+		
+		SearchState state;
+		initSearchState(puzzle, state);
+		resetSearchState(puzzle, state);
+		
+		// replay the prefix and continue the search from its last point
+		size_t headIndex = path.getStartPointIndex();
+		if (headIndex < puzzle.getNumPoints() && puzzle.getPointValue(headIndex) == PointValue::START && replayPath(puzzle, path, headIndex, state)) {
+			solutionFound = searchPuzzle(puzzle, path, headIndex, state);
+		}
+		
+		freeSearchState(state);
+		
+		return solutionFound;
+	}
+	
+	void HostSolver::setStopFlag(const std::atomic<bool>* stopFlag)
+	{
+		m_stopFlag = stopFlag;
+	}
+	
+	uint64_t HostSolver::enumerateSolutions(const Puzzle& puzzle, Path& path, const SolutionCallback& callback)
+	{
+		m_callback = &callback;
+		m_enumerating = true;
+		m_numSolutions = 0;
+		
+		solvePuzzle(puzzle, path);
+		
+		m_callback = nullptr;
+		m_enumerating = false;
+		
+		return m_numSolutions;
+	}
+	
+	uint64_t HostSolver::enumeratePrefix(const Puzzle& puzzle, Path& path, const SolutionCallback& callback)
+	{
+		m_callback = &callback;
+		m_enumerating = true;
+		m_numSolutions = 0;
+		
+		solvePrefix(puzzle, path);
+		
+		m_callback = nullptr;
+		m_enumerating = false;
+		
+		return m_numSolutions;
+	}
+	
+	void HostSolver::setTranspositionTable(size_t maxBytes, ReplacementPolicy policy)
+	{
+		delete m_table;
+		m_table = maxBytes > 0 ? new TranspositionTable(maxBytes, policy) : nullptr;
+		m_useTable = false;
+	}
+	
+	void HostSolver::resetTranspositionTable(const Puzzle& puzzle)
+	{
+		// skip hashing entirely if the table can never be hit
+		if (m_table != nullptr) {
+			m_table->reset(puzzle);
+		}
+		m_useTable = m_table != nullptr && m_table->hasTranspositions();
+	}
+	
+	void HostSolver::setReachabilityPruning(bool enable)
+	{
+		m_enableReachability = enable;
+		m_reachabilityInterval = 1;
+		m_reachabilityCountdown = 1;
+		m_windowChecks = 0;
+		m_windowPrunes = 0;
+	}
+	
+	size_t HostSolver::getNumReachabilityPrunes() const
+	{
+		return m_numReachabilityPrunes;
+	}
+	
+	size_t HostSolver::getNumNodes() const
+	{
+		return m_numNodes;
+	}
+	
+	size_t HostSolver::getNumTableHits() const
+	{
+		return m_table != nullptr ? m_table->getNumHits() : 0;
+	}
+	
+	bool HostSolver::isStopped() const
+	{
+		return m_stopFlag != nullptr && m_stopFlag->load(std::memory_order_relaxed);
+	}
+	
+	bool HostSolver::isReachabilityNode()
+	{
+		bool checkDue = false;
+		if (m_enablePruning && m_enableReachability) {
+			--m_reachabilityCountdown;
+			if (m_reachabilityCountdown == 0) {
+				m_reachabilityCountdown = m_reachabilityInterval;
+				checkDue = true;
+			}
+		}
+		
+		return checkDue;
+	}
+	
+	bool HostSolver::recordReachabilityCheck(bool canReach)
+	{
+		++m_windowChecks;
+		if (!canReach) {
+			++m_windowPrunes;
+			++m_numReachabilityPrunes;
+		}
+		
+		// check half as often if the last window rarely pruned, and twice as
+		// often if it did (the interval is kept between solves, so prefix
+		// tasks of the same puzzle keep the tuned interval)
+		if (m_windowChecks == REACHABILITY_WINDOW) {
+			if (m_windowPrunes*REACHABILITY_MIN_PRUNE_RATE < m_windowChecks) {
+				if (m_reachabilityInterval < MAX_REACHABILITY_INTERVAL) {
+					m_reachabilityInterval *= 2;
+				}
+			}
+			else if (m_reachabilityInterval > 1) {
+				m_reachabilityInterval /= 2;
+			}
+			
+			m_windowChecks = 0;
+			m_windowPrunes = 0;
+		}
+		
+		return canReach;
+	}
+	
+	bool HostSolver::isTableState(const Puzzle& puzzle, const Path& path) const
+	{
+		// deep states have small subtrees that are cheaper to search again
+		// than to look up, so only the first half of the path is recorded
+		// (and nothing is recorded while enumerating, since a state that was
+		// searched for all of its solutions isn't dead)
+		return m_useTable && !m_enumerating && path.getNumMoves()*2 < puzzle.getNumPoints();
+	}
+	
+	bool HostSolver::isDeadState(uint64_t hash, size_t headIndex) const
+	{
+		return m_table->contains(hash ^ m_table->getHeadKey(headIndex));
+	}
+	
+	void HostSolver::storeDeadState(uint64_t hash, size_t headIndex, size_t startNodes)
+	{
+		// a search that was interrupted hasn't proven anything
+		if (!isStopped()) {
+			m_table->store(hash ^ m_table->getHeadKey(headIndex), m_numNodes - startNodes);
+		}
+	}
+	
+	bool HostSolver::acceptSolution(const Path& path)
+	{
+		bool stopSearch = true;
+		if (m_enumerating) {
+			++m_numSolutions;
+			stopSearch = *m_callback && !(*m_callback)(path);
+		}
+		
+		return stopSearch;
+	}
+	
+	void HostSolver::initSearchState(const Puzzle& puzzle, SearchState& state) const
+	{
+		// keep track of which points and edges have been visited
+		state.visitedPoints = new bool[puzzle.getNumPoints()];
+		state.visitedEdges = new bool[puzzle.getNumEdges()];
+		
+		// scratch space for region checks
+		state.spacePartitionNumbers = new int[puzzle.getNumSpaces()];
+		state.searchStack = new int[puzzle.getNumSpaces()];
+		state.whitePartitions = new bool[puzzle.getNumSpaces()];
+		state.blackPartitions = new bool[puzzle.getNumSpaces()];
+		state.splittablePartitions = new bool[puzzle.getNumSpaces()];
+		
+		// scratch space for reachability checks
+		state.reachedPoints = new bool[puzzle.getNumPoints()];
+		state.pointStack = new int[puzzle.getNumPoints()];
+		
+		// move tables and scratch space for evaluating complete paths
+		state.compiled = new CompiledPuzzle(puzzle);
+		state.workspace = new EvaluationWorkspace(puzzle);
+		
+		// count dots that every solution must pass through
+		state.totalDots = 0;
+		for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
+			if (puzzle.getPointValue(i) == PointValue::DOT) {
+				++state.totalDots;
+			}
+		}
+		for (size_t i = 0; i < puzzle.getNumEdges(); ++i) {
+			if (puzzle.getEdgeValue(i) == EdgeValue::DOT) {
+				++state.totalDots;
+			}
+		}
+		
+		// regions can only be invalid if both mark colors are present
+		bool hasWhite = false;
+		bool hasBlack = false;
+		for (size_t i = 0; i < puzzle.getNumSpaces(); ++i) {
+			hasWhite = hasWhite || puzzle.getSpaceValue(i) == SpaceValue::WHITE;
+			hasBlack = hasBlack || puzzle.getSpaceValue(i) == SpaceValue::BLACK;
+		}
+		state.checkRegions = m_enablePruning && hasWhite && hasBlack;
+	}
+	
+	void HostSolver::resetSearchState(const Puzzle& puzzle, SearchState& state) const
+	{
+		for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
+			state.visitedPoints[i] = false;
+		}
+		for (size_t i = 0; i < puzzle.getNumEdges(); ++i) {
+			state.visitedEdges[i] = false;
+		}
+		state.remainingDots = state.totalDots;
+		state.hash = 0;
+	}
+	
+	void HostSolver::freeSearchState(SearchState& state) const
+	{
+		delete [] state.visitedPoints;
+		delete [] state.visitedEdges;
+		delete [] state.spacePartitionNumbers;
+		delete [] state.searchStack;
+		delete [] state.whitePartitions;
+		delete [] state.blackPartitions;
+		delete [] state.splittablePartitions;
+		delete [] state.reachedPoints;
+		delete [] state.pointStack;
+		delete state.compiled;
+		delete state.workspace;
+	}
+	
+	bool HostSolver::replayPath(const Puzzle& puzzle, const Path& path, size_t& headIndex, SearchState& state) const
+	{
+		bool validPath = true;
+		size_t move = 0;
+		while (validPath && move < path.getNumMoves()) {
+			// mark current point as visited
+			size_t currentIndex = headIndex;
+			state.visitedPoints[currentIndex] = true;
+			if (puzzle.getPointValue(currentIndex) == PointValue::DOT) {
+				--state.remainingDots;
+			}
+			if (m_useTable) {
+				state.hash ^= m_table->getPointKey(currentIndex);
+			}
+			
+			// prefix moves must be valid and cannot pass through an end point
+			size_t nextIndex = state.compiled->getNeighborIndex(currentIndex, path.getMove(move));
+			validPath = puzzle.getPointValue(currentIndex) != PointValue::END
+			         && nextIndex < puzzle.getNumPoints() && !state.visitedPoints[nextIndex];
+			if (validPath) {
+				// traverse edge
+				size_t edgeIndex = state.compiled->getEdgeIndex(currentIndex, path.getMove(move));
+				state.visitedEdges[edgeIndex] = true;
+				if (puzzle.getEdgeValue(edgeIndex) == EdgeValue::DOT) {
+					--state.remainingDots;
+				}
+				if (m_useTable) {
+					state.hash ^= m_table->getEdgeKey(edgeIndex);
+				}
+				
+				validPath = !m_enablePruning || canCompletePath(puzzle, state, currentIndex, nextIndex);
+				headIndex = nextIndex;
+			}
+			
+			++move;
+		}
+		
+		return validPath;
+	}
+	
+	bool HostSolver::searchPuzzle(const Puzzle& puzzle, Path& path, size_t currentIndex, SearchState& state)
+	{
+		bool solutionFound = false;
+		bool tableState = isTableState(puzzle, path);
+		size_t startNodes = m_numNodes;
+		++m_numNodes;
+		
+		// mark current point as visited
+		state.visitedPoints[currentIndex] = true;
+		if (puzzle.getPointValue(currentIndex) == PointValue::DOT) {
+			--state.remainingDots;
+		}
+		if (m_useTable) {
+			state.hash ^= m_table->getPointKey(currentIndex);
+		}
+		
+		// if current point is the end, evalulate solution
+		// (skipping paths that are known to have missed a dot)
+		if (puzzle.getPointValue(currentIndex) == PointValue::END) {
+			if (!m_enablePruning || state.remainingDots == 0) {
+				solutionFound = puzzle.evaluateSolution(path, *state.compiled, *state.workspace) && acceptSolution(path);
+			}
+		}
+		else if ((!tableState || !isDeadState(state.hash, currentIndex))
+		           && (!isReachabilityNode() || recordReachabilityCheck(canReachGoal(puzzle, state, currentIndex)))) {
+			// search all possible moves for solution (up, down, left, right)
+			// valid move is one to an unvisited neighbor (the compiled
+			// neighbor lists already exclude blocked edges and points)
+			const CompiledPuzzle::Neighbor* neighbors = state.compiled->getNeighbors(currentIndex);
+			size_t numNeighbors = state.compiled->getNumNeighbors(currentIndex);
+			for (size_t i = 0; !solutionFound && !isStopped() && i < numNeighbors; ++i) {
+				size_t nextIndex = neighbors[i].pointIndex;
+				size_t edgeIndex = neighbors[i].edgeIndex;
+				if (!state.visitedPoints[nextIndex]) {
+					// traverse edge
+					state.visitedEdges[edgeIndex] = true;
+					if (puzzle.getEdgeValue(edgeIndex) == EdgeValue::DOT) {
+						--state.remainingDots;
+					}
+					if (m_useTable) {
+						state.hash ^= m_table->getEdgeKey(edgeIndex);
+					}
+					
+					path.addMove(neighbors[i].move);
+					if (!m_enablePruning || canCompletePath(puzzle, state, currentIndex, nextIndex)) {
+						solutionFound = searchPuzzle(puzzle, path, nextIndex, state);
+					}
+					else {
+						path.popMove();
 					}
 					
-					solutionFound = searchPuzzle(puzzle, path, row, col, visitFlags);
+					// restore edge if we are backtracking
+					if (!solutionFound) {
+						state.visitedEdges[edgeIndex] = false;
+						if (puzzle.getEdgeValue(edgeIndex) == EdgeValue::DOT) {
+							++state.remainingDots;
+						}
+						if (m_useTable) {
+							state.hash ^= m_table->getEdgeKey(edgeIndex);
+						}
+					}
+				}
+			}
+			
+			if (!solutionFound && tableState) {
+				storeDeadState(state.hash, currentIndex, startNodes);
+			}
+		}
+		
+		// remove current point from path and visit flags if we are backtracking
+		if (!solutionFound) {
+			path.popMove();
+			state.visitedPoints[currentIndex] = false;
+			if (puzzle.getPointValue(currentIndex) == PointValue::DOT) {
+				++state.remainingDots;
+			}
+			if (m_useTable) {
+				state.hash ^= m_table->getPointKey(currentIndex);
+			}
+		}
+		
+		return solutionFound;
+	}
+	
+	bool HostSolver::canCompletePath(const Puzzle& puzzle, SearchState& state, size_t prevIndex, size_t headIndex) const
+	{
+		// the previous point can never be visited again, so any dot edge
+		// touching it that wasn't traversed is lost, and any dot next to it
+		// may have lost its last way in or out
+		const CompiledPuzzle::Neighbor* neighbors = state.compiled->getNeighbors(prevIndex);
+		for (size_t i = 0; i < state.compiled->getNumNeighbors(prevIndex); ++i) {
+			if (puzzle.getEdgeValue(neighbors[i].edgeIndex) == EdgeValue::DOT && !state.visitedEdges[neighbors[i].edgeIndex]) {
+				return false;
+			}
+			if (puzzle.getPointValue(neighbors[i].pointIndex) == PointValue::DOT && !state.visitedPoints[neighbors[i].pointIndex]
+			      && !isPointReachable(state, neighbors[i].pointIndex, headIndex)) {
+				return false;
+			}
+		}
+		
+		return !state.checkRegions || !hasMixedSealedRegion(puzzle, state, headIndex);
+	}
+	
+	bool HostSolver::hasMixedSealedRegion(const Puzzle& puzzle, SearchState& state, size_t headIndex) const
+	{
+		for (size_t i = 0; i < puzzle.getNumSpaces(); ++i) {
+			state.spacePartitionNumbers[i] = -1;
+			state.whitePartitions[i] = false;
+			state.blackPartitions[i] = false;
+			state.splittablePartitions[i] = false;
+		}
+		
+		// run depth-first search until all spaces are assigned to a partition
+		// (same partitioning as Puzzle::evaluateSolution())
+		int currentPartition = 0;
+		size_t stackSize = 0;
+		size_t partitionedSpaces = 0;
+		size_t spaceIndex = 0;
+		while (partitionedSpaces < puzzle.getNumSpaces()) {
+			// find starting point for search
+			while (state.spacePartitionNumbers[spaceIndex] >= 0) {
+				++spaceIndex;
+			}
+			
+			state.spacePartitionNumbers[spaceIndex] = currentPartition;
+			state.searchStack[stackSize] = spaceIndex;
+			++stackSize;
+			
+			while (stackSize > 0) {
+				// pop space from stack
+				size_t currentSpace = state.searchStack[stackSize - 1];
+				--stackSize;
+				
+				++partitionedSpaces;
+				switch (puzzle.getSpaceValue(currentSpace)) {
+					case SpaceValue::WHITE:
+						state.whitePartitions[currentPartition] = true;
+						break;
+					case SpaceValue::BLACK:
+						state.blackPartitions[currentPartition] = true;
+						break;
+					default:
+						break;
 				}
 				
-				++col;
+				// space row/col coordinates correspond to the same coordinates of the upper-left point on the space
+				size_t spaceRow = puzzle.getSpaceRow(currentSpace);
+				size_t spaceCol = puzzle.getSpaceCol(currentSpace);
+				
+				// the shared edge of two neighboring spaces in a partition can split the partition
+				// later if the path can still traverse it
+				if (spaceRow > 0 && !state.visitedEdges[puzzle.getEdgeIndex(spaceRow, spaceCol, spaceRow, spaceCol + 1)]) {
+					state.splittablePartitions[currentPartition] = state.splittablePartitions[currentPartition]
+						|| isEdgeTraversable(puzzle, state, spaceRow, spaceCol, spaceRow, spaceCol + 1, headIndex);
+					size_t neighbor = puzzle.getSpaceIndex(spaceRow - 1, spaceCol);
+					if (state.spacePartitionNumbers[neighbor] == -1) {
+						state.spacePartitionNumbers[neighbor] = currentPartition;
+						state.searchStack[stackSize] = neighbor;
+						++stackSize;
+					}
+				}
+				if (spaceRow < puzzle.getHeight() - 2 && !state.visitedEdges[puzzle.getEdgeIndex(spaceRow + 1, spaceCol, spaceRow + 1, spaceCol + 1)]) {
+					state.splittablePartitions[currentPartition] = state.splittablePartitions[currentPartition]
+						|| isEdgeTraversable(puzzle, state, spaceRow + 1, spaceCol, spaceRow + 1, spaceCol + 1, headIndex);
+					size_t neighbor = puzzle.getSpaceIndex(spaceRow + 1, spaceCol);
+					if (state.spacePartitionNumbers[neighbor] == -1) {
+						state.spacePartitionNumbers[neighbor] = currentPartition;
+						state.searchStack[stackSize] = neighbor;
+						++stackSize;
+					}
+				}
+				if (spaceCol > 0 && !state.visitedEdges[puzzle.getEdgeIndex(spaceRow, spaceCol, spaceRow + 1, spaceCol)]) {
+					state.splittablePartitions[currentPartition] = state.splittablePartitions[currentPartition]
+						|| isEdgeTraversable(puzzle, state, spaceRow, spaceCol, spaceRow + 1, spaceCol, headIndex);
+					size_t neighbor = puzzle.getSpaceIndex(spaceRow, spaceCol - 1);
+					if (state.spacePartitionNumbers[neighbor] == -1) {
+						state.spacePartitionNumbers[neighbor] = currentPartition;
+						state.searchStack[stackSize] = neighbor;
+						++stackSize;
+					}
+				}
+				if (spaceCol < puzzle.getWidth() - 2 && !state.visitedEdges[puzzle.getEdgeIndex(spaceRow, spaceCol + 1, spaceRow + 1, spaceCol + 1)]) {
+					state.splittablePartitions[currentPartition] = state.splittablePartitions[currentPartition]
+						|| isEdgeTraversable(puzzle, state, spaceRow, spaceCol + 1, spaceRow + 1, spaceCol + 1, headIndex);
+					size_t neighbor = puzzle.getSpaceIndex(spaceRow, spaceCol + 1);
+					if (state.spacePartitionNumbers[neighbor] == -1) {
+						state.spacePartitionNumbers[neighbor] = currentPartition;
+						state.searchStack[stackSize] = neighbor;
+						++stackSize;
+					}
+				}
+			}
+			
+			// a partition that can't be split any further is final
+			if (!state.splittablePartitions[currentPartition]
+			      && state.whitePartitions[currentPartition] && state.blackPartitions[currentPartition]) {
+				return true;
 			}
 			
-			++row;
+			++currentPartition;
+		}
+		
+		return false;
+	}
+	
+	bool HostSolver::canReachGoal(const Puzzle& puzzle, SearchState& state, size_t headIndex) const
+	{
+		for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
+			state.reachedPoints[i] = false;
+		}
+		
+		// flood fill the unvisited points from the head of the path
+		bool endReached = false;
+		size_t stackSize = 0;
+		state.reachedPoints[headIndex] = true;
+		state.pointStack[stackSize] = headIndex;
+		++stackSize;
+		while (stackSize > 0) {
+			size_t currentIndex = state.pointStack[stackSize - 1];
+			--stackSize;
+			
+			endReached = endReached || puzzle.getPointValue(currentIndex) == PointValue::END;
+			
+			const CompiledPuzzle::Neighbor* neighbors = state.compiled->getNeighbors(currentIndex);
+			for (size_t i = 0; i < state.compiled->getNumNeighbors(currentIndex); ++i) {
+				size_t nextIndex = neighbors[i].pointIndex;
+				if (!state.visitedPoints[nextIndex] && !state.reachedPoints[nextIndex]) {
+					state.reachedPoints[nextIndex] = true;
+					state.pointStack[stackSize] = nextIndex;
+					++stackSize;
+				}
+			}
 		}
 		
-		delete [] visitFlags;
+		if (!endReached) {
+			return false;
+		}
+		
+		// an open point the head can't reach must not hold a dot or touch a
+		// dot edge that hasn't been traversed (dot edges between visited
+		// points are already handled by canCompletePath())
+		for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
+			if (!state.visitedPoints[i] && !state.reachedPoints[i]) {
+				if (puzzle.getPointValue(i) == PointValue::DOT) {
+					return false;
+				}
+				
+				const CompiledPuzzle::Neighbor* neighbors = state.compiled->getNeighbors(i);
+				for (size_t j = 0; j < state.compiled->getNumNeighbors(i); ++j) {
+					if (puzzle.getEdgeValue(neighbors[j].edgeIndex) == EdgeValue::DOT && !state.visitedEdges[neighbors[j].edgeIndex]) {
+						return false;
+					}
+				}
+			}
+		}
+		
+		return true;
+	}
+	
+	bool HostSolver::isEdgeTraversable(const Puzzle& puzzle, const SearchState& state, size_t row1, size_t col1, size_t row2, size_t col2, size_t headIndex) const
+	{
+		size_t index1 = puzzle.getPointIndex(row1, col1);
+		size_t index2 = puzzle.getPointIndex(row2, col2);
+		
+		// both points must still be open (or be the head of the path)
+		return puzzle.getEdgeValue(row1, col1, row2, col2) != EdgeValue::BLOCKED
+		    && puzzle.getPointValue(index1) != PointValue::BLOCKED
+		    && puzzle.getPointValue(index2) != PointValue::BLOCKED
+		    && (!state.visitedPoints[index1] || index1 == headIndex)
+		    && (!state.visitedPoints[index2] || index2 == headIndex);
+	}
+	
+	bool HostSolver::isPointReachable(const SearchState& state, size_t index, size_t headIndex) const
+	{
+		// the head of the path has already been entered
+		if (index == headIndex) {
+			return true;
+		}
+		
+		// the path must enter and leave the point, so it needs
+		// at least two neighbors that are open or the head of the path
+		size_t openNeighbors = 0;
+		const CompiledPuzzle::Neighbor* neighbors = state.compiled->getNeighbors(index);
+		for (size_t i = 0; i < state.compiled->getNumNeighbors(index); ++i) {
+			if (!state.visitedPoints[neighbors[i].pointIndex] || neighbors[i].pointIndex == headIndex) {
+				++openNeighbors;
+			}
+		}
+		
+		return openNeighbors >= 2;
+	}
+	
+	bool HostSolver::canUseBitboards(const Puzzle& puzzle) const
+	{
+		return BitboardPuzzle<MAX_BITBOARD_WORDS>::canHold(puzzle);
+	}
+	
+	bool HostSolver::solveWithBitboards(const Puzzle& puzzle, Path& path, bool continuePrefix)
+	{
+		bool solutionFound;
+		if (BitboardPuzzle<1>::canHold(puzzle)) {
+			solutionFound = solveBitboard<1>(puzzle, path, continuePrefix);
+		}
+		else if (BitboardPuzzle<2>::canHold(puzzle)) {
+			solutionFound = solveBitboard<2>(puzzle, path, continuePrefix);
+		}
+		else if (BitboardPuzzle<4>::canHold(puzzle)) {
+			solutionFound = solveBitboard<4>(puzzle, path, continuePrefix);
+		}
+		else if (BitboardPuzzle<8>::canHold(puzzle)) {
+			solutionFound = solveBitboard<8>(puzzle, path, continuePrefix);
+		}
+		else {
+			solutionFound = solveBitboard<MAX_BITBOARD_WORDS>(puzzle, path, continuePrefix);
+		}
 		
 		return solutionFound;
 	}
 	
-	bool HostSolver::searchPuzzle(const Puzzle& puzzle, Path& path, size_t row, size_t col, bool* visitFlags)
+	template <size_t NumWords>
+	bool HostSolver::solveBitboard(const Puzzle& puzzle, Path& path, bool continuePrefix)
 	{
 		bool solutionFound = false;
+		m_numNodes = 0;
+		m_numReachabilityPrunes = 0;
 		
-		// mark current point as visited
-		size_t currentIndex = puzzle.getPointIndex(row, col);
-		visitFlags[currentIndex] = true;
+		BitboardPuzzle<NumWords> board(puzzle);
+		EvaluationWorkspace workspace(puzzle);
+		typename BitboardPuzzle<NumWords>::PointSet visitedPoints;
+		typename BitboardPuzzle<NumWords>::EdgeSet visitedEdges;
+		uint64_t hash = 0;
 		
-		// if current point is the end, evalulate solution
-		if (puzzle.getPointValue(row, col) == PointValue::END) {
-			solutionFound = puzzle.evaluateSolution(path);
+		if (continuePrefix) {
+			// replay the prefix and continue the search from its last point
+			size_t headIndex = path.getStartPointIndex();
+			bool validPath = headIndex < puzzle.getNumPoints() && board.getStartPoints().test(headIndex);
+			size_t move = 0;
+			while (validPath && move < path.getNumMoves()) {
+				visitedPoints.set(headIndex);
+				if (m_useTable) {
+					hash ^= m_table->getPointKey(headIndex);
+				}
+				
+				// prefix moves must be valid and cannot pass through an end point
+				size_t nextIndex = board.getNeighborIndex(headIndex, path.getMove(move));
+				validPath = !board.getEndPoints().test(headIndex) && nextIndex < puzzle.getNumPoints() && !visitedPoints.test(nextIndex);
+				if (validPath) {
+					size_t edgeIndex = board.getEdgeIndex(headIndex, path.getMove(move));
+					visitedEdges.set(edgeIndex);
+					if (m_useTable) {
+						hash ^= m_table->getEdgeKey(edgeIndex);
+					}
+					validPath = !m_enablePruning || board.canCompletePath(visitedPoints, visitedEdges, headIndex, nextIndex);
+					headIndex = nextIndex;
+				}
+				
+				++move;
+			}
+			
+			if (validPath) {
+				solutionFound = searchBitboard(puzzle, board, workspace, path, headIndex, visitedPoints, visitedEdges, hash);
+			}
 		}
 		else {
-			// search all possible moves for solution (up, down, left, right)
-			// valid move is one where destination edge/point are not blocked and point hasn't been visited already
-			if (!solutionFound && row > 0 && puzzle.getEdgeValue(row - 1, col, row, col) != EdgeValue::BLOCKED
-				  && puzzle.getPointValue(row - 1, col) != PointValue::BLOCKED && !visitFlags[puzzle.getPointIndex(row - 1, col)]) {
-				path.addMove(MoveValue::UP);
-				solutionFound = searchPuzzle(puzzle, path, row - 1, col, visitFlags);
+			// start an exhaustive search from each start point
+			typename BitboardPuzzle<NumWords>::PointSet startPoints = board.getStartPoints();
+			size_t startIndex;
+			while (!solutionFound && !isStopped() && startPoints.popFirst(startIndex)) {
+				path.clear();
+				path.setStartPointIndex(startIndex);
+				
+				solutionFound = searchBitboard(puzzle, board, workspace, path, startIndex, visitedPoints, visitedEdges, hash);
 			}
-			if (!solutionFound && row < puzzle.getHeight() - 1 && puzzle.getEdgeValue(row, col, row + 1, col) != EdgeValue::BLOCKED
-				  && puzzle.getPointValue(row + 1, col) != PointValue::BLOCKED && !visitFlags[puzzle.getPointIndex(row + 1, col)]) {
-				path.addMove(MoveValue::DOWN);
-				solutionFound = searchPuzzle(puzzle, path, row + 1, col, visitFlags);
+		}
+		
+		return solutionFound;
+	}
+	
+	template <size_t NumWords>
+	bool HostSolver::searchBitboard(const Puzzle& puzzle, const BitboardPuzzle<NumWords>& board, EvaluationWorkspace& workspace, Path& path,
+	                                size_t headIndex, Bitboard<NumWords> visitedPoints, const Bitboard<NumWords*2>& visitedEdges, uint64_t hash)
+	{
+		bool solutionFound = false;
+		bool tableState = isTableState(puzzle, path);
+		size_t startNodes = m_numNodes;
+		++m_numNodes;
+		
+		visitedPoints.set(headIndex);
+		if (m_useTable) {
+			hash ^= m_table->getPointKey(headIndex);
+		}
+		
+		// if current point is the end, evalulate solution
+		// (skipping paths that are known to have missed a dot)
+		if (board.getEndPoints().test(headIndex)) {
+			if (!m_enablePruning || (board.getDotPoints().andNot(visitedPoints).none() && board.getDotEdges().andNot(visitedEdges).none())) {
+				solutionFound = puzzle.evaluateSolution(path, board.getCompiledPuzzle(), workspace) && acceptSolution(path);
 			}
-			if (!solutionFound && col > 0 && puzzle.getEdgeValue(row, col - 1, row, col) != EdgeValue::BLOCKED
-				  && puzzle.getPointValue(row, col - 1) != PointValue::BLOCKED && !visitFlags[puzzle.getPointIndex(row, col - 1)]) {
-				path.addMove(MoveValue::LEFT);
-				solutionFound = searchPuzzle(puzzle, path, row, col - 1, visitFlags);
+		}
+		else if ((!tableState || !isDeadState(hash, headIndex))
+		           && (!isReachabilityNode() || recordReachabilityCheck(board.canReachGoal(visitedPoints, visitedEdges, headIndex)))) {
+			// all valid moves are the unvisited neighbors of the current point
+			Bitboard<NumWords> moves = board.getNeighbors(headIndex).andNot(visitedPoints);
+			size_t nextIndex;
+			while (!solutionFound && !isStopped() && moves.popFirst(nextIndex)) {
+				MoveValue move = board.getMove(headIndex, nextIndex);
+				size_t edgeIndex = board.getEdgeIndex(headIndex, move);
+				Bitboard<NumWords*2> nextEdges = visitedEdges;
+				nextEdges.set(edgeIndex);
+				uint64_t nextHash = m_useTable ? hash ^ m_table->getEdgeKey(edgeIndex) : 0;
+				
+				path.addMove(move);
+				if (!m_enablePruning || board.canCompletePath(visitedPoints, nextEdges, headIndex, nextIndex)) {
+					solutionFound = searchBitboard(puzzle, board, workspace, path, nextIndex, visitedPoints, nextEdges, nextHash);
+				}
+				else {
+					path.popMove();
+				}
 			}
-			if (!solutionFound && col < puzzle.getWidth() - 1 && puzzle.getEdgeValue(row, col, row, col + 1) != EdgeValue::BLOCKED
-				  && puzzle.getPointValue(row, col + 1) != PointValue::BLOCKED && !visitFlags[puzzle.getPointIndex(row, col + 1)]) {
-				path.addMove(MoveValue::RIGHT);
-				solutionFound = searchPuzzle(puzzle, path, row, col + 1, visitFlags);
+			
+			if (!solutionFound && tableState) {
+				storeDeadState(hash, headIndex, startNodes);
 			}
 		}
 		
-		// remove current point from path and visit flags if we are backtracking
+		// remove current point from path if we are backtracking
 		if (!solutionFound) {
 			path.popMove();
-			visitFlags[currentIndex] = false;
 		}
 		
 		return solutionFound;
@@ -9,33 +9,420 @@
 #define gws_HostSolver_h
 
 #include "Solver.h"
+#include "TranspositionTable.h"
 
+#include <atomic>
+#include <functional>
 #include <stddef.h>
+#include <stdint.h>
 
 namespace gws
 {
+	class CompiledPuzzle;
+	class EvaluationWorkspace;
 	class Path;
 	class Puzzle;
+	enum class MoveValue : char;
+	
+	template <size_t NumWords> class Bitboard;
+	template <size_t NumWords> class BitboardPuzzle;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Function called with each solution found by an enumeration
+	/// (returns false to stop the enumeration)
+	///////////////////////////////////////////////////////////////////////////
+	typedef std::function<bool(const Path&)> SolutionCallback;
 	
 	///////////////////////////////////////////////////////////////////////////
 	/// \class HostSolver
 	/// \brief Puzzle solver that works entirely on the host CPU
+	/// 
+	/// The solver runs an exhaustive depth-first search from every start
+	/// point. While searching, it keeps track of the constraints that can no
+	/// longer be satisfied by the partial path (stranded dots and sealed
+	/// regions containing both white and black marks) and backtracks as soon
+	/// as the partial path cannot be completed.
+	/// 
+	/// In bitboard mode, the puzzle is compiled into a BitboardPuzzle and the
+	/// visited points/edges are kept as bitboards, so move generation and dot
+	/// checks are a few mask operations. Region constraints are only checked
+	/// when a path reaches an end point in this mode. Puzzles that are too
+	/// large for the widest bitboard fall back to the regular search.
+	/// 
+	/// An optional transposition table remembers search states that have
+	/// been proven to have no solution. A state is the head of the path plus
+	/// the visited points and constraint-relevant edges, so a different
+	/// prefix that covers the same points and edges and ends at the same
+	/// point is skipped instead of searched again. The table is not used for
+	/// puzzles with both white and black marks, because every edge affects
+	/// their regions and an edge set can only be reached by one path.
+	/// 
+	/// The same search can also enumerate every solution instead of stopping
+	/// at the first one. Each solution is passed to a callback while it is
+	/// still in the search's working path, so no solutions are kept in
+	/// memory, and counting with an empty callback never copies a path.
+	/// 
+	/// Optional reachability pruning flood fills the unvisited points from
+	/// the head of the path and backtracks if an end point or a dot has been
+	/// cut off. The fill costs a pass over the open points, so it only runs
+	/// on every k-th search node, and k grows while the checks rarely prune
+	/// (and shrinks again when they start paying off).
 	///////////////////////////////////////////////////////////////////////////
 	class HostSolver : public Solver
 	{
 	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Initialize the solver
+		/// 
+		/// \param [in] enablePruning true to backtrack early from partial
+		/// paths that cannot be completed, false to search every path
+		/// \param [in] useBitboards true to search using bitboards
+		///////////////////////////////////////////////////////////////////////
+		HostSolver(bool enablePruning = true, bool useBitboards = false);
+		
 		///////////////////////////////////////////////////////////////////////
 		/// \brief Virtual destructor
 		///////////////////////////////////////////////////////////////////////
 		virtual ~HostSolver();
 		
+		// prevent creating copies of the solver (it owns the table)
+		HostSolver(const HostSolver& other) = delete;
+		HostSolver& operator=(const HostSolver& other) = delete;
+		
 		///////////////////////////////////////////////////////////////////////
 		/// \copydoc Solver::solvePuzzle()
 		///////////////////////////////////////////////////////////////////////
 		virtual bool solvePuzzle(const Puzzle& puzzle, Path& path);
 		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Continue an exhaustive search from a partial path
+		/// 
+		/// The path's start point and existing moves are kept as a fixed
+		/// prefix, and only paths that extend the prefix are searched.
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in,out] path the prefix to extend (replaced by the
+		/// solution if one is found)
+		/// 
+		/// \returns true if the puzzle was solved, false otherwise
+		/// 
+		/// \note The transposition table is kept between calls so that
+		/// prefixes of the same puzzle share dead states. Call
+		/// resetTranspositionTable() before switching to a different puzzle.
+		///////////////////////////////////////////////////////////////////////
+		bool solvePrefix(const Puzzle& puzzle, Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Set a flag that aborts the search once it becomes true
+		/// 
+		/// \param [in] stopFlag the flag to poll (nullptr to never stop)
+		///////////////////////////////////////////////////////////////////////
+		void setStopFlag(const std::atomic<bool>* stopFlag);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Search for every solution of a puzzle
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in,out] path the working path for the search (holds the
+		/// last solution if the callback stopped the enumeration)
+		/// \param [in] callback the function called with each solution (an
+		/// empty function only counts solutions)
+		/// 
+		/// \returns the number of solutions found
+		///////////////////////////////////////////////////////////////////////
+		uint64_t enumerateSolutions(const Puzzle& puzzle, Path& path, const SolutionCallback& callback);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Search for every solution that extends a partial path
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in,out] path the prefix to extend (see solvePrefix())
+		/// \param [in] callback the function called with each solution (an
+		/// empty function only counts solutions)
+		/// 
+		/// \returns the number of solutions found
+		///////////////////////////////////////////////////////////////////////
+		uint64_t enumeratePrefix(const Puzzle& puzzle, Path& path, const SolutionCallback& callback);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Enable or disable the dead state transposition table
+		/// 
+		/// \param [in] maxBytes the memory limit for the table (0 to disable)
+		/// \param [in] policy the replacement policy for full buckets
+		///////////////////////////////////////////////////////////////////////
+		void setTranspositionTable(size_t maxBytes, ReplacementPolicy policy = ReplacementPolicy::PREFER_LARGER);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Forget all dead states and prepare the table for a puzzle
+		/// 
+		/// \param [in] puzzle the puzzle
+		///////////////////////////////////////////////////////////////////////
+		void resetTranspositionTable(const Puzzle& puzzle);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of states skipped using the table
+		/// 
+		/// \returns the number of table hits since the last table reset
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumTableHits() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Enable or disable reachability pruning
+		/// 
+		/// \param [in] enable true to check that an end point and every dot
+		/// can still be reached (only used if pruning is enabled)
+		///////////////////////////////////////////////////////////////////////
+		void setReachabilityPruning(bool enable);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of partial paths cut by reachability checks
+		/// 
+		/// \returns the number of reachability prunes in the last solve
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumReachabilityPrunes() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of search nodes visited by the last solve
+		/// 
+		/// \returns the number of partial paths that were extended
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumNodes() const;
+		
 	private:
-		bool searchPuzzle(const Puzzle& puzzle, Path& path, size_t row, size_t col, bool* visitFlags);
+		///////////////////////////////////////////////////////////////////////
+		/// \struct SearchState
+		/// \brief Running constraint state of a partial path
+		///////////////////////////////////////////////////////////////////////
+		struct SearchState
+		{
+			bool* visitedPoints;
+			bool* visitedEdges;
+			
+			// number of point/edge dots in the puzzle and the number
+			// the path has not passed through yet
+			size_t totalDots;
+			size_t remainingDots;
+			
+			// only check regions if the puzzle contains both mark colors
+			bool checkRegions;
+			
+			// scratch space for partitioning spaces into regions
+			int* spacePartitionNumbers;
+			int* searchStack;
+			bool* whitePartitions;
+			bool* blackPartitions;
+			bool* splittablePartitions;
+			
+			// scratch space for reachability checks
+			bool* reachedPoints;
+			int* pointStack;
+			
+			// move tables and scratch space for evaluating complete paths
+			CompiledPuzzle* compiled;
+			EvaluationWorkspace* workspace;
+			
+			// Zobrist hash of the visited points and edges
+			uint64_t hash;
+		};
+		
+		bool m_enablePruning;
+		bool m_useBitboards;
+		size_t m_numNodes;
+		const std::atomic<bool>* m_stopFlag;
+		TranspositionTable* m_table;
+		bool m_useTable;
+		
+		// enumeration state (the callback is null when only solving)
+		const SolutionCallback* m_callback;
+		bool m_enumerating;
+		uint64_t m_numSolutions;
+		
+		// adaptive reachability check state (a check runs every
+		// m_reachabilityInterval nodes)
+		bool m_enableReachability;
+		size_t m_reachabilityInterval;
+		size_t m_reachabilityCountdown;
+		size_t m_windowChecks;
+		size_t m_windowPrunes;
+		size_t m_numReachabilityPrunes;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Handle a complete path that solves the puzzle
+		/// 
+		/// \param [in] path the solution
+		/// 
+		/// \returns true if the search should stop, false to keep searching
+		/// for more solutions
+		///////////////////////////////////////////////////////////////////////
+		bool acceptSolution(const Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a state is worth looking up in the table
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in] path the partial path
+		/// 
+		/// \returns true if enough points are left for a lookup to pay off
+		///////////////////////////////////////////////////////////////////////
+		bool isTableState(const Puzzle& puzzle, const Path& path) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if the table says a search state has no solution
+		/// 
+		/// \param [in] hash the hash of the visited points and edges
+		/// \param [in] headIndex the current head of the path
+		/// 
+		/// \returns true if the state can be skipped
+		///////////////////////////////////////////////////////////////////////
+		bool isDeadState(uint64_t hash, size_t headIndex) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Record a fully searched state that has no solution
+		/// 
+		/// \param [in] hash the hash of the visited points and edges
+		/// \param [in] headIndex the current head of the path
+		/// \param [in] startNodes the node count when the state was entered
+		///////////////////////////////////////////////////////////////////////
+		void storeDeadState(uint64_t hash, size_t headIndex, size_t startNodes);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a reachability check is due at the current node
+		/// 
+		/// \returns true once every interval nodes if reachability pruning is
+		/// enabled
+		///////////////////////////////////////////////////////////////////////
+		bool isReachabilityNode();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Record the result of a reachability check and adapt the
+		/// check interval to how often the checks prune
+		/// 
+		/// \param [in] canReach the result of the check
+		/// 
+		/// \returns the result of the check (so it can be used in a condition)
+		///////////////////////////////////////////////////////////////////////
+		bool recordReachabilityCheck(bool canReach);
+		
+		bool isStopped() const;
+		
+		void initSearchState(const Puzzle& puzzle, SearchState& state) const;
+		void resetSearchState(const Puzzle& puzzle, SearchState& state) const;
+		void freeSearchState(SearchState& state) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Apply the moves of an existing path to the search state
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in] path the path to replay
+		/// \param [in,out] headIndex the start point (set to the last point)
+		/// \param [in,out] state the constraint state of the partial path
+		/// 
+		/// \returns false if the path is invalid or cannot be completed
+		///////////////////////////////////////////////////////////////////////
+		bool replayPath(const Puzzle& puzzle, const Path& path, size_t& headIndex, SearchState& state) const;
+		
+		bool searchPuzzle(const Puzzle& puzzle, Path& path, size_t currentIndex, SearchState& state);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a puzzle fits in the widest supported bitboard
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// 
+		/// \returns true if the puzzle can be searched using bitboards
+		///////////////////////////////////////////////////////////////////////
+		bool canUseBitboards(const Puzzle& puzzle) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Solve a puzzle using the narrowest bitboard that holds it
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in,out] path the solution (or prefix to extend)
+		/// \param [in] continuePrefix true to extend the path's existing
+		/// moves, false to search from every start point
+		/// 
+		/// \returns true if the puzzle was solved, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool solveWithBitboards(const Puzzle& puzzle, Path& path, bool continuePrefix);
+		
+		template <size_t NumWords>
+		bool solveBitboard(const Puzzle& puzzle, Path& path, bool continuePrefix);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Recursive bitboard search (visited sets are passed by value
+		/// so backtracking doesn't need to undo anything)
+		///////////////////////////////////////////////////////////////////////
+		template <size_t NumWords>
+		bool searchBitboard(const Puzzle& puzzle, const BitboardPuzzle<NumWords>& board, EvaluationWorkspace& workspace, Path& path,
+		                    size_t headIndex, Bitboard<NumWords> visitedPoints, const Bitboard<NumWords*2>& visitedEdges, uint64_t hash);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a partial path can still be completed after moving
+		/// the head of the path to a new point
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in] state the constraint state of the partial path
+		/// \param [in] prevIndex the point the head moved from
+		/// \param [in] headIndex the current head of the path
+		/// 
+		/// \returns false if the partial path can no longer lead to a
+		/// solution, true otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool canCompletePath(const Puzzle& puzzle, SearchState& state, size_t prevIndex, size_t headIndex) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a sealed region of spaces contains both white and
+		/// black marks
+		/// 
+		/// A region is sealed when none of the edges between its spaces can
+		/// still be traversed by the path.
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in] state the constraint state of the partial path
+		/// \param [in] headIndex the current head of the path
+		/// 
+		/// \returns true if a sealed region mixes white and black marks
+		///////////////////////////////////////////////////////////////////////
+		bool hasMixedSealedRegion(const Puzzle& puzzle, SearchState& state, size_t headIndex) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if the unvisited points the head of the path can still
+		/// reach contain an end point and every remaining dot
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in] state the constraint state of the partial path
+		/// \param [in] headIndex the current head of the path
+		/// 
+		/// \returns false if an end point or a dot has been cut off, true
+		/// otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool canReachGoal(const Puzzle& puzzle, SearchState& state, size_t headIndex) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if the path can still traverse an edge in the future
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in] state the constraint state of the partial path
+		/// \param [in] row1 the first point row
+		/// \param [in] col1 the first point column
+		/// \param [in] row2 the second point row
+		/// \param [in] col2 the second point column
+		/// \param [in] headIndex the current head of the path
+		/// 
+		/// \returns true if the edge is still traversable
+		///////////////////////////////////////////////////////////////////////
+		bool isEdgeTraversable(const Puzzle& puzzle, const SearchState& state, size_t row1, size_t col1, size_t row2, size_t col2, size_t headIndex) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if an unvisited point can still be entered and left
+		/// by the path
+		/// 
+		/// \param [in] state the constraint state of the partial path
+		/// \param [in] index the point index
+		/// \param [in] headIndex the current head of the path
+		/// 
+		/// \returns true if the point still has enough open neighbors
+		///////////////////////////////////////////////////////////////////////
+		bool isPointReachable(const SearchState& state, size_t index, size_t headIndex) const;
 	};
 }
 
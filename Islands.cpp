@@ -0,0 +1,177 @@
+//////////////////////////////
+// Islands.cpp              //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "Islands.h"
+
+#include "Philox.h"
+
+#include <algorithm>
+#include <stdint.h>
+
+namespace gws
+{
+	void getIslandRange(size_t popSize, size_t numIslands, size_t island, size_t& first, size_t& last)
+	{
+		size_t islandSize = popSize/numIslands;
+		first = island*islandSize;
+		last = island + 1 < numIslands ? first + islandSize : popSize;
+	}
+	
+	uint32_t getIslandSeed(uint32_t seed, size_t island)
+	{
+		uint32_t islandSeed = seed;
+		if (island > 0) {
+			uint32_t draws[4];
+			generateRandomWords(seed, RandomStream::ISLAND, 0, (uint32_t)island, 0, draws);
+			islandSeed = draws[0];
+		}
+		
+		return islandSeed;
+	}
+	
+	uint32_t getMigrationShift(MigrationTopology topology, size_t numIslands, uint32_t seed, uint32_t generation)
+	{
+		uint32_t shift = numIslands > 1 ? 1 : 0;
+		if (topology == MigrationTopology::RANDOM_RING && numIslands > 2) {
+			uint32_t draws[4];
+			generateRandomWords(seed, RandomStream::MIGRATION, generation, 0, 0, draws);
+			shift = 1 + (uint32_t)(((uint64_t)draws[0]*(numIslands - 1)) >> 32);
+		}
+		
+		return shift;
+	}
+	
+	void findFittestMembers(const int* fitness, size_t first, size_t last, size_t count, uint32_t* members)
+	{
+		// each pass finds the fittest member ranked after the previous one
+		for (size_t i = 0; i < count; ++i) {
+			size_t best = first;
+			bool found = false;
+			for (size_t j = first; j < last; ++j) {
+				bool afterPrevious = i == 0
+				                     || fitness[j] < fitness[members[i - 1]]
+				                     || (fitness[j] == fitness[members[i - 1]] && j > members[i - 1]);
+				if (afterPrevious && (!found || fitness[j] > fitness[best])) {
+					best = j;
+					found = true;
+				}
+			}
+			
+			members[i] = (uint32_t)best;
+		}
+	}
+	
+	void findWeakestMembers(const int* fitness, size_t first, size_t last, size_t count, uint32_t* members)
+	{
+		// each pass finds the weakest member ranked after the previous one
+		// (scanning backwards so ties keep the highest index)
+		for (size_t i = 0; i < count; ++i) {
+			size_t worst = first;
+			bool found = false;
+			for (size_t j = last; j > first; --j) {
+				size_t member = j - 1;
+				bool afterPrevious = i == 0
+				                     || fitness[member] > fitness[members[i - 1]]
+				                     || (fitness[member] == fitness[members[i - 1]] && member < members[i - 1]);
+				if (afterPrevious && (!found || fitness[member] < fitness[worst])) {
+					worst = member;
+					found = true;
+				}
+			}
+			
+			members[i] = (uint32_t)worst;
+		}
+	}
+	
+	IslandExchange::IslandExchange(size_t numIslands, size_t migrationInterval, size_t numMigrants, size_t genomeBytes,
+	                               MigrationTopology topology, uint32_t seed)
+		: m_numIslands(numIslands),
+		  m_migrationInterval(migrationInterval),
+		  m_numMigrants(numMigrants),
+		  m_genomeBytes(genomeBytes),
+		  m_topology(topology),
+		  m_seed(seed),
+		  m_solved(false),
+		  m_solvedIsland(0),
+		  m_solvedGeneration(0),
+		  m_stopped(false)
+	{
+		for (size_t slot = 0; slot < 2; ++slot) {
+			m_genes[slot].resize(numIslands*numMigrants*genomeBytes);
+			m_fitness[slot].resize(numIslands*numMigrants);
+			m_depositGenerations[slot].assign(numIslands, SIZE_MAX);
+		}
+	}
+	
+	bool IslandExchange::migrate(size_t island, size_t generation, unsigned char* genes, int* fitness)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		
+		// deposit the emigrants in this migration's slot (the other slot may
+		// still hold the previous migration for slower islands)
+		size_t slot = (generation/m_migrationInterval)%2;
+		size_t geneBytes = m_numMigrants*m_genomeBytes;
+		std::copy(genes, genes + geneBytes, m_genes[slot].begin() + island*geneBytes);
+		std::copy(fitness, fitness + m_numMigrants, m_fitness[slot].begin() + island*m_numMigrants);
+		m_depositGenerations[slot][island] = generation;
+		m_changed.notify_all();
+		
+		// wait for every island, unless a solution was found by this
+		// generation (the island that found it won't migrate)
+		auto allDeposited = [&]() {
+			return std::count(m_depositGenerations[slot].begin(), m_depositGenerations[slot].end(), generation) == (ptrdiff_t)m_numIslands;
+		};
+		m_changed.wait(lock, [&]() {
+			return allDeposited() || m_stopped || (m_solved && m_solvedGeneration <= generation);
+		});
+		
+		bool received = allDeposited();
+		if (received) {
+			// every island receives from the island the same distance behind it
+			uint32_t shift = getMigrationShift(m_topology, m_numIslands, m_seed, (uint32_t)generation);
+			size_t source = (island + m_numIslands - shift)%m_numIslands;
+			std::copy(m_genes[slot].begin() + source*geneBytes, m_genes[slot].begin() + (source + 1)*geneBytes, genes);
+			std::copy(m_fitness[slot].begin() + source*m_numMigrants, m_fitness[slot].begin() + (source + 1)*m_numMigrants, fitness);
+		}
+		
+		return received;
+	}
+	
+	void IslandExchange::recordSolution(size_t island, size_t generation)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_solved || generation < m_solvedGeneration || (generation == m_solvedGeneration && island < m_solvedIsland)) {
+			m_solved = true;
+			m_solvedIsland = island;
+			m_solvedGeneration = generation;
+		}
+		
+		m_changed.notify_all();
+	}
+	
+	void IslandExchange::stop()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopped = true;
+		m_changed.notify_all();
+	}
+	
+	bool IslandExchange::isRunning(size_t generation) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return !m_stopped && (!m_solved || generation <= m_solvedGeneration);
+	}
+	
+	bool IslandExchange::getSolution(size_t& island, size_t& generation) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		island = m_solvedIsland;
+		generation = m_solvedGeneration;
+		
+		return m_solved;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+//////////////////////////////
+// Islands.h                //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_Islands_h
+#define gws_Islands_h
+
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace gws
+{
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Topologies for migrating members between islands
+	///////////////////////////////////////////////////////////////////////////
+	enum class MigrationTopology : uint32_t
+	{
+		// each island sends its emigrants to the next island
+		RING = 0,
+		
+		// each island sends its emigrants to the island a random distance
+		// ahead (the same distance for every island, redrawn for every
+		// migration)
+		RANDOM_RING
+	};
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Get the range of members belonging to an island
+	/// 
+	/// The population is split into contiguous islands of equal size, and
+	/// the last island takes any remainder.
+	/// 
+	/// \param [in] popSize the population size
+	/// \param [in] numIslands the number of islands
+	/// \param [in] island the island index
+	/// \param [out] first the first member of the island
+	/// \param [out] last one past the last member of the island
+	///////////////////////////////////////////////////////////////////////////
+	void getIslandRange(size_t popSize, size_t numIslands, size_t island, size_t& first, size_t& last);
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Get the random seed of an island
+	/// 
+	/// \param [in] seed the random seed of the whole population
+	/// \param [in] island the island index
+	/// 
+	/// \returns the island's seed (the given seed for island 0, so one
+	/// island evolves like the whole population)
+	///////////////////////////////////////////////////////////////////////////
+	uint32_t getIslandSeed(uint32_t seed, size_t island);
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Get the distance (in islands) that emigrants travel
+	/// 
+	/// \param [in] topology the migration topology
+	/// \param [in] numIslands the number of islands
+	/// \param [in] seed the random seed
+	/// \param [in] generation the current generation
+	/// 
+	/// \returns the distance (between 1 and numIslands - 1, or 0 if there is
+	/// only one island)
+	///////////////////////////////////////////////////////////////////////////
+	uint32_t getMigrationShift(MigrationTopology topology, size_t numIslands, uint32_t seed, uint32_t generation);
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Find the fittest members of an island (in order, with ties
+	/// keeping the lowest member index)
+	/// 
+	/// \param [in] fitness the fitness values of the population
+	/// \param [in] first the first member of the island
+	/// \param [in] last one past the last member of the island
+	/// \param [in] count the number of members to find
+	/// \param [out] members the member indices
+	///////////////////////////////////////////////////////////////////////////
+	void findFittestMembers(const int* fitness, size_t first, size_t last, size_t count, uint32_t* members);
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Find the least fit members of an island (in order, with ties
+	/// keeping the highest member index)
+	/// 
+	/// \param [in] fitness the fitness values of the population
+	/// \param [in] first the first member of the island
+	/// \param [in] last one past the last member of the island
+	/// \param [in] count the number of members to find
+	/// \param [out] members the member indices
+	///////////////////////////////////////////////////////////////////////////
+	void findWeakestMembers(const int* fitness, size_t first, size_t last, size_t count, uint32_t* members);
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \class IslandExchange
+	/// \brief Host memory through which islands evolving on their own
+	/// threads trade migrants and agree on when to stop
+	/// 
+	/// Every island deposits its emigrants and waits until all islands have
+	/// deposited theirs before taking its immigrants, so the migrants don't
+	/// depend on how fast each island runs. Deposits alternate between two
+	/// slots, since no island can get more than one migration ahead of the
+	/// others.
+	/// 
+	/// The solution found in the earliest generation wins (the lowest island
+	/// breaks ties), and islands stop once they pass its generation.
+	///////////////////////////////////////////////////////////////////////////
+	class IslandExchange
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Initialize the exchange
+		/// 
+		/// \param [in] numIslands the number of islands
+		/// \param [in] migrationInterval the number of generations between
+		/// migrations
+		/// \param [in] numMigrants the number of members each island sends
+		/// per migration
+		/// \param [in] genomeBytes the number of bytes in each member's genome
+		/// \param [in] topology the migration topology
+		/// \param [in] seed the random seed of the whole population
+		///////////////////////////////////////////////////////////////////////
+		IslandExchange(size_t numIslands, size_t migrationInterval, size_t numMigrants, size_t genomeBytes,
+		               MigrationTopology topology, uint32_t seed);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Trade an island's emigrants for the emigrants of the island
+		/// sending to it, once every island has deposited its emigrants
+		/// 
+		/// \param [in] island the island index
+		/// \param [in] generation the current generation
+		/// \param [in,out] genes the genomes of the island's emigrants (in rank
+		/// order), replaced by the genomes of its immigrants
+		/// \param [in,out] fitness the fitness values of the island's
+		/// emigrants, replaced by those of its immigrants
+		/// 
+		/// \returns true if the immigrants were received, false if the
+		/// islands stopped before every island reached the migration
+		///////////////////////////////////////////////////////////////////////
+		bool migrate(size_t island, size_t generation, unsigned char* genes, int* fitness);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Record a solution found by an island
+		/// 
+		/// \param [in] island the island index
+		/// \param [in] generation the generation containing the solution
+		///////////////////////////////////////////////////////////////////////
+		void recordSolution(size_t island, size_t generation);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Stop every island (after one of them failed)
+		///////////////////////////////////////////////////////////////////////
+		void stop();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if islands still need to run a generation
+		/// 
+		/// \param [in] generation the generation
+		/// 
+		/// \returns true if no solution was found in an earlier generation
+		/// and the islands weren't stopped, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool isRunning(size_t generation) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the island that found the winning solution
+		/// 
+		/// \param [out] island the island index
+		/// \param [out] generation the generation containing the solution
+		/// 
+		/// \returns true if any island found a solution, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool getSolution(size_t& island, size_t& generation) const;
+		
+	private:
+		size_t m_numIslands;
+		size_t m_migrationInterval;
+		size_t m_numMigrants;
+		size_t m_genomeBytes;
+		MigrationTopology m_topology;
+		uint32_t m_seed;
+		
+		// emigrants deposited in each slot (island-major), and the generation
+		// each island last deposited them for
+		std::vector<unsigned char> m_genes[2];
+		std::vector<int> m_fitness[2];
+		std::vector<size_t> m_depositGenerations[2];
+		
+		bool m_solved;
+		size_t m_solvedIsland;
+		size_t m_solvedGeneration;
+		bool m_stopped;
+		
+		mutable std::mutex m_mutex;
+		std::condition_variable m_changed;
+	};
+}
+
+#endif
\ No newline at end of file
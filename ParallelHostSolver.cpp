@@ -0,0 +1,338 @@
+//////////////////////////////
+// ParallelHostSolver.cpp   //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "ParallelHostSolver.h"
+
+#include "HostSolver.h"
+#include "Path.h"
+#include "Puzzle.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// minimum number of tasks to create per thread when choosing the prefix
+// length automatically (more tasks give better load balancing)
+#define MIN_TASKS_PER_THREAD 16
+
+namespace gws
+{
+	ParallelHostSolver::ParallelHostSolver(size_t numThreads, size_t prefixLength, bool enablePruning, bool useBitboards)
+		: m_numThreads(numThreads),
+		  m_prefixLength(prefixLength),
+		  m_enablePruning(enablePruning),
+		  m_useBitboards(useBitboards),
+		  m_tableBytes(0),
+		  m_tablePolicy(ReplacementPolicy::PREFER_LARGER),
+		  m_enableReachability(false),
+		  m_numNodes(0),
+		  m_numTasks(0)
+	{}
+	
+	ParallelHostSolver::~ParallelHostSolver() {}
+	
+	bool ParallelHostSolver::solvePuzzle(const Puzzle& puzzle, Path& path)
+	{
+		size_t numThreads = getNumThreads();
+		
+		// split the search tree and deal tasks out to each worker's queue
+		std::vector<SearchTask> tasks;
+		buildTasks(puzzle, numThreads, tasks);
+		m_numTasks = tasks.size();
+		
+		std::vector<TaskQueue> queues(numThreads);
+		for (size_t i = 0; i < tasks.size(); ++i) {
+			queues[i%numThreads].tasks.push_back(i);
+		}
+		
+		// shared result (the first worker to find a solution stops the others)
+		std::atomic<bool> stopFlag(false);
+		std::mutex resultMutex;
+		bool solutionFound = false;
+		std::vector<size_t> numNodes(numThreads, 0);
+		
+		auto runWorker = [&](size_t worker) {
+			// each worker evaluates solutions on its own copy of the puzzle
+			// so that evaluation counters aren't shared between threads
+			Puzzle localPuzzle(puzzle);
+			HostSolver solver(m_enablePruning, m_useBitboards);
+			solver.setStopFlag(&stopFlag);
+			solver.setTranspositionTable(m_tableBytes, m_tablePolicy);
+			solver.resetTranspositionTable(localPuzzle);
+			solver.setReachabilityPruning(m_enableReachability);
+			
+			char* moveData = new char[path.getMaxLength()];
+			Path localPath(moveData, path.getMaxLength());
+			
+			size_t task;
+			while (!stopFlag.load() && takeTask(queues, worker, task)) {
+				localPath.clear();
+				localPath.setStartPointIndex(tasks[task].startPointIndex);
+				for (size_t i = 0; i < tasks[task].moves.size(); ++i) {
+					localPath.addMove((MoveValue)tasks[task].moves[i]);
+				}
+				
+				bool taskSolved = solver.solvePrefix(localPuzzle, localPath);
+				numNodes[worker] += solver.getNumNodes();
+				
+				if (taskSolved) {
+					std::lock_guard<std::mutex> lock(resultMutex);
+					if (!solutionFound) {
+						path.clear();
+						path.setStartPointIndex(localPath.getStartPointIndex());
+						for (size_t i = 0; i < localPath.getNumMoves(); ++i) {
+							path.addMove(localPath.getMove(i));
+						}
+						
+						solutionFound = true;
+						stopFlag.store(true);
+					}
+				}
+			}
+			
+			delete [] moveData;
+		};
+		
+		// run workers (the calling thread acts as the first worker)
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < numThreads; ++i) {
+			threads.push_back(std::thread(runWorker, i));
+		}
+		runWorker(0);
+		for (size_t i = 0; i < threads.size(); ++i) {
+			threads[i].join();
+		}
+		
+		m_numNodes = 0;
+		for (size_t i = 0; i < numThreads; ++i) {
+			m_numNodes += numNodes[i];
+		}
+		
+		return solutionFound;
+	}
+	
+	uint64_t ParallelHostSolver::countSolutions(const Puzzle& puzzle)
+	{
+		size_t numThreads = getNumThreads();
+		
+		// split the search tree and deal tasks out to each worker's queue
+		std::vector<SearchTask> tasks;
+		buildTasks(puzzle, numThreads, tasks);
+		m_numTasks = tasks.size();
+		
+		std::vector<TaskQueue> queues(numThreads);
+		for (size_t i = 0; i < tasks.size(); ++i) {
+			queues[i%numThreads].tasks.push_back(i);
+		}
+		
+		// every worker counts into its own slot, so nothing is shared
+		// until the workers are done
+		std::vector<uint64_t> numSolutions(numThreads, 0);
+		std::vector<size_t> numNodes(numThreads, 0);
+		
+		auto runWorker = [&](size_t worker) {
+			Puzzle localPuzzle(puzzle);
+			HostSolver solver(m_enablePruning, m_useBitboards);
+			solver.setReachabilityPruning(m_enableReachability);
+			
+			char* moveData = new char[puzzle.getNumPoints()];
+			Path localPath(moveData, puzzle.getNumPoints());
+			
+			size_t task;
+			while (takeTask(queues, worker, task)) {
+				localPath.clear();
+				localPath.setStartPointIndex(tasks[task].startPointIndex);
+				for (size_t i = 0; i < tasks[task].moves.size(); ++i) {
+					localPath.addMove((MoveValue)tasks[task].moves[i]);
+				}
+				
+				numSolutions[worker] += solver.enumeratePrefix(localPuzzle, localPath, SolutionCallback());
+				numNodes[worker] += solver.getNumNodes();
+			}
+			
+			delete [] moveData;
+		};
+		
+		// run workers (the calling thread acts as the first worker)
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < numThreads; ++i) {
+			threads.push_back(std::thread(runWorker, i));
+		}
+		runWorker(0);
+		for (size_t i = 0; i < threads.size(); ++i) {
+			threads[i].join();
+		}
+		
+		uint64_t totalSolutions = 0;
+		m_numNodes = 0;
+		for (size_t i = 0; i < numThreads; ++i) {
+			totalSolutions += numSolutions[i];
+			m_numNodes += numNodes[i];
+		}
+		
+		return totalSolutions;
+	}
+	
+	void ParallelHostSolver::setTranspositionTable(size_t maxBytes, ReplacementPolicy policy)
+	{
+		m_tableBytes = maxBytes;
+		m_tablePolicy = policy;
+	}
+	
+	void ParallelHostSolver::setReachabilityPruning(bool enable)
+	{
+		m_enableReachability = enable;
+	}
+	
+	size_t ParallelHostSolver::getNumNodes() const
+	{
+		return m_numNodes;
+	}
+	
+	size_t ParallelHostSolver::getNumTasks() const
+	{
+		return m_numTasks;
+	}
+	
+	size_t ParallelHostSolver::getNumThreads() const
+	{
+		size_t numThreads = m_numThreads;
+		if (numThreads == 0) {
+			numThreads = std::thread::hardware_concurrency();
+			if (numThreads == 0) {
+				numThreads = 1;
+			}
+		}
+		
+		return numThreads;
+	}
+	
+	void ParallelHostSolver::buildTasks(const Puzzle& puzzle, size_t numThreads, std::vector<SearchTask>& tasks) const
+	{
+		// start with an empty path from every start point
+		tasks.clear();
+		for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
+			if (puzzle.getPointValue(i) == PointValue::START) {
+				SearchTask task;
+				task.startPointIndex = i;
+				tasks.push_back(task);
+			}
+		}
+		
+		// extend prefixes by one move at a time until the requested length is
+		// reached (or there are enough tasks to keep every thread busy)
+		size_t minTasks = numThreads*MIN_TASKS_PER_THREAD;
+		size_t length = 0;
+		bool canExpand = true;
+		while (canExpand && !tasks.empty()
+		       && ((m_prefixLength > 0 && length < m_prefixLength) || (m_prefixLength == 0 && tasks.size() < minTasks))) {
+			std::vector<SearchTask> nextTasks;
+			expandTasks(puzzle, tasks, nextTasks);
+			
+			// stop once every prefix has reached an end point
+			canExpand = false;
+			for (size_t i = 0; !canExpand && i < nextTasks.size(); ++i) {
+				canExpand = nextTasks[i].moves.size() > length;
+			}
+			
+			tasks.swap(nextTasks);
+			++length;
+		}
+	}
+	
+	void ParallelHostSolver::expandTasks(const Puzzle& puzzle, const std::vector<SearchTask>& tasks, std::vector<SearchTask>& nextTasks) const
+	{
+		std::vector<bool> visitFlags(puzzle.getNumPoints());
+		
+		for (size_t t = 0; t < tasks.size(); ++t) {
+			const SearchTask& task = tasks[t];
+			
+			// follow prefix to find the visited points and the head of the path
+			visitFlags.assign(puzzle.getNumPoints(), false);
+			size_t row = puzzle.getPointRow(task.startPointIndex);
+			size_t col = puzzle.getPointCol(task.startPointIndex);
+			for (size_t i = 0; i < task.moves.size(); ++i) {
+				visitFlags[puzzle.getPointIndex(row, col)] = true;
+				switch ((MoveValue)task.moves[i]) {
+					case MoveValue::UP:
+						--row;
+						break;
+					case MoveValue::DOWN:
+						++row;
+						break;
+					case MoveValue::LEFT:
+						--col;
+						break;
+					case MoveValue::RIGHT:
+						++col;
+						break;
+					default:
+						break;
+				}
+			}
+			visitFlags[puzzle.getPointIndex(row, col)] = true;
+			
+			// completed paths can't be extended any further
+			if (puzzle.getPointValue(row, col) == PointValue::END) {
+				nextTasks.push_back(task);
+			}
+			else {
+				// create a task for every valid move (prefixes with no valid
+				// moves are dead ends and are dropped)
+				if (row > 0 && puzzle.getEdgeValue(row - 1, col, row, col) != EdgeValue::BLOCKED
+				      && puzzle.getPointValue(row - 1, col) != PointValue::BLOCKED && !visitFlags[puzzle.getPointIndex(row - 1, col)]) {
+					nextTasks.push_back(task);
+					nextTasks.back().moves.push_back((char)MoveValue::UP);
+				}
+				if (row < puzzle.getHeight() - 1 && puzzle.getEdgeValue(row, col, row + 1, col) != EdgeValue::BLOCKED
+				      && puzzle.getPointValue(row + 1, col) != PointValue::BLOCKED && !visitFlags[puzzle.getPointIndex(row + 1, col)]) {
+					nextTasks.push_back(task);
+					nextTasks.back().moves.push_back((char)MoveValue::DOWN);
+				}
+				if (col > 0 && puzzle.getEdgeValue(row, col - 1, row, col) != EdgeValue::BLOCKED
+				      && puzzle.getPointValue(row, col - 1) != PointValue::BLOCKED && !visitFlags[puzzle.getPointIndex(row, col - 1)]) {
+					nextTasks.push_back(task);
+					nextTasks.back().moves.push_back((char)MoveValue::LEFT);
+				}
+				if (col < puzzle.getWidth() - 1 && puzzle.getEdgeValue(row, col, row, col + 1) != EdgeValue::BLOCKED
+				      && puzzle.getPointValue(row, col + 1) != PointValue::BLOCKED && !visitFlags[puzzle.getPointIndex(row, col + 1)]) {
+					nextTasks.push_back(task);
+					nextTasks.back().moves.push_back((char)MoveValue::RIGHT);
+				}
+			}
+		}
+	}
+	
+	bool ParallelHostSolver::takeTask(std::vector<TaskQueue>& queues, size_t worker, size_t& task) const
+	{
+		bool taskFound = false;
+		
+		// take the oldest task from the worker's own queue
+		{
+			std::lock_guard<std::mutex> lock(queues[worker].mutex);
+			if (!queues[worker].tasks.empty()) {
+				task = queues[worker].tasks.front();
+				queues[worker].tasks.pop_front();
+				taskFound = true;
+			}
+		}
+		
+		// otherwise steal the newest task from the next non-empty queue
+		for (size_t i = 1; !taskFound && i < queues.size(); ++i) {
+			TaskQueue& victim = queues[(worker + i)%queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				task = victim.tasks.back();
+				victim.tasks.pop_back();
+				taskFound = true;
+			}
+		}
+		
+		return taskFound;
+	}
+}
\ No newline at end of file
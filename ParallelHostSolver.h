@@ -0,0 +1,179 @@
+//////////////////////////////
+// ParallelHostSolver.h     //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_ParallelHostSolver_h
+#define gws_ParallelHostSolver_h
+
+#include "Solver.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace gws
+{
+	class Path;
+	class Puzzle;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \class ParallelHostSolver
+	/// \brief Puzzle solver that runs the host search on multiple CPU threads
+	/// 
+	/// The search tree is split into tasks, each of which is a start point
+	/// plus a fixed number of initial moves. Tasks are dealt out to per-thread
+	/// queues, and threads that run out of work steal tasks from the other
+	/// queues. All threads stop as soon as any one of them finds a solution.
+	///////////////////////////////////////////////////////////////////////////
+	class ParallelHostSolver : public Solver
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Initialize the solver
+		/// 
+		/// \param [in] numThreads the number of worker threads (0 to use
+		/// the number of hardware threads)
+		/// \param [in] prefixLength the number of moves in each task prefix
+		/// (0 to pick a length that gives every thread several tasks)
+		/// \param [in] enablePruning true to backtrack early from partial
+		/// paths that cannot be completed, false to search every path
+		/// \param [in] useBitboards true to search using bitboards
+		///////////////////////////////////////////////////////////////////////
+		ParallelHostSolver(size_t numThreads = 0, size_t prefixLength = 0, bool enablePruning = true, bool useBitboards = false);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Virtual destructor
+		///////////////////////////////////////////////////////////////////////
+		virtual ~ParallelHostSolver();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \copydoc Solver::solvePuzzle()
+		///////////////////////////////////////////////////////////////////////
+		virtual bool solvePuzzle(const Puzzle& puzzle, Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Count every solution of a puzzle on all threads
+		/// 
+		/// Each worker counts the solutions of its tasks without storing any
+		/// paths, and the counts are added up once all tasks are done.
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// 
+		/// \returns the number of solutions
+		///////////////////////////////////////////////////////////////////////
+		uint64_t countSolutions(const Puzzle& puzzle);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Give every worker its own dead state transposition table
+		/// 
+		/// Dead states are shared between all tasks run by the same worker.
+		/// 
+		/// \param [in] maxBytes the memory limit per worker (0 to disable)
+		/// \param [in] policy the replacement policy for full buckets
+		///////////////////////////////////////////////////////////////////////
+		void setTranspositionTable(size_t maxBytes, ReplacementPolicy policy = ReplacementPolicy::PREFER_LARGER);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Enable or disable reachability pruning on every worker
+		/// 
+		/// \param [in] enable true to check that an end point and every dot
+		/// can still be reached (see HostSolver::setReachabilityPruning())
+		///////////////////////////////////////////////////////////////////////
+		void setReachabilityPruning(bool enable);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of search nodes visited by the last solve
+		/// 
+		/// \returns the number of partial paths extended by all threads
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumNodes() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of tasks the last solve was split into
+		/// 
+		/// \returns the number of path prefixes
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumTasks() const;
+		
+	private:
+		///////////////////////////////////////////////////////////////////////
+		/// \struct SearchTask
+		/// \brief A path prefix to be extended by one worker
+		///////////////////////////////////////////////////////////////////////
+		struct SearchTask
+		{
+			size_t startPointIndex;
+			std::vector<char> moves;
+		};
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \struct TaskQueue
+		/// \brief Double-ended queue of task indices owned by one worker
+		///////////////////////////////////////////////////////////////////////
+		struct TaskQueue
+		{
+			std::mutex mutex;
+			std::deque<size_t> tasks;
+		};
+		
+		size_t m_numThreads;
+		size_t m_prefixLength;
+		bool m_enablePruning;
+		bool m_useBitboards;
+		size_t m_tableBytes;
+		ReplacementPolicy m_tablePolicy;
+		bool m_enableReachability;
+		
+		size_t m_numNodes;
+		size_t m_numTasks;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of worker threads to run
+		/// 
+		/// \returns the configured number of threads, or the number of
+		/// hardware threads if none was configured
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumThreads() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Split the search tree into path prefix tasks
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in] numThreads the number of worker threads
+		/// \param [out] tasks the generated tasks
+		///////////////////////////////////////////////////////////////////////
+		void buildTasks(const Puzzle& puzzle, size_t numThreads, std::vector<SearchTask>& tasks) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Extend every task by one move
+		/// 
+		/// Tasks that end at an end point are kept as they are.
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// \param [in] tasks the current tasks
+		/// \param [out] nextTasks the extended tasks
+		///////////////////////////////////////////////////////////////////////
+		void expandTasks(const Puzzle& puzzle, const std::vector<SearchTask>& tasks, std::vector<SearchTask>& nextTasks) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Take the next task for a worker, stealing from other
+		/// workers if its own queue is empty
+		/// 
+		/// \param [in] queues the task queues of all workers
+		/// \param [in] worker the index of the requesting worker
+		/// \param [out] task the index of the task
+		/// 
+		/// \returns true if a task was found, false if all queues are empty
+		///////////////////////////////////////////////////////////////////////
+		bool takeTask(std::vector<TaskQueue>& queues, size_t worker, size_t& task) const;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,149 @@
+//////////////////////////////
+// Philox.h                 //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_Philox_h
+#define gws_Philox_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace gws
+{
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Random streams used by the genetic algorithm
+	/// 
+	/// Each stream is a separate counter range of the same seed, so random
+	/// values drawn for one purpose never repeat the values of another.
+	///////////////////////////////////////////////////////////////////////////
+	enum class RandomStream : uint32_t
+	{
+		POPULATION = 0,
+		CROSSOVER,
+		MUTATION,
+		SELECTION,
+		MIGRATION,
+		
+		// seeds of the islands (only drawn on the host)
+		ISLAND
+	};
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Number of random bytes generated by one Philox block
+	///////////////////////////////////////////////////////////////////////////
+	const size_t PHILOX_BLOCK_BYTES = 16;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Generate one block of the Philox4x32-10 counter-based random
+	/// number generator
+	/// 
+	/// The output only depends on the counter and key, so any random value
+	/// can be generated independently of the others. GeneticSolver.cl
+	/// contains the same function, and both must produce identical blocks.
+	/// 
+	/// \param [in] counter the 128-bit block counter
+	/// \param [in] key the 64-bit key
+	/// \param [out] output the 128 random bits of the block
+	///////////////////////////////////////////////////////////////////////////
+	inline void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t output[4])
+	{
+		uint32_t c0 = counter[0];
+		uint32_t c1 = counter[1];
+		uint32_t c2 = counter[2];
+		uint32_t c3 = counter[3];
+		uint32_t k0 = key[0];
+		uint32_t k1 = key[1];
+		for (int round = 0; round < 10; ++round) {
+			uint64_t product0 = (uint64_t)0xD2511F53 * c0;
+			uint64_t product1 = (uint64_t)0xCD9E8D57 * c2;
+			uint32_t next0 = (uint32_t)(product1 >> 32) ^ c1 ^ k0;
+			uint32_t next2 = (uint32_t)(product0 >> 32) ^ c3 ^ k1;
+			c1 = (uint32_t)product1;
+			c3 = (uint32_t)product0;
+			c0 = next0;
+			c2 = next2;
+			
+			// bump key (Weyl sequence)
+			k0 += 0x9E3779B9;
+			k1 += 0xBB67AE85;
+		}
+		
+		output[0] = c0;
+		output[1] = c1;
+		output[2] = c2;
+		output[3] = c3;
+	}
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Generate a block of random words for the genetic algorithm
+	/// 
+	/// The block counter holds the index, the generation, the stream and the
+	/// sub-index, and the key holds the seed, so every value is fixed by
+	/// where it is used rather than by the order it was generated in.
+	/// 
+	/// \param [in] seed the random seed
+	/// \param [in] stream the random stream
+	/// \param [in] generation the generation the values are drawn for
+	/// \param [in] index the block (or population member) index
+	/// \param [in] subIndex the block index within a population member
+	/// \param [out] words the four random words
+	///////////////////////////////////////////////////////////////////////////
+	inline void generateRandomWords(uint32_t seed, RandomStream stream, uint32_t generation, uint32_t index, uint32_t subIndex, uint32_t words[4])
+	{
+		uint32_t counter[4] = { index, generation, (uint32_t)stream, subIndex };
+		uint32_t key[2] = { seed, 0 };
+		philox4x32(counter, key, words);
+	}
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Generate a block of random bytes for the genetic algorithm
+	/// 
+	/// \param [in] seed the random seed
+	/// \param [in] stream the random stream
+	/// \param [in] generation the generation the values are drawn for
+	/// \param [in] block the block index within the generation
+	/// \param [out] bytes the PHILOX_BLOCK_BYTES random bytes (in
+	/// little-endian order of the four output words)
+	///////////////////////////////////////////////////////////////////////////
+	inline void generateRandomBlock(uint32_t seed, RandomStream stream, uint32_t generation, uint32_t block, unsigned char* bytes)
+	{
+		uint32_t words[4];
+		generateRandomWords(seed, stream, generation, block, 0, words);
+		
+		for (size_t i = 0; i < PHILOX_BLOCK_BYTES; ++i) {
+			bytes[i] = (unsigned char)(words[i/4] >> (8*(i%4)));
+		}
+	}
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Convert a probability into a threshold for random words
+	/// 
+	/// A random word is below the threshold with the given probability.
+	/// Decisions are made by comparing integers so the host and device make
+	/// the same decisions regardless of floating point rounding.
+	/// 
+	/// \param [in] rate the probability (clamped to [0, 1])
+	/// 
+	/// \returns the threshold (between 0 and 2^32)
+	///////////////////////////////////////////////////////////////////////////
+	inline uint64_t getRandomThreshold(float rate)
+	{
+		uint64_t threshold;
+		if (rate <= 0.0f) {
+			threshold = 0;
+		}
+		else if (rate >= 1.0f) {
+			threshold = (uint64_t)1 << 32;
+		}
+		else {
+			threshold = (uint64_t)((double)rate*4294967296.0);
+		}
+		
+		return threshold;
+	}
+}
+
+#endif
\ No newline at end of file
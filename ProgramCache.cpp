@@ -0,0 +1,115 @@
+//////////////////////////////
+// ProgramCache.cpp         //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "ProgramCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gws
+{
+	ProgramCache::ProgramCache()
+	{
+		const char* cacheDir = getenv("GWS_CACHE_DIR");
+		const char* xdgCacheHome = getenv("XDG_CACHE_HOME");
+		const char* home = getenv("HOME");
+		if (cacheDir != NULL && cacheDir[0] != '\0') {
+			m_directory = cacheDir;
+		}
+		else if (xdgCacheHome != NULL && xdgCacheHome[0] != '\0') {
+			m_directory = std::string(xdgCacheHome) + "/genWitnessSolver";
+		}
+		else if (home != NULL && home[0] != '\0') {
+			m_directory = std::string(home) + "/.cache/genWitnessSolver";
+		}
+		
+		// create each missing directory along the path (existing ones just
+		// fail), and disable caching if the directory still isn't there
+		if (!m_directory.empty()) {
+			for (size_t slash = m_directory.find('/', 1); slash != std::string::npos; slash = m_directory.find('/', slash + 1)) {
+				mkdir(m_directory.substr(0, slash).c_str(), 0755);
+			}
+			mkdir(m_directory.c_str(), 0755);
+			
+			struct stat info;
+			if (stat(m_directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+				m_directory.clear();
+			}
+		}
+	}
+	
+	bool ProgramCache::isEnabled() const
+	{
+		return !m_directory.empty();
+	}
+	
+	std::string ProgramCache::makeKey(const std::vector<std::string>& parts)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < parts.size(); ++i) {
+			// hash each part's length too so moving text between parts
+			// changes the key
+			std::string part = std::to_string(parts[i].size()) + ":" + parts[i];
+			for (size_t j = 0; j < part.size(); ++j) {
+				hash ^= (unsigned char)part[j];
+				hash *= 1099511628211ull;
+			}
+		}
+		
+		std::ostringstream oss;
+		oss << std::hex << hash;
+		
+		return oss.str();
+	}
+	
+	bool ProgramCache::load(const std::string& key, std::vector<unsigned char>& binary) const
+	{
+		bool found = false;
+		if (isEnabled()) {
+			std::ifstream file(getPath(key).c_str(), std::ios::binary);
+			if (file.is_open()) {
+				binary.assign(
+					std::istreambuf_iterator<char>(file),
+					(std::istreambuf_iterator<char>()));
+				found = !binary.empty();
+			}
+		}
+		
+		return found;
+	}
+	
+	void ProgramCache::store(const std::string& key, const std::vector<unsigned char>& binary) const
+	{
+		if (isEnabled() && !binary.empty()) {
+			// write under a name unique to this process, then move the
+			// complete file into place
+			std::string path = getPath(key);
+			std::string tempPath = path + "." + std::to_string(getpid()) + ".tmp";
+			bool written;
+			{
+				std::ofstream file(tempPath.c_str(), std::ios::binary);
+				file.write((const char*)binary.data(), binary.size());
+				written = file.good();
+			}
+			
+			if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+				std::remove(tempPath.c_str());
+			}
+		}
+	}
+	
+	std::string ProgramCache::getPath(const std::string& key) const
+	{
+		return m_directory + "/" + key + ".bin";
+	}
+}
\ No newline at end of file
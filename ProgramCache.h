@@ -0,0 +1,82 @@
+//////////////////////////////
+// ProgramCache.h           //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_ProgramCache_h
+#define gws_ProgramCache_h
+
+#include <string>
+#include <vector>
+
+namespace gws
+{
+	///////////////////////////////////////////////////////////////////////////
+	/// \class ProgramCache
+	/// \brief Stores compiled OpenCL program binaries on disk so later
+	/// processes can skip compiling the kernel source
+	/// 
+	/// Each binary is stored in its own file named by a hash of everything
+	/// that affects compilation (device, driver version, source and build
+	/// options). The cache directory is taken from the GWS_CACHE_DIR
+	/// environment variable, or genWitnessSolver under XDG_CACHE_HOME or
+	/// ~/.cache, and caching is disabled if none of them are set. Files are
+	/// written under a temporary name and then renamed, so processes sharing
+	/// the cache never read a partial binary. Stale or unreadable binaries
+	/// are rebuilt from source and replaced, so deleting the directory is
+	/// always safe.
+	///////////////////////////////////////////////////////////////////////////
+	class ProgramCache
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Initialize the cache in the directory named by the
+		/// environment
+		///////////////////////////////////////////////////////////////////////
+		ProgramCache();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a cache directory is available
+		/// 
+		/// \returns true if binaries can be loaded and stored
+		///////////////////////////////////////////////////////////////////////
+		bool isEnabled() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Make the key of a program binary
+		/// 
+		/// \param [in] parts everything that affects compilation
+		/// 
+		/// \returns the key (a 64-bit FNV-1a hash of the parts, in hex)
+		///////////////////////////////////////////////////////////////////////
+		static std::string makeKey(const std::vector<std::string>& parts);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Load a program binary
+		/// 
+		/// \param [in] key the binary's key
+		/// \param [out] binary the binary
+		/// 
+		/// \returns true if the binary was found, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool load(const std::string& key, std::vector<unsigned char>& binary) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Store a program binary (failures are ignored, since the
+		/// program can always be compiled again)
+		/// 
+		/// \param [in] key the binary's key
+		/// \param [in] binary the binary
+		///////////////////////////////////////////////////////////////////////
+		void store(const std::string& key, const std::vector<unsigned char>& binary) const;
+		
+	private:
+		std::string m_directory;
+		
+		std::string getPath(const std::string& key) const;
+	};
+}
+
+#endif
\ No newline at end of file
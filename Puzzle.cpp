@@ -7,6 +7,8 @@
 
 #include "Puzzle.h"
 
+#include "CompiledPuzzle.h"
+#include "EvaluationWorkspace.h"
 #include "Path.h"
 
 #include <ostream>
@@ -150,6 +152,13 @@ namespace gws
 	}
 	
 	bool Puzzle::evaluateSolution(const Path& path) const
+	{
+		EvaluationWorkspace workspace(*this);
+		
+		return evaluateSolution(path, workspace);
+	}
+	
+	bool Puzzle::evaluateSolution(const Path& path, EvaluationWorkspace& workspace) const
 	{
 		++m_numEvals;
 		
@@ -159,29 +168,15 @@ namespace gws
 			return false;
 		}
 		
-		// keep track of points visited to make sure no point is visited twice
-		bool* visitedPoints = new bool[getNumPoints()];
-		for (size_t i = 0; i < getNumPoints(); ++i) {
-			visitedPoints[i] = false;
-		}
-		
-		// keep track of edges traversed in order to build partitions
-		// to check white/black space constraints later
-		bool* visitedEdges = new bool[getNumEdges()];
-		for (size_t i = 0; i < getNumEdges(); ++i) {
-			visitedEdges[i] = false;
-		}
-		
-		// create list of dots to ensure the path travels through all of them
-		bool* pointDots = new bool[getNumPoints()];
-		for (size_t i = 0; i < getNumPoints(); ++i) {
-			pointDots[i] = (m_pointData[i] == (char)PointValue::DOT);
-		}
+		// unmark all points, edges and spaces from the previous evaluation
+		workspace.nextGeneration();
+		const unsigned int generation = workspace.m_generation;
 		
-		bool* edgeDots = new bool[getNumEdges()];
-		for (size_t i = 0; i < getNumEdges(); ++i) {
-			edgeDots[i] = (m_edgeData[i] == (char)EdgeValue::DOT);
-		}
+		// keep track of points visited to make sure no point is visited twice
+		// and edges traversed in order to build partitions to check
+		// white/black space constraints later
+		unsigned int* visitedPoints = workspace.m_pointStamps;
+		unsigned int* visitedEdges = workspace.m_edgeStamps;
 		
 		// follow path
 		bool validPath = true;
@@ -191,10 +186,7 @@ namespace gws
 		
 		while (validPath && move < path.getNumMoves()) {
 			// mark point as visited
-			visitedPoints[getPointIndex(row, col)] = true;
-			
-			// mark off potential point dot
-			pointDots[getPointIndex(row, col)] = false;
+			visitedPoints[getPointIndex(row, col)] = generation;
 			
 			// validate next move
 			switch (path.getMove(move)) {
@@ -202,13 +194,10 @@ namespace gws
 					validPath = row > 0
 					         && getPointValue(row - 1, col) != PointValue::BLOCKED
 					         && getEdgeValue(row - 1, col, row, col) != EdgeValue::BLOCKED
-					         && !visitedPoints[getPointIndex(row - 1, col)];
+					         && visitedPoints[getPointIndex(row - 1, col)] != generation;
 					if (validPath) {
 						// mark edge as traversed
-						visitedEdges[getEdgeIndex(row - 1, col, row, col)] = true;
-						
-						// mark off potential edge dot
-						edgeDots[getEdgeIndex(row - 1, col, row, col)] = false;
+						visitedEdges[getEdgeIndex(row - 1, col, row, col)] = generation;
 						
 						// move to next point
 						--row;
@@ -218,13 +207,10 @@ namespace gws
 					validPath = row < getHeight() - 1
 					         && getPointValue(row + 1, col) != PointValue::BLOCKED
 					         && getEdgeValue(row, col, row + 1, col) != EdgeValue::BLOCKED
-					         && !visitedPoints[getPointIndex(row + 1, col)];
+					         && visitedPoints[getPointIndex(row + 1, col)] != generation;
 					if (validPath) {
 						// mark edge as traversed
-						visitedEdges[getEdgeIndex(row, col, row + 1, col)] = true;
-						
-						// mark off potential edge dot
-						edgeDots[getEdgeIndex(row, col, row + 1, col)] = false;
+						visitedEdges[getEdgeIndex(row, col, row + 1, col)] = generation;
 						
 						// move to next point
 						++row;
@@ -234,13 +220,10 @@ namespace gws
 					validPath = col > 0
 					         && getPointValue(row, col - 1) != PointValue::BLOCKED
 					         && getEdgeValue(row, col - 1, row, col) != EdgeValue::BLOCKED
-					         && !visitedPoints[getPointIndex(row, col - 1)];
+					         && visitedPoints[getPointIndex(row, col - 1)] != generation;
 					if (validPath) {
 						// mark edge as traversed
-						visitedEdges[getEdgeIndex(row, col - 1, row, col)] = true;
-						
-						// mark off potential edge dot
-						edgeDots[getEdgeIndex(row, col - 1, row, col)] = false;
+						visitedEdges[getEdgeIndex(row, col - 1, row, col)] = generation;
 						
 						// move to next point
 						--col;
@@ -250,13 +233,10 @@ namespace gws
 					validPath = col < getWidth() - 1
 					         && getPointValue(row, col + 1) != PointValue::BLOCKED
 					         && getEdgeValue(row, col, row, col + 1) != EdgeValue::BLOCKED
-					         && !visitedPoints[getPointIndex(row, col + 1)];
+					         && visitedPoints[getPointIndex(row, col + 1)] != generation;
 					if (validPath) {
 						// mark edge as traversed
-						visitedEdges[getEdgeIndex(row, col, row, col + 1)] = true;
-						
-						// mark off potential edge dot
-						edgeDots[getEdgeIndex(row, col, row, col + 1)] = false;
+						visitedEdges[getEdgeIndex(row, col, row, col + 1)] = generation;
 						
 						// move to next point
 						++col;
@@ -269,62 +249,104 @@ namespace gws
 			++move;
 		}
 		
-		// validate that path ends at an end point
-		validPath = validPath && getPointValue(row, col) == PointValue::END;
+		// validate that path ends at an end point and meets every constraint
+		return validPath && getPointValue(row, col) == PointValue::END && checkConstraints(workspace);
+	}
+	
+	bool Puzzle::evaluateSolution(const Path& path, const CompiledPuzzle& compiled, EvaluationWorkspace& workspace) const
+	{
+		++m_numEvals;
+		
+		// path must start at a start point
+		size_t headIndex = path.getStartPointIndex();
+		if (headIndex >= getNumPoints() || m_pointData[headIndex] != (char)PointValue::START) {
+			return false;
+		}
+		
+		workspace.nextGeneration();
+		const unsigned int generation = workspace.m_generation;
+		unsigned int* visitedPoints = workspace.m_pointStamps;
+		unsigned int* visitedEdges = workspace.m_edgeStamps;
+		
+		// follow path (blocked and off-grid moves lead to an invalid index)
+		bool validPath = true;
+		size_t move = 0;
+		while (validPath && move < path.getNumMoves()) {
+			visitedPoints[headIndex] = generation;
+			
+			size_t nextIndex = compiled.getNeighborIndex(headIndex, path.getMove(move));
+			validPath = nextIndex < getNumPoints() && visitedPoints[nextIndex] != generation;
+			if (validPath) {
+				visitedEdges[compiled.getEdgeIndex(headIndex, path.getMove(move))] = generation;
+				headIndex = nextIndex;
+			}
+			
+			++move;
+		}
+		
+		return validPath && getPointValue(headIndex) == PointValue::END && checkConstraints(workspace);
+	}
+	
+	bool Puzzle::checkConstraints(EvaluationWorkspace& workspace) const
+	{
+		const unsigned int generation = workspace.m_generation;
+		const unsigned int* visitedPoints = workspace.m_pointStamps;
+		const unsigned int* visitedEdges = workspace.m_edgeStamps;
+		
+		bool validPath = true;
 		
-		// validate point and edge dot constraints
+		// validate point and edge dot constraints (every dot must have been
+		// visited; the end point can't be a dot, so it doesn't need marking)
 		size_t dotIndex = 0;
 		while (validPath && dotIndex < getNumPoints()) {
-			validPath = !pointDots[dotIndex];
+			validPath = m_pointData[dotIndex] != (char)PointValue::DOT || visitedPoints[dotIndex] == generation;
 			++dotIndex;
 		}
 		dotIndex = 0;
 		while (validPath && dotIndex < getNumEdges()) {
-			validPath = !edgeDots[dotIndex];
+			validPath = m_edgeData[dotIndex] != (char)EdgeValue::DOT || visitedEdges[dotIndex] == generation;
 			++dotIndex;
 		}
 		
 		// calculate partitions and validate white/black space constraints
 		if (validPath) {
-			// keep track of which partition each space belongs to
+			// keep track of which spaces have been assigned to a partition
 			// and which partitions have white or black spaces
-			int* spacePartitionNumbers = new int[getNumSpaces()];
-			bool* whitePartitions = new bool[getNumSpaces()];
-			bool* blackPartitions = new bool[getNumSpaces()];
-			int* searchStack = new int[getNumSpaces()];
-			for (size_t i = 0; i < getNumSpaces(); ++i) {
-				spacePartitionNumbers[i] = -1;
-				whitePartitions[i] = false;
-				blackPartitions[i] = false;
-				searchStack[i] = -1;
-			}
+			// (spaces are assigned once their stamp matches the generation)
+			unsigned int* assignedSpaces = workspace.m_spaceStamps;
+			bool* whitePartitions = workspace.m_whitePartitions;
+			bool* blackPartitions = workspace.m_blackPartitions;
+			size_t* searchStack = workspace.m_searchStack;
 			
 			// run depth-first search until solution is invalidated
 			// or all spaces are assigned to a partition
 			int currentPartition = 0;
 			size_t stackSize = 0;
 			size_t partitionedSpaces = 0;
+			size_t spaceIndex = 0;
 			while (validPath && partitionedSpaces < getNumSpaces()) {
 				// find starting point for search
-				size_t spaceIndex = 0;
-				while (spacePartitionNumbers[spaceIndex] >= 0) {
+				while (assignedSpaces[spaceIndex] == generation) {
 					++spaceIndex;
 				}
 				
 				// index is guaranteed to be valid since when all
 				// spaces are assigned this loop won't execute
+				whitePartitions[currentPartition] = false;
+				blackPartitions[currentPartition] = false;
+				assignedSpaces[spaceIndex] = generation;
 				searchStack[stackSize] = spaceIndex;
 				++stackSize;
 				
 				while (validPath && stackSize > 0) {
 					// pop space from stack
-					spaceIndex = searchStack[stackSize - 1];
+					size_t currentSpace = searchStack[stackSize - 1];
 					--stackSize;
 					
-					// assign partition number to current space and handle space value
-					spacePartitionNumbers[spaceIndex] = currentPartition;
+					// handle space value (a space is assigned when it is pushed so
+					// that no space is pushed more than once)
 					++partitionedSpaces;
-					switch (getSpaceValue(spaceIndex)) {
+					switch (getSpaceValue(currentSpace)) {
 						case SpaceValue::WHITE:
 							whitePartitions[currentPartition] = true;
 							break;
@@ -338,29 +360,31 @@ namespace gws
 					// only continue processing if partition constraint hasn't been violated
 					if (!(whitePartitions[currentPartition] && blackPartitions[currentPartition])) {
 						// check if reachable neighboring spaces need to be processed
-						size_t spaceRow = getSpaceRow(spaceIndex);
-						size_t spaceCol = getSpaceCol(spaceIndex);
+						size_t spaceRow = getSpaceRow(currentSpace);
+						size_t spaceCol = getSpaceCol(currentSpace);
 						
 						// space row/col coordinates correspond to the same coordinates of the upper-left point on the space
-						if (spaceRow > 0 && spacePartitionNumbers[getSpaceIndex(spaceRow - 1, spaceCol)] == -1
-						                 && !visitedEdges[getEdgeIndex(spaceRow, spaceCol, spaceRow, spaceCol + 1)]) {
-							searchStack[stackSize] = getSpaceIndex(spaceRow - 1, spaceCol);
-							++stackSize;
+						size_t neighbors[4];
+						size_t numNeighbors = 0;
+						if (spaceRow > 0 && visitedEdges[getEdgeIndex(spaceRow, spaceCol, spaceRow, spaceCol + 1)] != generation) {
+							neighbors[numNeighbors++] = getSpaceIndex(spaceRow - 1, spaceCol);
+						}
+						if (spaceRow < getHeight() - 2 && visitedEdges[getEdgeIndex(spaceRow + 1, spaceCol, spaceRow + 1, spaceCol + 1)] != generation) {
+							neighbors[numNeighbors++] = getSpaceIndex(spaceRow + 1, spaceCol);
 						}
-						if (spaceRow < getHeight() - 2 && spacePartitionNumbers[getSpaceIndex(spaceRow + 1, spaceCol)] == -1
-						                               && !visitedEdges[getEdgeIndex(spaceRow + 1, spaceCol, spaceRow + 1, spaceCol + 1)]) {
-							searchStack[stackSize] = getSpaceIndex(spaceRow + 1, spaceCol);
-							++stackSize;
+						if (spaceCol > 0 && visitedEdges[getEdgeIndex(spaceRow, spaceCol, spaceRow + 1, spaceCol)] != generation) {
+							neighbors[numNeighbors++] = getSpaceIndex(spaceRow, spaceCol - 1);
 						}
-						if (spaceCol > 0 && spacePartitionNumbers[getSpaceIndex(spaceRow, spaceCol - 1)] == -1
-						                 && !visitedEdges[getEdgeIndex(spaceRow, spaceCol, spaceRow + 1, spaceCol)]) {
-							searchStack[stackSize] = getSpaceIndex(spaceRow, spaceCol - 1);
-							++stackSize;
+						if (spaceCol < getWidth() - 2 && visitedEdges[getEdgeIndex(spaceRow, spaceCol + 1, spaceRow + 1, spaceCol + 1)] != generation) {
+							neighbors[numNeighbors++] = getSpaceIndex(spaceRow, spaceCol + 1);
 						}
-						if (spaceCol < getWidth() - 2 && spacePartitionNumbers[getSpaceIndex(spaceRow, spaceCol + 1)] == -1
-						                              && !visitedEdges[getEdgeIndex(spaceRow, spaceCol + 1, spaceRow + 1, spaceCol + 1)]) {
-							searchStack[stackSize] = getSpaceIndex(spaceRow, spaceCol + 1);
-							++stackSize;
+						
+						for (size_t i = 0; i < numNeighbors; ++i) {
+							if (assignedSpaces[neighbors[i]] != generation) {
+								assignedSpaces[neighbors[i]] = generation;
+								searchStack[stackSize] = neighbors[i];
+								++stackSize;
+							}
 						}
 					}
 					else {
@@ -370,19 +394,8 @@ namespace gws
 				
 				++currentPartition;
 			}
-			
-			delete [] spacePartitionNumbers;
-			delete [] whitePartitions;
-			delete [] blackPartitions;
-			delete [] searchStack;
 		}
 		
-		// clean up memory
-		delete [] visitedPoints;
-		delete [] visitedEdges;
-		delete [] pointDots;
-		delete [] edgeDots;
-		
 		return validPath;
 	}
 }
@@ -13,6 +13,8 @@
 
 namespace gws
 {
+	class CompiledPuzzle;
+	class EvaluationWorkspace;
 	class Path;
 	
 	///////////////////////////////////////////////////////////////////////////
@@ -199,7 +201,7 @@ namespace gws
 		/// 
 		/// The point at row1/col1 is assumed to be directly above or to the
 		/// left of the point at row2/col2.
-		///
+		/// 
 		/// \param [in] row1 the first point row (in range [0..h-1])
 		/// \param [in] col1 the first point column (in range [0..w-1])
 		/// \param [in] row2 the second point row (in range [0..h-1])
@@ -307,12 +309,40 @@ namespace gws
 		///////////////////////////////////////////////////////////////////////
 		/// \brief Check if a path is a vlid solution to the puzzle
 		/// 
+		/// A temporary workspace is allocated for every call, so callers that
+		/// evaluate many paths should use the overload that takes a workspace.
+		/// 
 		/// \param [in] path the path
 		/// 
 		/// \returns true if the path is a valid solution, false otherwise
 		///////////////////////////////////////////////////////////////////////
 		bool evaluateSolution(const Path& path) const;
 		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a path is a vlid solution to the puzzle without
+		/// allocating any memory
+		/// 
+		/// \param [in] path the path
+		/// \param [in] workspace scratch memory sized for this puzzle (see
+		/// EvaluationWorkspace::canHold())
+		/// 
+		/// \returns true if the path is a valid solution, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool evaluateSolution(const Path& path, EvaluationWorkspace& workspace) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a path is a valid solution to the puzzle, following
+		/// the path through precompiled move tables
+		/// 
+		/// \param [in] path the path
+		/// \param [in] compiled the move tables compiled from this puzzle
+		/// \param [in] workspace scratch memory sized for this puzzle (see
+		/// EvaluationWorkspace::canHold())
+		/// 
+		/// \returns true if the path is a valid solution, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool evaluateSolution(const Path& path, const CompiledPuzzle& compiled, EvaluationWorkspace& workspace) const;
+		
 	private:
 		size_t m_width;
 		size_t m_height;
@@ -322,6 +352,17 @@ namespace gws
 		const char* m_spaceData;
 		
 		mutable size_t m_numEvals;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check the dot and region constraints of a path that has been
+		/// followed to an end point
+		/// 
+		/// \param [in] workspace the workspace holding the visited points and
+		/// edges of the path
+		/// 
+		/// \returns true if every constraint is met, false otherwise
+		///////////////////////////////////////////////////////////////////////
+		bool checkConstraints(EvaluationWorkspace& workspace) const;
 	};
 }
 
@@ -0,0 +1,114 @@
+//////////////////////////////
+// Selection.cpp            //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "Selection.h"
+
+#include "Philox.h"
+
+#include <algorithm>
+
+namespace gws
+{
+	const char* getSelectionMethodName(SelectionMethod method)
+	{
+		const char* name;
+		switch (method) {
+			case SelectionMethod::ALIAS:
+				name = "alias";
+				break;
+			case SelectionMethod::TOURNAMENT:
+				name = "tournament";
+				break;
+			default:
+				name = "roulette";
+				break;
+		}
+		
+		return name;
+	}
+	
+	size_t selectRouletteMember(const uint32_t* fitnessPrefix, size_t first, size_t last, uint32_t draw)
+	{
+		// the prefix sums cover the whole population, so offset the target
+		// by the sum before the range
+		uint32_t base = first > 0 ? fitnessPrefix[first - 1] : 0;
+		uint32_t target = base + (uint32_t)(((uint64_t)draw*(fitnessPrefix[last - 1] - base)) >> 32);
+		
+		return std::upper_bound(fitnessPrefix + first, fitnessPrefix + last, target) - fitnessPrefix;
+	}
+	
+	void buildAliasTable(const int* fitness, size_t popSize, int minFitness, uint32_t totalWeight,
+	                     uint64_t* probabilities, uint32_t* aliases, uint32_t* worklist)
+	{
+		// scale weights by the population size so an average member fills
+		// exactly one column, and sort members into underfull ones (stacked
+		// from the front of the worklist) and full ones (stacked from the
+		// back)
+		size_t numSmall = 0;
+		size_t numLarge = 0;
+		for (size_t i = 0; i < popSize; ++i) {
+			probabilities[i] = (uint64_t)(uint32_t)(fitness[i] - minFitness + 1)*popSize;
+			aliases[i] = (uint32_t)i;
+			if (probabilities[i] < totalWeight) {
+				worklist[numSmall++] = (uint32_t)i;
+			}
+			else {
+				worklist[popSize - 1 - numLarge++] = (uint32_t)i;
+			}
+		}
+		
+		// top up each underfull column with the weight of a full member
+		while (numSmall > 0 && numLarge > 0) {
+			uint32_t small = worklist[--numSmall];
+			uint32_t large = worklist[popSize - numLarge--];
+			aliases[small] = large;
+			probabilities[large] = probabilities[large] + probabilities[small] - totalWeight;
+			if (probabilities[large] < totalWeight) {
+				worklist[numSmall++] = large;
+			}
+			else {
+				worklist[popSize - 1 - numLarge++] = large;
+			}
+		}
+		
+		// remaining columns are exactly full
+		while (numLarge > 0) {
+			probabilities[worklist[popSize - numLarge--]] = totalWeight;
+		}
+		while (numSmall > 0) {
+			probabilities[worklist[--numSmall]] = totalWeight;
+		}
+	}
+	
+	size_t selectAliasMember(const uint64_t* probabilities, const uint32_t* aliases, size_t popSize, uint32_t totalWeight,
+	                         uint32_t columnDraw, uint32_t aliasDraw)
+	{
+		size_t column = (size_t)(((uint64_t)columnDraw*popSize) >> 32);
+		uint64_t target = ((uint64_t)aliasDraw*totalWeight) >> 32;
+		
+		return target < probabilities[column] ? column : aliases[column];
+	}
+	
+	size_t selectTournamentMember(const int* fitness, size_t popSize, size_t tournamentSize,
+	                              uint32_t seed, uint32_t generation, uint32_t member)
+	{
+		size_t winner = 0;
+		uint32_t draws[4];
+		for (size_t i = 0; i < tournamentSize; ++i) {
+			if (i%4 == 0) {
+				generateRandomWords(seed, RandomStream::SELECTION, generation, member, (uint32_t)(i/4), draws);
+			}
+			
+			size_t candidate = (size_t)(((uint64_t)draws[i%4]*popSize) >> 32);
+			if (i == 0 || fitness[candidate] > fitness[winner]) {
+				winner = candidate;
+			}
+		}
+		
+		return winner;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+//////////////////////////////
+// Selection.h              //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_Selection_h
+#define gws_Selection_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace gws
+{
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Methods of selecting a mate for crossover
+	///////////////////////////////////////////////////////////////////////////
+	enum class SelectionMethod : uint32_t
+	{
+		// fitness-proportional: binary search of fitness prefix sums
+		ROULETTE = 0,
+		
+		// fitness-proportional: constant time lookups in a Walker alias table
+		ALIAS,
+		
+		// fittest of a number of uniformly drawn members
+		TOURNAMENT
+	};
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Get the display name of a selection method
+	/// 
+	/// \param [in] method the selection method
+	/// 
+	/// \returns the name (e.g., "roulette")
+	///////////////////////////////////////////////////////////////////////////
+	const char* getSelectionMethodName(SelectionMethod method);
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Select the first member of a range whose fitness prefix sum is
+	/// greater than a random target
+	/// 
+	/// \param [in] fitnessPrefix the prefix sums of the normalized fitness
+	/// \param [in] first the first member of the range
+	/// \param [in] last one past the last member of the range
+	/// \param [in] draw the random word choosing the target
+	/// 
+	/// \returns the selected member
+	///////////////////////////////////////////////////////////////////////////
+	size_t selectRouletteMember(const uint32_t* fitnessPrefix, size_t first, size_t last, uint32_t draw);
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Build a Walker alias table of the normalized fitness values
+	/// 
+	/// Uses Vose's method with integer weights: each column holds the total
+	/// weight, split between the column's own member and its alias. Must
+	/// match the buildAliasTable kernel in GeneticSolver.cl.
+	/// 
+	/// \param [in] fitness the fitness values
+	/// \param [in] popSize the population size
+	/// \param [in] minFitness the minimum fitness value
+	/// \param [in] totalWeight the sum of the normalized fitness values
+	/// \param [out] probabilities the weight of each column's own member
+	/// \param [out] aliases the alias member of each column
+	/// \param [out] worklist scratch space for popSize member indices
+	///////////////////////////////////////////////////////////////////////////
+	void buildAliasTable(const int* fitness, size_t popSize, int minFitness, uint32_t totalWeight,
+	                     uint64_t* probabilities, uint32_t* aliases, uint32_t* worklist);
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Select a member from a Walker alias table
+	/// 
+	/// \param [in] probabilities the weight of each column's own member
+	/// \param [in] aliases the alias member of each column
+	/// \param [in] popSize the population size
+	/// \param [in] totalWeight the sum of the normalized fitness values
+	/// \param [in] columnDraw the random word choosing the column
+	/// \param [in] aliasDraw the random word choosing the member or its alias
+	/// 
+	/// \returns the selected member
+	///////////////////////////////////////////////////////////////////////////
+	size_t selectAliasMember(const uint64_t* probabilities, const uint32_t* aliases, size_t popSize, uint32_t totalWeight,
+	                         uint32_t columnDraw, uint32_t aliasDraw);
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \brief Select the fittest of a number of uniformly drawn members
+	/// 
+	/// Candidates are drawn from the selection random stream (four per
+	/// block), and ties keep the first candidate drawn.
+	/// 
+	/// \param [in] fitness the fitness values
+	/// \param [in] popSize the population size
+	/// \param [in] tournamentSize the number of candidates
+	/// \param [in] seed the random seed
+	/// \param [in] generation the current generation
+	/// \param [in] member the member selecting a mate
+	/// 
+	/// \returns the selected member
+	///////////////////////////////////////////////////////////////////////////
+	size_t selectTournamentMember(const int* fitness, size_t popSize, size_t tournamentSize,
+	                              uint32_t seed, uint32_t generation, uint32_t member);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+//////////////////////////////
+// SolutionWriter.cpp       //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "SolutionWriter.h"
+
+#include "Path.h"
+
+// moves packed into each byte
+#define MOVES_PER_BYTE 4
+
+namespace gws
+{
+	SolutionWriter::SolutionWriter(std::ostream& stream)
+		: m_stream(stream), m_numWritten(0)
+	{}
+	
+	bool SolutionWriter::write(const Path& path)
+	{
+		// encode the whole path first so it takes a single stream write
+		m_buffer.clear();
+		appendVarint(path.getStartPointIndex());
+		appendVarint(path.getNumMoves());
+		
+		unsigned char bits = 0;
+		for (size_t i = 0; i < path.getNumMoves(); ++i) {
+			bits |= encodeMove(path.getMove(i)) << (2*(i%MOVES_PER_BYTE));
+			if (i%MOVES_PER_BYTE == MOVES_PER_BYTE - 1) {
+				m_buffer.push_back((char)bits);
+				bits = 0;
+			}
+		}
+		if (path.getNumMoves()%MOVES_PER_BYTE != 0) {
+			m_buffer.push_back((char)bits);
+		}
+		
+		m_stream.write(m_buffer.data(), m_buffer.size());
+		++m_numWritten;
+		
+		return m_stream.good();
+	}
+	
+	uint64_t SolutionWriter::getNumWritten() const
+	{
+		return m_numWritten;
+	}
+	
+	bool SolutionWriter::read(std::istream& stream, Path& path)
+	{
+		uint64_t startPointIndex;
+		uint64_t numMoves;
+		bool validPath = readVarint(stream, startPointIndex) && readVarint(stream, numMoves) && numMoves <= path.getMaxLength();
+		if (validPath) {
+			path.clear();
+			path.setStartPointIndex(startPointIndex);
+			
+			int bits = 0;
+			for (uint64_t i = 0; validPath && i < numMoves; ++i) {
+				if (i%MOVES_PER_BYTE == 0) {
+					bits = stream.get();
+					validPath = bits != std::istream::traits_type::eof();
+				}
+				path.addMove(decodeMove((bits >> (2*(i%MOVES_PER_BYTE))) & 3));
+			}
+		}
+		
+		return validPath;
+	}
+	
+	void SolutionWriter::appendVarint(uint64_t value)
+	{
+		while (value >= 0x80) {
+			m_buffer.push_back((char)((value & 0x7f) | 0x80));
+			value >>= 7;
+		}
+		m_buffer.push_back((char)value);
+	}
+	
+	bool SolutionWriter::readVarint(std::istream& stream, uint64_t& value)
+	{
+		value = 0;
+		size_t shift = 0;
+		int byte = 0x80;
+		while ((byte & 0x80) != 0 && shift < 64) {
+			byte = stream.get();
+			if (byte == std::istream::traits_type::eof()) {
+				return false;
+			}
+			
+			value |= (uint64_t)(byte & 0x7f) << shift;
+			shift += 7;
+		}
+		
+		return (byte & 0x80) == 0;
+	}
+	
+	unsigned char SolutionWriter::encodeMove(MoveValue move)
+	{
+		unsigned char bits;
+		switch (move) {
+			case MoveValue::UP:
+				bits = 0;
+				break;
+			case MoveValue::DOWN:
+				bits = 1;
+				break;
+			case MoveValue::LEFT:
+				bits = 2;
+				break;
+			default:
+				bits = 3;
+				break;
+		}
+		
+		return bits;
+	}
+	
+	MoveValue SolutionWriter::decodeMove(unsigned char bits)
+	{
+		const MoveValue moves[] = { MoveValue::UP, MoveValue::DOWN, MoveValue::LEFT, MoveValue::RIGHT };
+		
+		return moves[bits & 3];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+//////////////////////////////
+// SolutionWriter.h         //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_SolutionWriter_h
+#define gws_SolutionWriter_h
+
+#include <istream>
+#include <ostream>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace gws
+{
+	class Path;
+	enum class MoveValue : char;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \class SolutionWriter
+	/// \brief Writes solution paths to a binary stream in a compact encoding
+	/// 
+	/// Each path is written as its start point index and number of moves
+	/// (both as variable-length integers, 7 bits per byte with the high bit
+	/// set on every byte but the last), followed by the moves packed 2 bits
+	/// each, 4 per byte, starting at the low bits. A 7x7 puzzle solution
+	/// takes at most 14 bytes. Paths are written as they are received, so
+	/// nothing is kept in memory between writes.
+	///////////////////////////////////////////////////////////////////////////
+	class SolutionWriter
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Initialize the writer
+		/// 
+		/// \param [in] stream the binary output stream
+		///////////////////////////////////////////////////////////////////////
+		explicit SolutionWriter(std::ostream& stream);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Write a path to the stream
+		/// 
+		/// \param [in] path the path
+		/// 
+		/// \returns true if the stream is still good after writing
+		///////////////////////////////////////////////////////////////////////
+		bool write(const Path& path);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of paths written so far
+		/// 
+		/// \returns the number of paths
+		///////////////////////////////////////////////////////////////////////
+		uint64_t getNumWritten() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Read the next path written by a SolutionWriter
+		/// 
+		/// \param [in] stream the binary input stream
+		/// \param [out] path the path (must be long enough for the moves)
+		/// 
+		/// \returns true if a path was read, false at the end of the stream
+		/// or if the path doesn't fit
+		///////////////////////////////////////////////////////////////////////
+		static bool read(std::istream& stream, Path& path);
+		
+	private:
+		std::ostream& m_stream;
+		uint64_t m_numWritten;
+		
+		// reused encoding buffer for one path
+		std::vector<char> m_buffer;
+		
+		void appendVarint(uint64_t value);
+		static bool readVarint(std::istream& stream, uint64_t& value);
+		
+		static unsigned char encodeMove(MoveValue move);
+		static MoveValue decodeMove(unsigned char bits);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,171 @@
+//////////////////////////////
+// TranspositionTable.cpp   //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#include "TranspositionTable.h"
+
+#include "Puzzle.h"
+
+#include <random>
+
+// fixed seed so that searches are reproducible
+#define ZOBRIST_SEED 0x5eed5eed5eed5eedULL
+
+namespace gws
+{
+	TranspositionTable::TranspositionTable(size_t maxBytes, ReplacementPolicy policy)
+		: m_policy(policy), m_hasTranspositions(false), m_bucketMask(0), m_numHits(0), m_numStores(0)
+	{
+		// use the largest power-of-two bucket count that fits in the limit
+		// (with at least one bucket)
+		size_t bucketBytes = sizeof(Entry)*ENTRIES_PER_BUCKET;
+		size_t numBuckets = 1;
+		while (numBuckets*2*bucketBytes <= maxBytes) {
+			numBuckets *= 2;
+		}
+		
+		m_bucketMask = numBuckets - 1;
+		m_entries.resize(numBuckets*ENTRIES_PER_BUCKET);
+		clear();
+	}
+	
+	void TranspositionTable::reset(const Puzzle& puzzle)
+	{
+		// regions can only be invalid if both mark colors are present
+		bool hasWhite = false;
+		bool hasBlack = false;
+		for (size_t i = 0; i < puzzle.getNumSpaces(); ++i) {
+			hasWhite = hasWhite || puzzle.getSpaceValue(i) == SpaceValue::WHITE;
+			hasBlack = hasBlack || puzzle.getSpaceValue(i) == SpaceValue::BLACK;
+		}
+		
+		std::mt19937_64 generator(ZOBRIST_SEED);
+		
+		m_pointKeys.resize(puzzle.getNumPoints());
+		m_headKeys.resize(puzzle.getNumPoints());
+		for (size_t i = 0; i < puzzle.getNumPoints(); ++i) {
+			m_pointKeys[i] = generator();
+			m_headKeys[i] = generator();
+		}
+		
+		m_hasTranspositions = !(hasWhite && hasBlack);
+		m_edgeKeys.resize(puzzle.getNumEdges());
+		for (size_t i = 0; i < puzzle.getNumEdges(); ++i) {
+			uint64_t key = generator();
+			m_edgeKeys[i] = (hasWhite && hasBlack) || puzzle.getEdgeValue(i) == EdgeValue::DOT ? key : 0;
+		}
+		
+		clear();
+	}
+	
+	bool TranspositionTable::canHold(const Puzzle& puzzle) const
+	{
+		return puzzle.getNumPoints() <= m_pointKeys.size()
+		    && puzzle.getNumEdges() <= m_edgeKeys.size();
+	}
+	
+	bool TranspositionTable::hasTranspositions() const
+	{
+		return m_hasTranspositions;
+	}
+	
+	void TranspositionTable::clear()
+	{
+		for (size_t i = 0; i < m_entries.size(); ++i) {
+			m_entries[i].hash = 0;
+			m_entries[i].work = 0;
+		}
+		
+		m_numHits = 0;
+		m_numStores = 0;
+	}
+	
+	uint64_t TranspositionTable::getPointKey(size_t index) const
+	{
+		return m_pointKeys[index];
+	}
+	
+	uint64_t TranspositionTable::getHeadKey(size_t index) const
+	{
+		return m_headKeys[index];
+	}
+	
+	uint64_t TranspositionTable::getEdgeKey(size_t index) const
+	{
+		return m_edgeKeys[index];
+	}
+	
+	bool TranspositionTable::contains(uint64_t hash)
+	{
+		// 0 marks empty entries, so it can't be stored as is
+		if (hash == 0) {
+			hash = 1;
+		}
+		
+		Entry* bucket = &m_entries[(hash & m_bucketMask)*ENTRIES_PER_BUCKET];
+		bool found = false;
+		for (size_t i = 0; !found && i < ENTRIES_PER_BUCKET; ++i) {
+			found = bucket[i].hash == hash;
+		}
+		
+		if (found) {
+			++m_numHits;
+		}
+		
+		return found;
+	}
+	
+	void TranspositionTable::store(uint64_t hash, size_t work)
+	{
+		if (hash == 0) {
+			hash = 1;
+		}
+		
+		Entry* bucket = &m_entries[(hash & m_bucketMask)*ENTRIES_PER_BUCKET];
+		uint32_t clampedWork = work < UINT32_MAX ? (uint32_t)work : UINT32_MAX;
+		
+		// pick the entry to overwrite
+		size_t slot = 0;
+		switch (m_policy) {
+			case ReplacementPolicy::ALWAYS_REPLACE:
+				// shift older entries back and evict the oldest
+				for (size_t i = ENTRIES_PER_BUCKET - 1; i > 0; --i) {
+					bucket[i] = bucket[i - 1];
+				}
+				slot = 0;
+				break;
+			case ReplacementPolicy::PREFER_LARGER:
+				// evict the entry that took the least work to prove
+				for (size_t i = 1; i < ENTRIES_PER_BUCKET; ++i) {
+					if (bucket[i].work < bucket[slot].work) {
+						slot = i;
+					}
+				}
+				break;
+			default:
+				break;
+		}
+		
+		bucket[slot].hash = hash;
+		bucket[slot].work = clampedWork;
+		++m_numStores;
+	}
+	
+	size_t TranspositionTable::getCapacity() const
+	{
+		return m_entries.size();
+	}
+	
+	size_t TranspositionTable::getNumHits() const
+	{
+		return m_numHits;
+	}
+	
+	size_t TranspositionTable::getNumStores() const
+	{
+		return m_numStores;
+	}
+}
\ No newline at end of file
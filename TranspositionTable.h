@@ -0,0 +1,180 @@
+//////////////////////////////
+// TranspositionTable.h     //
+// Andrew Krepps            //
+// EN.605.417 Final Project //
+// 15 May 2018              //
+//////////////////////////////
+
+#ifndef gws_TranspositionTable_h
+#define gws_TranspositionTable_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace gws
+{
+	class Puzzle;
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \enum ReplacementPolicy
+	/// \brief How a full transposition table bucket makes room for a new entry
+	///////////////////////////////////////////////////////////////////////////
+	enum class ReplacementPolicy : char
+	{
+		ALWAYS_REPLACE = 'a',   ///< evict the oldest entry in the bucket
+		PREFER_LARGER = 'l'     ///< evict the entry with the smallest subtree
+	};
+	
+	///////////////////////////////////////////////////////////////////////////
+	/// \class TranspositionTable
+	/// \brief Bounded hash table of search states known to have no solution
+	/// 
+	/// States are identified by a Zobrist hash: the XOR of a random key for
+	/// the head of the path, each visited point and each traversed edge that
+	/// matters for the puzzle's constraints. The table stores only the 64-bit
+	/// hash of each state, so memory use is fixed by the byte limit and
+	/// independent of the puzzle size. Entries are grouped into buckets of
+	/// two, and the replacement policy decides which one is evicted.
+	///////////////////////////////////////////////////////////////////////////
+	class TranspositionTable
+	{
+	public:
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Allocate a table
+		/// 
+		/// \param [in] maxBytes the memory limit for table entries (the table
+		/// is rounded down to a power-of-two number of buckets)
+		/// \param [in] policy the replacement policy
+		///////////////////////////////////////////////////////////////////////
+		TranspositionTable(size_t maxBytes, ReplacementPolicy policy);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Generate Zobrist keys for a puzzle and clear the table
+		/// 
+		/// Edges only contribute to the hash if they affect whether the path
+		/// can still be completed: dot edges always do, and every edge does
+		/// if the puzzle has both white and black marks.
+		/// 
+		/// \param [in] puzzle the puzzle
+		///////////////////////////////////////////////////////////////////////
+		void reset(const Puzzle& puzzle);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if the table has keys for every element of a puzzle
+		/// 
+		/// \param [in] puzzle the puzzle
+		/// 
+		/// \returns true if states of the puzzle can be hashed
+		///////////////////////////////////////////////////////////////////////
+		bool canHold(const Puzzle& puzzle) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if two different paths can hash to the same state
+		/// 
+		/// If every edge is part of the state, a state can only be reached by
+		/// a single path (its start point and edge set determine it), so the
+		/// table would never be hit.
+		/// 
+		/// \returns true if the table can be useful for the current puzzle
+		///////////////////////////////////////////////////////////////////////
+		bool hasTranspositions() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Remove all entries from the table
+		///////////////////////////////////////////////////////////////////////
+		void clear();
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the Zobrist key of a visited point
+		/// 
+		/// \param [in] index the point index
+		/// 
+		/// \returns the key
+		///////////////////////////////////////////////////////////////////////
+		uint64_t getPointKey(size_t index) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the Zobrist key of the head of the path
+		/// 
+		/// \param [in] index the point index
+		/// 
+		/// \returns the key
+		///////////////////////////////////////////////////////////////////////
+		uint64_t getHeadKey(size_t index) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the Zobrist key of a traversed edge
+		/// 
+		/// \param [in] index the edge index
+		/// 
+		/// \returns the key (0 if the edge doesn't affect the search)
+		///////////////////////////////////////////////////////////////////////
+		uint64_t getEdgeKey(size_t index) const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Check if a state is known to have no solution
+		/// 
+		/// \param [in] hash the state hash
+		/// 
+		/// \returns true if the state is in the table
+		///////////////////////////////////////////////////////////////////////
+		bool contains(uint64_t hash);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Record a state that has no solution
+		/// 
+		/// \param [in] hash the state hash
+		/// \param [in] work the number of nodes searched to prove it
+		///////////////////////////////////////////////////////////////////////
+		void store(uint64_t hash, size_t work);
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of entries the table can hold
+		/// 
+		/// \returns the table capacity
+		///////////////////////////////////////////////////////////////////////
+		size_t getCapacity() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of successful lookups since the last reset
+		/// 
+		/// \returns the number of hits
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumHits() const;
+		
+		///////////////////////////////////////////////////////////////////////
+		/// \brief Get the number of stored states since the last reset
+		/// 
+		/// \returns the number of stores
+		///////////////////////////////////////////////////////////////////////
+		size_t getNumStores() const;
+		
+	private:
+		///////////////////////////////////////////////////////////////////////
+		/// \struct Entry
+		/// \brief A stored state (a hash of 0 marks an empty entry)
+		///////////////////////////////////////////////////////////////////////
+		struct Entry
+		{
+			uint64_t hash;
+			uint32_t work;
+		};
+		
+		static const size_t ENTRIES_PER_BUCKET = 2;
+		
+		ReplacementPolicy m_policy;
+		bool m_hasTranspositions;
+		size_t m_bucketMask;
+		std::vector<Entry> m_entries;
+		
+		std::vector<uint64_t> m_pointKeys;
+		std::vector<uint64_t> m_headKeys;
+		std::vector<uint64_t> m_edgeKeys;
+		
+		size_t m_numHits;
+		size_t m_numStores;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -5,15 +5,23 @@
 // 15 May 2018              //
 //////////////////////////////
 
+#include "BidirectionalSolver.h"
+#ifndef NO_OPENCL
 #include "GeneticSolver.h"
+#endif
+#include "HostGeneticSolver.h"
 #include "HostSolver.h"
+#include "ParallelHostSolver.h"
 #include "Path.h"
 #include "Puzzle.h"
 #include "PuzzleReader.h"
+#include "SolutionWriter.h"
 #include "Solver.h"
 
 #include <chrono>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
 #define POPULATION_SIZE 8192
@@ -22,6 +30,37 @@
 #define MUTATION_RATE 0.1
 #define RANDOM_SEED 0
 
+// crossover mate selection (roulette, alias or tournament) and the number of
+// candidates drawn for tournament selection
+#define SELECTION_METHOD gws::SelectionMethod::ROULETTE
+#define TOURNAMENT_SIZE 4
+
+// island model: the population is split into islands that exchange their
+// fittest members every migration interval (one island evolves a single
+// population)
+#define NUM_ISLANDS 1
+#define MIGRATION_INTERVAL 50
+#define NUM_MIGRANTS 4
+#define MIGRATION_TOPOLOGY gws::MigrationTopology::RING
+
+// compile the GPU evaluation kernel with the puzzle dimensions as constants
+#define SPECIALIZE_EVALUATION false
+
+// layout of the population in GPU memory (interleaving members can make the
+// kernels' accesses coalesce)
+#define POPULATION_LAYOUT gws::PopulationLayout::MEMBER_MAJOR
+
+// largest puzzle (in number of points) the host solver will attempt
+#define MAX_HOST_POINTS 64
+
+// largest puzzle (in number of points) the bidirectional solver will attempt
+// and the memory limit for the half paths it stores
+#define MAX_BIDIRECTIONAL_POINTS 80
+#define HALF_PATH_BYTES (256*1024*1024)
+
+// memory limit for each host solver's dead state transposition table
+#define TRANSPOSITION_TABLE_BYTES (64*1024*1024)
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief Run a puzzle solver and display the result and timing metrics
 /// 
@@ -55,11 +94,15 @@ bool runSolver(gws::Solver* solver, const std::string& name, const gws::Puzzle&
 
 int main(int argc, char** argv)
 {
-	// configure run
+	// configure run (all solutions are written to the optional solution file)
 	std::string puzzleFile = "data/test.txt";
+	std::string solutionFile;
 	if (argc > 1) {
 		puzzleFile = argv[1];
 	}
+	if (argc > 2) {
+		solutionFile = argv[2];
+	}
 	
 	char* pointData;
 	char* edgeData;
@@ -75,23 +118,114 @@ int main(int argc, char** argv)
 	
 	// solve puzzle and display timing metrics
 	gws::HostSolver* hostSolver = new gws::HostSolver();
-	if (puzzle.getWidth() < 7 || puzzle.getHeight() < 7) {
+	gws::HostSolver* bitboardSolver = new gws::HostSolver(true, true);
+	gws::ParallelHostSolver* parallelHostSolver = new gws::ParallelHostSolver();
+	hostSolver->setTranspositionTable(TRANSPOSITION_TABLE_BYTES);
+	hostSolver->setReachabilityPruning(true);
+	bitboardSolver->setReachabilityPruning(true);
+	parallelHostSolver->setReachabilityPruning(true);
+	if (puzzle.getNumPoints() <= MAX_HOST_POINTS) {
 		runSolver(hostSolver, "CPU", puzzle, path);
 		std::cout << "CPU solution evaluations: " << puzzle.getNumEvals() << std::endl;
+		std::cout << "CPU search nodes: " << hostSolver->getNumNodes() << std::endl;
+		std::cout << "CPU dead states skipped: " << hostSolver->getNumTableHits() << std::endl;
+		std::cout << "CPU reachability prunes: " << hostSolver->getNumReachabilityPrunes() << std::endl;
+		
+		runSolver(bitboardSolver, "CPU (bitboard)", puzzle, path);
+		std::cout << "CPU (bitboard) search nodes: " << bitboardSolver->getNumNodes() << std::endl;
+		std::cout << "CPU (bitboard) reachability prunes: " << bitboardSolver->getNumReachabilityPrunes() << std::endl;
+		
+		runSolver(parallelHostSolver, "CPU (parallel)", puzzle, path);
+		std::cout << "CPU (parallel) search tasks: " << parallelHostSolver->getNumTasks() << std::endl;
+		std::cout << "CPU (parallel) search nodes: " << parallelHostSolver->getNumNodes() << std::endl;
+		
+		if (!solutionFile.empty()) {
+			std::cout << std::endl;
+			std::cout << "CPU (parallel) solution count: " << parallelHostSolver->countSolutions(puzzle) << std::endl;
+			
+			std::ofstream solutionStream(solutionFile.c_str(), std::ios::binary);
+			gws::SolutionWriter writer(solutionStream);
+			bitboardSolver->enumerateSolutions(puzzle, path, [&writer](const gws::Path& solution) { return writer.write(solution); });
+			std::cout << "Wrote " << writer.getNumWritten() << " solutions to " << solutionFile << std::endl;
+		}
 	}
 	else {
 		std::cout << "Puzzle is too large to solve on host" << std::endl;
+		if (!solutionFile.empty()) {
+			std::cout << "Skipped writing solutions to " << solutionFile << " (puzzle has more than " << MAX_HOST_POINTS << " points)" << std::endl;
+		}
+	}
+	
+	gws::BidirectionalSolver* bidirectionalSolver = new gws::BidirectionalSolver(HALF_PATH_BYTES);
+	if (puzzle.getNumPoints() <= MAX_BIDIRECTIONAL_POINTS) {
+		runSolver(bidirectionalSolver, "CPU (bidirectional)", puzzle, path);
+		std::cout << "CPU (bidirectional) search nodes: " << bidirectionalSolver->getNumNodes() << std::endl;
+		std::cout << "CPU (bidirectional) joined paths: " << bidirectionalSolver->getNumJoins() << std::endl;
+		if (bidirectionalSolver->usedFallback()) {
+			std::cout << "CPU (bidirectional) exceeded half path limit and searched in one direction" << std::endl;
+		}
 	}
 	std::cout << std::endl;
 	
-	gws::GeneticSolver* gpuSolver = new gws::GeneticSolver(puzzle.getWidth(), puzzle.getHeight(), POPULATION_SIZE,
-	                                                       MAX_ITERATIONS, CROSSOVER_RATE, MUTATION_RATE, RANDOM_SEED);
-	runSolver(gpuSolver, "GPU", puzzle, path);
-	std::cout << "GPU population generations: " << gpuSolver->getNumIterations() << std::endl;
+	// run the genetic algorithm on the host if no OpenCL device is available
+	// (or if the program is built without OpenCL)
+#ifndef NO_OPENCL
+	gws::GeneticSolver* gpuSolver = nullptr;
+	try {
+		gpuSolver = new gws::GeneticSolver(puzzle.getWidth(), puzzle.getHeight(), POPULATION_SIZE,
+		                                   MAX_ITERATIONS, CROSSOVER_RATE, MUTATION_RATE, RANDOM_SEED,
+		                                   POPULATION_LAYOUT);
+	}
+	catch (const std::runtime_error& e) {
+		std::cout << "GPU unavailable, running genetic algorithm on host: " << e.what() << std::endl;
+	}
+#else
+	std::cout << "Built without OpenCL, running genetic algorithm on host" << std::endl;
+#endif
+	
+	gws::HostGeneticSolver* hostGeneticSolver = new gws::HostGeneticSolver(POPULATION_SIZE, MAX_ITERATIONS, CROSSOVER_RATE,
+	                                                                       MUTATION_RATE, RANDOM_SEED);
+	hostGeneticSolver->setSelectionMethod(SELECTION_METHOD);
+	hostGeneticSolver->setTournamentSize(TOURNAMENT_SIZE);
+	hostGeneticSolver->setIslandModel(NUM_ISLANDS, MIGRATION_INTERVAL, NUM_MIGRANTS, MIGRATION_TOPOLOGY);
+	std::cout << "Genetic algorithm selection: " << gws::getSelectionMethodName(SELECTION_METHOD) << std::endl;
+#ifndef NO_OPENCL
+	if (gpuSolver != nullptr) {
+		gpuSolver->setSelectionMethod(SELECTION_METHOD);
+		gpuSolver->setTournamentSize(TOURNAMENT_SIZE);
+		gpuSolver->setIslandModel(NUM_ISLANDS, MIGRATION_INTERVAL, NUM_MIGRANTS, MIGRATION_TOPOLOGY);
+		gpuSolver->setSpecializedEvaluation(SPECIALIZE_EVALUATION);
+		runSolver(gpuSolver, "GPU", puzzle, path);
+		size_t numGenerations = gpuSolver->getNumIterations();
+		std::cout << "GPU devices evaluating the population: " << gpuSolver->getNumDevices() << std::endl;
+		std::cout << "GPU evaluation work group size: " << gpuSolver->getEvaluateWorkSize() << std::endl;
+		std::cout << "GPU population generations: " << numGenerations << std::endl;
+		if (numGenerations > 0) {
+			std::cout << "GPU average generation time: " << gpuSolver->getGenerationTime()/numGenerations << " ms" << std::endl;
+			std::cout << "GPU average selection time: " << gpuSolver->getSelectionTime()/numGenerations << " ms" << std::endl;
+		}
+	}
+	else
+#endif
+	{
+		runSolver(hostGeneticSolver, "CPU (genetic)", puzzle, path);
+		size_t numGenerations = hostGeneticSolver->getNumIterations();
+		std::cout << "CPU (genetic) population generations: " << numGenerations << std::endl;
+		if (numGenerations > 0) {
+			std::cout << "CPU (genetic) average generation time: " << hostGeneticSolver->getGenerationTime()/numGenerations << " ms" << std::endl;
+			std::cout << "CPU (genetic) average selection time: " << hostGeneticSolver->getSelectionTime()/numGenerations << " ms" << std::endl;
+		}
+	}
 	
 	// clean up memory
 	delete hostSolver;
+	delete bitboardSolver;
+	delete parallelHostSolver;
+	delete bidirectionalSolver;
+#ifndef NO_OPENCL
 	delete gpuSolver;
+#endif
+	delete hostGeneticSolver;
 	
 	delete [] pointData;
 	delete [] edgeData;